@@ -360,7 +360,8 @@ struct _GstDashDemuxClockDrift
 typedef struct
 {
   guint64 start_offset, end_offset;
-  /* TODO: Timestamp and duration */
+  /* position relative to the start of the fragment */
+  GstClockTime timestamp;
 } GstDashStreamSyncSample;
 
 /* GObject */
@@ -379,6 +380,9 @@ static gboolean gst_dash_demux_process_manifest (GstAdaptiveDemux * ademux,
 static gboolean gst_dash_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek);
 static GstFlowReturn
 gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream);
+static GstFlowReturn
+gst_dash_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment);
 static GstFlowReturn gst_dash_demux_stream_seek (GstAdaptiveDemuxStream *
     stream, gboolean forward, GstSeekFlags flags, GstClockTime ts,
     GstClockTime * final_ts);
@@ -390,6 +394,8 @@ static gboolean
 gst_dash_demux_stream_advance_subfragment (GstAdaptiveDemuxStream * stream);
 static gboolean gst_dash_demux_stream_select_bitrate (GstAdaptiveDemuxStream *
     stream, guint64 bitrate);
+static guint64 *gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, guint * n_bitrates, guint * current);
 static gint64 gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux *
     demux);
 static GstFlowReturn gst_dash_demux_update_manifest_data (GstAdaptiveDemux *
@@ -635,8 +641,12 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
   gstadaptivedemux_class->stream_seek = gst_dash_demux_stream_seek;
   gstadaptivedemux_class->stream_select_bitrate =
       gst_dash_demux_stream_select_bitrate;
+  gstadaptivedemux_class->stream_get_bitrates =
+      gst_dash_demux_stream_get_bitrates;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_dash_demux_stream_update_fragment_info;
+  gstadaptivedemux_class->stream_peek_fragment =
+      gst_dash_demux_stream_peek_fragment;
   gstadaptivedemux_class->stream_free = gst_dash_demux_stream_free;
   gstadaptivedemux_class->get_live_seek_range =
       gst_dash_demux_get_live_seek_range;
@@ -1302,13 +1312,18 @@ gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
 
     dashstream->current_fragment_keyframe_distance =
         fragment.duration / dashstream->moof_sync_samples->len;
-    dashstream->actual_position =
-        fragment.timestamp +
-        dashstream->current_sync_sample *
-        dashstream->current_fragment_keyframe_distance;
-    if (stream->segment.rate < 0.0)
-      dashstream->actual_position +=
-          dashstream->current_fragment_keyframe_distance;
+    dashstream->actual_position = fragment.timestamp + sync_sample->timestamp;
+    if (stream->segment.rate < 0.0) {
+      /* up to the next keyframe, or the end of the fragment */
+      if (dashstream->current_sync_sample + 1 <
+          dashstream->moof_sync_samples->len)
+        dashstream->actual_position =
+            fragment.timestamp + g_array_index (dashstream->moof_sync_samples,
+            GstDashStreamSyncSample,
+            dashstream->current_sync_sample + 1).timestamp;
+      else
+        dashstream->actual_position = fragment.timestamp + fragment.duration;
+    }
     dashstream->actual_position =
         MIN (dashstream->actual_position,
         fragment.timestamp + fragment.duration);
@@ -1377,6 +1392,54 @@ gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_EOS;
 }
 
+static GstFlowReturn
+gst_dash_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (stream->demux);
+  GstActiveStream *active_stream = dashstream->active_stream;
+  gboolean forward = stream->demux->segment.rate > 0.0;
+  GstMediaFragmentInfo info;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint segment_index;
+  guint segment_repeat_index;
+
+  /* subfragments and trick mode samples are only known once the index or
+   * the moof of the current fragment has been parsed */
+  if (gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client)
+      || (dashstream->moof_sync_samples
+          && GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (dashdemux)))
+    return GST_FLOW_EOS;
+
+  segment_index = active_stream->segment_index;
+  segment_repeat_index = active_stream->segment_repeat_index;
+
+  while (ret == GST_FLOW_OK && n-- > 0)
+    ret = gst_mpd_client_advance_segment (dashdemux->client, active_stream,
+        forward);
+
+  if (ret == GST_FLOW_OK) {
+    if (gst_mpd_client_get_next_fragment (dashdemux->client, dashstream->index,
+            &info)) {
+      fragment->uri = info.uri;
+      info.uri = NULL;
+      fragment->timestamp = info.timestamp;
+      fragment->duration = info.duration;
+      fragment->range_start = info.range_start;
+      fragment->range_end = info.range_end;
+      gst_media_fragment_info_clear (&info);
+    } else {
+      ret = GST_FLOW_EOS;
+    }
+  }
+
+  active_stream->segment_index = segment_index;
+  active_stream->segment_repeat_index = segment_repeat_index;
+
+  return ret;
+}
+
 static gint
 gst_dash_demux_index_entry_search (GstSidxBoxEntry * entry, GstClockTime * ts,
     gpointer user_data)
@@ -1579,6 +1642,39 @@ gst_dash_demux_stream_has_next_subfragment (GstAdaptiveDemuxStream * stream)
   return FALSE;
 }
 
+/* Returns the index of the last sync sample of the current moof at or before
+ * @ts, or the number of sync samples if @ts is after the fragment. In reverse
+ * playback the end of the fragment still belongs to it. */
+static guint
+gst_dash_demux_stream_find_sync_sample (GstDashDemuxStream * dashstream,
+    GstClockTime ts)
+{
+  GstAdaptiveDemuxStream *stream = (GstAdaptiveDemuxStream *) dashstream;
+  GArray *sync_samples = dashstream->moof_sync_samples;
+  GstClockTime offset, end;
+  guint lo = 0, hi = sync_samples->len;
+
+  end = dashstream->current_fragment_timestamp +
+      dashstream->current_fragment_duration;
+  if (stream->demux->segment.rate > 0.0 ? ts >= end : ts > end)
+    return sync_samples->len;
+
+  offset = ts > dashstream->current_fragment_timestamp ?
+      ts - dashstream->current_fragment_timestamp : 0;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (sync_samples, GstDashStreamSyncSample,
+            mid).timestamp > offset)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo > 0 ? lo - 1 : 0;
+}
+
 static gboolean
 gst_dash_demux_stream_advance_sync_sample (GstAdaptiveDemuxStream * stream,
     GstClockTime target_time)
@@ -1600,33 +1696,20 @@ gst_dash_demux_stream_advance_sync_sample (GstAdaptiveDemuxStream * stream,
         GST_TIME_ARGS (stream->fragment.duration));
 
     if (stream->demux->segment.rate > 0.0) {
-      idx =
-          (target_time -
-          dashstream->current_fragment_timestamp) /
-          dashstream->current_fragment_keyframe_distance;
+      idx = gst_dash_demux_stream_find_sync_sample (dashstream, target_time);
 
       /* Prevent getting stuck in a loop due to rounding errors */
       if (idx == dashstream->current_sync_sample)
         idx++;
     } else {
-      GstClockTime end_time =
-          dashstream->current_fragment_timestamp +
-          dashstream->current_fragment_duration;
-
-      if (end_time < target_time) {
-        idx = dashstream->moof_sync_samples->len;
-      } else {
-        idx =
-            (end_time -
-            target_time) / dashstream->current_fragment_keyframe_distance;
-        if (idx == dashstream->moof_sync_samples->len) {
-          dashstream->current_sync_sample = -1;
-          fragment_finished = TRUE;
-          goto beach;
-        }
-        idx = dashstream->moof_sync_samples->len - 1 - idx;
+      if (target_time < dashstream->current_fragment_timestamp) {
+        dashstream->current_sync_sample = -1;
+        fragment_finished = TRUE;
+        goto beach;
       }
 
+      idx = gst_dash_demux_stream_find_sync_sample (dashstream, target_time);
+
       /* Prevent getting stuck in a loop due to rounding errors */
       if (idx == dashstream->current_sync_sample) {
         if (idx == 0) {
@@ -2281,6 +2364,55 @@ end:
   return ret;
 }
 
+static gint
+gst_dash_demux_compare_bitrates (gconstpointer a, gconstpointer b)
+{
+  guint64 bitrate_a = *(const guint64 *) a;
+  guint64 bitrate_b = *(const guint64 *) b;
+
+  return bitrate_a < bitrate_b ? -1 : (bitrate_a > bitrate_b ? 1 : 0);
+}
+
+static guint64 *
+gst_dash_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates, guint * current)
+{
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstActiveStream *active_stream = dashstream->active_stream;
+  guint64 *bitrates;
+  GList *l;
+  guint i = 0;
+
+  *n_bitrates = 0;
+  *current = 0;
+
+  if (active_stream == NULL || active_stream->cur_adapt_set == NULL)
+    return NULL;
+
+  bitrates = g_new (guint64,
+      g_list_length (active_stream->cur_adapt_set->Representations));
+  for (l = active_stream->cur_adapt_set->Representations; l; l = l->next) {
+    GstRepresentationNode *rep = l->data;
+
+    bitrates[i++] = rep->bandwidth;
+  }
+
+  /* representations can be listed in any order */
+  qsort (bitrates, i, sizeof (guint64), gst_dash_demux_compare_bitrates);
+  *n_bitrates = i;
+
+  if (active_stream->cur_representation) {
+    for (i = 0; i < *n_bitrates; i++) {
+      if (bitrates[i] == active_stream->cur_representation->bandwidth) {
+        *current = i;
+        break;
+      }
+    }
+  }
+
+  return bitrates;
+}
+
 #define SEEK_UPDATES_PLAY_POSITION(r, start_type, stop_type) \
   ((r >= 0 && start_type != GST_SEEK_TYPE_NONE) || \
    (r < 0 && stop_type != GST_SEEK_TYPE_NONE))
@@ -2396,17 +2528,30 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (demux);
   GstMpdClient *new_client = NULL;
   GstMapInfo mapinfo;
+  gboolean parsed;
 
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
-  /* parse the manifest file */
+  /* parse the manifest file. Every update is parsed in full, only
+   * merging it into the active streams is incremental */
   new_client = gst_mpd_client_new ();
   gst_mpd_client_set_uri_downloader (new_client, demux->downloader);
   new_client->mpd_uri = g_strdup (demux->manifest_uri);
   new_client->mpd_base_uri = g_strdup (demux->manifest_base_uri);
   gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
 
-  if (gst_mpd_parse (new_client, (gchar *) mapinfo.data, mapinfo.size)) {
+  parsed = gst_mpd_parse (new_client, (gchar *) mapinfo.data, mapinfo.size);
+
+  if (parsed && gst_mpd_client_update_timelines (dashdemux->client,
+          new_client)) {
+    /* same streams as before, only their timelines were updated */
+    gst_mpd_client_free (new_client);
+
+    GST_DEBUG_OBJECT (demux, "Manifest timelines successfully updated");
+    if (dashdemux->clock_drift) {
+      gst_dash_demux_poll_clock_drift (dashdemux);
+    }
+  } else if (parsed) {
     const gchar *period_id;
     guint period_idx;
     GList *iter;
@@ -2548,6 +2693,19 @@ gst_dash_demux_stream_get_fragment_waiting_time (GstAdaptiveDemuxStream *
         segmentAvailability);
     gst_date_time_unref (segmentAvailability);
     gst_date_time_unref (cur_time);
+
+    /* in low-latency mode, the segment is requested as soon as its first
+     * chunks are announced and then received as it is produced */
+    if (gst_adaptive_demux_is_low_latency (stream->demux)) {
+      GstClockTime offset =
+          gst_mpd_client_get_availability_time_offset (dashdemux->client,
+          active_stream);
+
+      if (!GST_CLOCK_TIME_IS_VALID (offset))
+        return 0;
+      diff -= offset;
+    }
+
     /* subtract the server's clock drift, so that if the server's
        time is behind our idea of UTC, we need to sleep for longer
        before requesting a fragment */
@@ -3030,7 +3188,9 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
   guint i;
   guint32 track_id = 0;
   guint64 prev_traf_end;
+  guint64 fragment_time = 0;
   gboolean trex_sample_flags = FALSE;
+  gboolean trex_sample_durations = FALSE;
 
   if (!dash_stream->moof) {
     dashdemux->allow_trickmode_key_units = FALSE;
@@ -3086,13 +3246,20 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
       for (k = 0; k < trun->samples->len; k++) {
         GstTrunSample *sample =
             &g_array_index (trun->samples, GstTrunSample, k);
-        guint64 sample_offset;
+        guint64 sample_offset, sample_time;
         guint32 sample_flags;
-#if 0
-        guint32 sample_duration;
-#endif
 
         sample_offset = prev_sample_end;
+        sample_time = fragment_time;
+
+        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT) {
+          fragment_time += sample->sample_duration;
+        } else if (traf->
+            tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT) {
+          fragment_time += traf->tfhd.default_sample_duration;
+        } else {
+          trex_sample_durations = TRUE;
+        }
 
         if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) {
           sample_flags = sample->sample_flags;
@@ -3107,21 +3274,6 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
           continue;
         }
 
-#if 0
-        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT) {
-          sample_duration = sample->sample_duration;
-        } else if (traf->
-            tfhd.flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT) {
-          sample_duration = traf->tfhd.default_sample_duration;
-        } else {
-          GST_FIXME_OBJECT (stream->pad,
-              "Sample duration given by trex - can't download only keyframes");
-          g_array_free (dash_stream->moof_sync_samples, TRUE);
-          dash_stream->moof_sync_samples = NULL;
-          return FALSE;
-        }
-#endif
-
         if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) {
           prev_sample_end += sample->sample_size;
         } else if (traf->
@@ -3139,9 +3291,10 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
         /* Non-non-sync sample aka sync sample */
         if (!GST_ISOFF_SAMPLE_FLAGS_SAMPLE_IS_NON_SYNC_SAMPLE (sample_flags) ||
             GST_ISOFF_SAMPLE_FLAGS_SAMPLE_DEPENDS_ON (sample_flags) == 2) {
+          /* the timestamp is in track timescale units until all sample
+           * durations of the moof are known */
           GstDashStreamSyncSample sync_sample =
-              { sample_offset, prev_sample_end - 1 };
-          /* TODO: need timestamps so we can decide to download or not */
+              { sample_offset, prev_sample_end - 1, sample_time };
           g_array_append_val (dash_stream->moof_sync_samples, sync_sample);
         }
       }
@@ -3167,10 +3320,11 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
   }
 
   if (dash_stream->moof_sync_samples->len == 0) {
+    /* Only this fragment has to be downloaded completely, following ones
+     * might still start with a keyframe */
     GST_LOG_OBJECT (stream->pad, "No sync samples found in fragment");
     g_array_free (dash_stream->moof_sync_samples, TRUE);
     dash_stream->moof_sync_samples = NULL;
-    dashdemux->allow_trickmode_key_units = FALSE;
     return FALSE;
   }
 
@@ -3178,8 +3332,21 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
     GstDashStreamSyncSample *sync_sample;
     guint i;
     guint size;
+    GstClockTime duration;
     GstClockTime current_keyframe_distance;
 
+    g_assert (stream->fragment.duration != 0);
+    g_assert (stream->fragment.duration != GST_CLOCK_TIME_NONE);
+
+    if (gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client)
+        && dash_stream->sidx_position != GST_CLOCK_TIME_NONE
+        && SIDX (dash_stream)->entries) {
+      GstSidxBoxEntry *entry = SIDX_CURRENT_ENTRY (dash_stream);
+      duration = entry->duration;
+    } else {
+      duration = stream->fragment.duration;
+    }
+
     for (i = 0; i < dash_stream->moof_sync_samples->len; i++) {
       sync_sample =
           &g_array_index (dash_stream->moof_sync_samples,
@@ -3198,6 +3365,16 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
         dash_stream->keyframe_average_size = size;
       }
 
+      /* Place the keyframe by the sample durations of the moof, spread them
+       * evenly over the fragment if those come from the trex */
+      if (!trex_sample_durations && fragment_time > 0)
+        sync_sample->timestamp =
+            gst_util_uint64_scale (sync_sample->timestamp, duration,
+            fragment_time);
+      else
+        sync_sample->timestamp =
+            i * duration / dash_stream->moof_sync_samples->len;
+
       if (i == 0) {
         if (dash_stream->moof_offset + dash_stream->moof_size + 8 <
             sync_sample->start_offset) {
@@ -3211,19 +3388,7 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
       }
     }
 
-    g_assert (stream->fragment.duration != 0);
-    g_assert (stream->fragment.duration != GST_CLOCK_TIME_NONE);
-
-    if (gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client)
-        && dash_stream->sidx_position != GST_CLOCK_TIME_NONE
-        && SIDX (dash_stream)->entries) {
-      GstSidxBoxEntry *entry = SIDX_CURRENT_ENTRY (dash_stream);
-      current_keyframe_distance =
-          entry->duration / dash_stream->moof_sync_samples->len;
-    } else {
-      current_keyframe_distance =
-          stream->fragment.duration / dash_stream->moof_sync_samples->len;
-    }
+    current_keyframe_distance = duration / dash_stream->moof_sync_samples->len;
     dash_stream->current_fragment_keyframe_distance = current_keyframe_distance;
 
     if (dash_stream->keyframe_average_distance) {
@@ -3295,9 +3460,8 @@ gst_dash_demux_handle_isobmff (GstAdaptiveDemux * demux,
 
       if (GST_CLOCK_TIME_IS_VALID (dash_stream->target_time)) {
         idx =
-            (dash_stream->target_time -
-            dash_stream->current_fragment_timestamp) /
-            dash_stream->current_fragment_keyframe_distance;
+            gst_dash_demux_stream_find_sync_sample (dash_stream,
+            dash_stream->target_time);
       } else if (stream->segment.rate > 0) {
         idx = 0;
       }
@@ -1441,6 +1441,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
   guint intval;
   guint64 int64val;
   gboolean boolval;
+  gdouble doubleval;
   GstRange *rangeval;
 
   gst_mpdparser_free_seg_base_type_ext (*pointer);
@@ -1456,6 +1457,7 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
     seg_base_type->presentationTimeOffset = parent->presentationTimeOffset;
     seg_base_type->indexRange = gst_mpdparser_clone_range (parent->indexRange);
     seg_base_type->indexRangeExact = parent->indexRangeExact;
+    seg_base_type->availabilityTimeOffset = parent->availabilityTimeOffset;
     seg_base_type->Initialization =
         gst_mpdparser_clone_URL (parent->Initialization);
     seg_base_type->RepresentationIndex =
@@ -1483,6 +1485,10 @@ gst_mpdparser_parse_seg_base_type_ext (GstSegmentBaseType ** pointer,
           FALSE, &boolval)) {
     seg_base_type->indexRangeExact = boolval;
   }
+  if (gst_mpdparser_get_xml_prop_double (a_node, "availabilityTimeOffset",
+          &doubleval)) {
+    seg_base_type->availabilityTimeOffset = doubleval;
+  }
 
   /* explore children nodes */
   for (cur_node = a_node->children; cur_node; cur_node = cur_node->next) {
@@ -3860,6 +3866,18 @@ gst_mpdparser_get_segment_end_time (GstMpdClient * client, GPtrArray * segments,
   return end;
 }
 
+/* Whether a run of segments of @scale_duration starting at @scale_start
+ * continues @segment, repeated @repeat times, so that it can be folded into
+ * its repeat count. Live timelines tend to list every segment as its own
+ * S element, folding keeps the segment list one entry per run */
+static gboolean
+gst_mpdparser_timeline_run_continues (GstMediaSegment * segment, gint repeat,
+    guint64 scale_start, guint64 scale_duration)
+{
+  return repeat >= 0 && segment->scale_duration == scale_duration
+      && segment->scale_start + scale_duration * (repeat + 1) == scale_start;
+}
+
 static gboolean
 gst_mpd_client_add_media_segment (GstActiveStream * stream,
     GstSegmentURLNode * url_node, guint number, gint repeat,
@@ -4102,6 +4120,25 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
             start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale);
           }
 
+          /* fold into the previous run, unless that goes past the period
+           * end and has to be clipped */
+          if (stream->segments->len > 0 && S->r >= 0) {
+            GstMediaSegment *prev = g_ptr_array_index (stream->segments,
+                stream->segments->len - 1);
+
+            if (gst_mpdparser_timeline_run_continues (prev, prev->repeat,
+                    start, S->d)
+                && (!GST_CLOCK_TIME_IS_VALID (PeriodEnd)
+                    || start_time + duration * (S->r + 1) <=
+                    PeriodEnd - PeriodStart)) {
+              prev->repeat += S->r + 1;
+              i += S->r + 1;
+              start += S->d * (S->r + 1);
+              start_time += duration * (S->r + 1);
+              continue;
+            }
+          }
+
           if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start,
                   S->d, start_time, duration)) {
             return FALSE;
@@ -4174,6 +4211,447 @@ gst_mpd_client_setup_representation (GstMpdClient * client,
   return TRUE;
 }
 
+/* Changes to apply to an active stream's segment list when merging the
+ * SegmentTimeline of a manifest update */
+typedef struct
+{
+  GstActiveStream *stream;
+  GstAdaptationSetNode *adapt_set;
+  GstRepresentationNode *representation;
+  GstSegmentTemplateNode *seg_template;
+
+  guint drop;                   /* segments that left the timeline */
+  guint trim;                   /* repetitions that left the first kept one */
+  guint extend;                 /* repetitions added to the last segment */
+  GPtrArray *append;            /* new GstMediaSegment */
+} GstMpdTimelineUpdate;
+
+static void
+gst_mpdparser_free_timeline_update (GstMpdTimelineUpdate * update)
+{
+  if (update->append)
+    g_ptr_array_unref (update->append);
+  g_slice_free (GstMpdTimelineUpdate, update);
+}
+
+static void
+gst_mpdparser_add_timeline_segment (GPtrArray * segments, guint number,
+    gint repeat, guint64 scale_start, guint64 scale_duration, guint timescale)
+{
+  GstMediaSegment *media_segment;
+
+  media_segment = g_slice_new0 (GstMediaSegment);
+  media_segment->number = number;
+  media_segment->repeat = repeat;
+  media_segment->scale_start = scale_start;
+  media_segment->scale_duration = scale_duration;
+  media_segment->start =
+      gst_util_uint64_scale (scale_start, GST_SECOND, timescale);
+  media_segment->duration =
+      gst_util_uint64_scale (scale_duration, GST_SECOND, timescale);
+
+  g_ptr_array_add (segments, media_segment);
+}
+
+/* Plans adding a run of @repeat + 1 segments after the current ones, folded
+ * into the run before it when it continues it, as when building the list */
+static void
+gst_mpdparser_plan_timeline_segment (GstMpdTimelineUpdate * update,
+    guint number, gint repeat, guint64 scale_start, guint64 scale_duration,
+    guint timescale)
+{
+  GstActiveStream *stream = update->stream;
+  GstMediaSegment *prev;
+
+  if (update->append->len > 0) {
+    prev = g_ptr_array_index (update->append, update->append->len - 1);
+    if (gst_mpdparser_timeline_run_continues (prev, prev->repeat, scale_start,
+            scale_duration)) {
+      prev->repeat += repeat + 1;
+      return;
+    }
+  } else {
+    prev = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+    if (gst_mpdparser_timeline_run_continues (prev,
+            prev->repeat + update->extend, scale_start, scale_duration)) {
+      update->extend += repeat + 1;
+      return;
+    }
+  }
+
+  gst_mpdparser_add_timeline_segment (update->append, number, repeat,
+      scale_start, scale_duration, timescale);
+}
+
+static GstSegmentTemplateNode *
+gst_mpdparser_get_segment_template (GstPeriodNode * period,
+    GstAdaptationSetNode * adapt_set, GstRepresentationNode * representation)
+{
+  if (representation->SegmentTemplate != NULL)
+    return representation->SegmentTemplate;
+  if (adapt_set->SegmentTemplate != NULL)
+    return adapt_set->SegmentTemplate;
+  return period->SegmentTemplate;
+}
+
+static GstAdaptationSetNode *
+gst_mpdparser_find_matching_adaptation_set (GstPeriodNode * period,
+    GstPeriodNode * new_period, GstAdaptationSetNode * adapt_set)
+{
+  GList *list;
+
+  if (adapt_set->id == 0)
+    return g_list_nth_data (new_period->AdaptationSets,
+        g_list_index (period->AdaptationSets, adapt_set));
+
+  for (list = new_period->AdaptationSets; list; list = g_list_next (list)) {
+    GstAdaptationSetNode *new_adapt_set = list->data;
+
+    if (new_adapt_set->id == adapt_set->id)
+      return new_adapt_set;
+  }
+
+  return NULL;
+}
+
+static GstRepresentationNode *
+gst_mpdparser_find_matching_representation (GstAdaptationSetNode * adapt_set,
+    GstRepresentationNode * representation)
+{
+  GList *list;
+
+  if (representation->id == NULL)
+    return NULL;
+
+  for (list = adapt_set->Representations; list; list = g_list_next (list)) {
+    GstRepresentationNode *new_representation = list->data;
+
+    if (g_strcmp0 (new_representation->id, representation->id) == 0)
+      return new_representation;
+  }
+
+  return NULL;
+}
+
+/* Works out how the segments of @update->stream, built from the previous
+ * version of @update->seg_template's timeline, have to change to match the
+ * new one: dropping the ones that left the timeshift window and appending
+ * the ones that are new. Only the S elements from the last one starting at
+ * or before the current end of the segment list are looked at, the part of
+ * the timeline that is already known is not walked again. Returns FALSE if
+ * the timelines don't line up and the segment list has to be rebuilt */
+static gboolean
+gst_mpdparser_plan_timeline_update (GstMpdTimelineUpdate * update)
+{
+  GstActiveStream *stream = update->stream;
+  GstMultSegmentBaseType *mult_seg = update->seg_template->MultSegBaseType;
+  GstSNode *head;
+  GstMediaSegment *first, *last;
+  guint64 old_end, start, first_start;
+  guint timescale, number;
+  gboolean matched = FALSE;
+  GList *list;
+  guint i;
+
+  if (stream->segments == NULL || stream->segments->len == 0
+      || g_queue_is_empty (&mult_seg->SegmentTimeline->S))
+    return FALSE;
+
+  first = g_ptr_array_index (stream->segments, 0);
+  last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+  old_end = last->scale_start + last->scale_duration * (last->repeat + 1);
+  number = last->number + last->repeat + 1;
+
+  timescale = mult_seg->SegBaseType->timescale;
+  head = g_queue_peek_head (&mult_seg->SegmentTimeline->S);
+  first_start = head->t;
+
+  /* S elements without a t continue the previous one, so go back to one
+   * that has it, or to the first one, to know where the new pieces start */
+  for (list = g_queue_peek_tail_link (&mult_seg->SegmentTimeline->S);
+      list->prev; list = g_list_previous (list)) {
+    GstSNode *S = list->data;
+
+    if (S->t > 0 && S->t <= old_end)
+      break;
+  }
+  start = ((GstSNode *) list->data)->t;
+
+  update->append = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_mpdparser_free_media_segment);
+
+  for (; list; list = g_list_next (list)) {
+    GstSNode *S = list->data;
+    guint64 end, skip = 0;
+
+    if (S->r < 0 || S->d == 0)
+      return FALSE;
+
+    if (S->t > 0)
+      start = S->t;
+    end = start + S->d * (S->r + 1);
+
+    if (matched) {
+      /* everything after the first new piece is new as well */
+      gst_mpdparser_plan_timeline_segment (update, number, S->r, start, S->d,
+          timescale);
+      number += S->r + 1;
+    } else if (end == old_end) {
+      matched = TRUE;
+    } else if (end > old_end) {
+      if (start > old_end)
+        return FALSE;
+      if (start < old_end) {
+        if ((old_end - start) % S->d != 0)
+          return FALSE;
+        skip = (old_end - start) / S->d;
+      }
+      matched = TRUE;
+
+      gst_mpdparser_plan_timeline_segment (update, number,
+          (gint) (S->r - skip), old_end, S->d, timescale);
+      number += S->r - skip + 1;
+    }
+
+    start = end;
+  }
+
+  /* the new timeline must continue the current one */
+  if (!matched || first_start < first->scale_start)
+    return FALSE;
+
+  /* segments before the start of the new timeline left the timeshift
+   * window, and the first one kept must have the new startNumber */
+  for (i = 0; i < stream->segments->len; i++) {
+    GstMediaSegment *segment = g_ptr_array_index (stream->segments, i);
+    guint64 end =
+        segment->scale_start + segment->scale_duration * (segment->repeat + 1);
+
+    if (end > first_start) {
+      if (first_start > segment->scale_start) {
+        if ((first_start - segment->scale_start) % segment->scale_duration)
+          return FALSE;
+        update->trim =
+            (first_start - segment->scale_start) / segment->scale_duration;
+      }
+      if (segment->number + update->trim != mult_seg->startNumber)
+        return FALSE;
+      break;
+    }
+    update->drop++;
+  }
+
+  /* don't lose the current position, seeking in the new list will */
+  if (stream->segment_index < (gint) update->drop ||
+      (stream->segment_index == (gint) update->drop &&
+          stream->segment_repeat_index < update->trim))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gst_mpdparser_apply_timeline_update (GstMpdClient * client,
+    GstMpdTimelineUpdate * update)
+{
+  GstActiveStream *stream = update->stream;
+  guint timescale;
+  guint i;
+
+  timescale = update->seg_template->MultSegBaseType->SegBaseType->timescale;
+
+  if (update->drop > 0) {
+    g_ptr_array_remove_range (stream->segments, 0, update->drop);
+    stream->segment_index -= update->drop;
+  }
+
+  if (update->trim > 0) {
+    GstMediaSegment *segment = g_ptr_array_index (stream->segments, 0);
+
+    segment->number += update->trim;
+    segment->repeat -= update->trim;
+    segment->scale_start += segment->scale_duration * update->trim;
+    segment->start = gst_util_uint64_scale (segment->scale_start, GST_SECOND,
+        timescale);
+    if (stream->segment_index == 0)
+      stream->segment_repeat_index -= update->trim;
+  }
+
+  if (update->extend > 0) {
+    GstMediaSegment *segment =
+        g_ptr_array_index (stream->segments, stream->segments->len - 1);
+
+    segment->repeat += update->extend;
+  }
+
+  for (i = 0; i < update->append->len; i++)
+    g_ptr_array_add (stream->segments, g_ptr_array_index (update->append, i));
+  /* now owned by the stream */
+  g_ptr_array_set_free_func (update->append, NULL);
+
+  GST_LOG ("Dropped %u segments, trimmed %u, extended by %u, added %u",
+      update->drop, update->trim, update->extend, update->append->len);
+
+  stream->cur_adapt_set = update->adapt_set;
+  stream->cur_representation = update->representation;
+  stream->representation_idx =
+      g_list_index (update->adapt_set->Representations, update->representation);
+  stream->cur_seg_template = update->seg_template;
+
+  g_free (stream->baseURL);
+  g_free (stream->queryURL);
+  stream->baseURL =
+      gst_mpdparser_parse_baseURL (client, stream, &stream->queryURL);
+}
+
+/**
+ * gst_mpd_client_update_timelines:
+ * @client: the #GstMpdClient currently in use
+ * @update: a #GstMpdClient holding a new version of the same manifest, as
+ *          parsed by gst_mpd_parse()
+ *
+ * Takes over the manifest of @update, keeping the active streams of @client
+ * and their position. Their segment lists are updated with the S elements
+ * new to @update instead of being rebuilt. Only possible if the Periods,
+ * AdaptationSets and Representations in use are the same in both versions
+ * and all active streams use a SegmentTemplate with a SegmentTimeline.
+ *
+ * This does not make parsing @update any cheaper, it still holds the full
+ * node model of the new manifest.
+ *
+ * Returns: %TRUE if @client now uses the manifest of @update, %FALSE if
+ *     nothing was changed and the streams have to be set up again
+ */
+gboolean
+gst_mpd_client_update_timelines (GstMpdClient * client, GstMpdClient * update)
+{
+  GstStreamPeriod *stream_period;
+  GstPeriodNode *new_period;
+  GList *updates = NULL;
+  GList *list, *new_list;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (client != NULL && update != NULL, FALSE);
+
+  if (client->mpd_node == NULL || update->mpd_node == NULL
+      || client->active_streams == NULL)
+    return FALSE;
+
+  if (client->mpd_node->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || update->mpd_node->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || client->mpd_node->mediaPresentationDuration !=
+      update->mpd_node->mediaPresentationDuration)
+    return FALSE;
+
+  /* the periods set up so far must be unchanged */
+  if (g_list_length (client->mpd_node->Periods) !=
+      g_list_length (update->mpd_node->Periods))
+    return FALSE;
+
+  for (list = client->mpd_node->Periods, new_list = update->mpd_node->Periods;
+      list; list = list->next, new_list = new_list->next) {
+    GstPeriodNode *period = list->data;
+    GstPeriodNode *new_period = new_list->data;
+
+    if (new_period->xlink_href || g_strcmp0 (period->id, new_period->id) != 0
+        || period->start != new_period->start
+        || period->duration != new_period->duration)
+      return FALSE;
+  }
+
+  /* segments of a period with a known end are clipped to it */
+  stream_period = gst_mpdparser_get_stream_period (client);
+  if (stream_period == NULL
+      || GST_CLOCK_TIME_IS_VALID (stream_period->duration))
+    return FALSE;
+  new_period = g_list_nth_data (update->mpd_node->Periods,
+      g_list_index (client->mpd_node->Periods, stream_period->period));
+  if (new_period == NULL)
+    return FALSE;
+
+  for (list = client->active_streams; list; list = list->next) {
+    GstActiveStream *stream = list->data;
+    GstMpdTimelineUpdate *timeline_update;
+    GstSegmentTemplateNode *seg_template;
+    GstMultSegmentBaseType *mult_seg, *new_mult_seg;
+
+    if (stream->cur_segment_base || stream->cur_segment_list
+        || stream->cur_seg_template == NULL || stream->cur_adapt_set == NULL
+        || stream->cur_representation == NULL)
+      goto done;
+
+    timeline_update = g_slice_new0 (GstMpdTimelineUpdate);
+    timeline_update->stream = stream;
+    updates = g_list_prepend (updates, timeline_update);
+
+    timeline_update->adapt_set =
+        gst_mpdparser_find_matching_adaptation_set (stream_period->period,
+        new_period, stream->cur_adapt_set);
+    if (timeline_update->adapt_set == NULL
+        || timeline_update->adapt_set->xlink_href)
+      goto done;
+
+    timeline_update->representation =
+        gst_mpdparser_find_matching_representation (timeline_update->adapt_set,
+        stream->cur_representation);
+    if (timeline_update->representation == NULL)
+      goto done;
+
+    /* the template must be the same, with timestamps on the same scale */
+    seg_template =
+        gst_mpdparser_get_segment_template (stream_period->period,
+        stream->cur_adapt_set, stream->cur_representation);
+    timeline_update->seg_template =
+        gst_mpdparser_get_segment_template (new_period,
+        timeline_update->adapt_set, timeline_update->representation);
+    if (seg_template != stream->cur_seg_template
+        || timeline_update->seg_template == NULL)
+      goto done;
+
+    mult_seg = seg_template->MultSegBaseType;
+    new_mult_seg = timeline_update->seg_template->MultSegBaseType;
+    if (mult_seg == NULL || new_mult_seg == NULL
+        || mult_seg->SegmentTimeline == NULL
+        || new_mult_seg->SegmentTimeline == NULL
+        || mult_seg->SegBaseType == NULL || new_mult_seg->SegBaseType == NULL
+        || mult_seg->SegBaseType->timescale !=
+        new_mult_seg->SegBaseType->timescale
+        || mult_seg->SegBaseType->presentationTimeOffset !=
+        new_mult_seg->SegBaseType->presentationTimeOffset
+        || g_strcmp0 (seg_template->media,
+            timeline_update->seg_template->media) != 0
+        || g_strcmp0 (seg_template->initialization,
+            timeline_update->seg_template->initialization) != 0)
+      goto done;
+
+    if (!gst_mpdparser_plan_timeline_update (timeline_update))
+      goto done;
+  }
+
+  /* everything lines up, take over the new manifest */
+  for (list = client->periods; list; list = list->next) {
+    GstStreamPeriod *period = list->data;
+
+    period->period = g_list_nth_data (update->mpd_node->Periods,
+        g_list_index (client->mpd_node->Periods, period->period));
+  }
+  gst_mpdparser_free_mpd_node (client->mpd_node);
+  client->mpd_node = update->mpd_node;
+  update->mpd_node = NULL;
+  gst_mpd_client_check_profiles (client);
+
+  for (list = updates; list; list = list->next)
+    gst_mpdparser_apply_timeline_update (client, list->data);
+
+  ret = TRUE;
+
+done:
+  g_list_free_full (updates,
+      (GDestroyNotify) gst_mpdparser_free_timeline_update);
+
+  return ret;
+}
+
 #define CUSTOM_WRAPPER_START "<custom_wrapper>"
 #define CUSTOM_WRAPPER_END "</custom_wrapper>"
 
@@ -4769,6 +5247,40 @@ gst_mpd_client_setup_streaming (GstMpdClient * client,
   return TRUE;
 }
 
+/* Returns the index of the first segment of @segments ending after @ts
+ * (at or after @ts in reverse mode), or segments->len if there is none.
+ * Segment end times only ever grow with the index, so a binary search
+ * does the job instead of walking the whole list */
+static guint
+gst_mpdparser_find_segment_index (GstMpdClient * client, GPtrArray * segments,
+    GstClockTime ts, gboolean forward)
+{
+  guint lo = 0, hi = segments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstMediaSegment *segment = g_ptr_array_index (segments, mid);
+    GstClockTime end_time;
+    gboolean in_segment;
+
+    end_time = gst_mpdparser_get_segment_end_time (client, segments, segment,
+        mid);
+
+    /* avoid downloading another fragment just for 1ns in reverse mode */
+    if (forward)
+      in_segment = ts < end_time;
+    else
+      in_segment = ts <= end_time;
+
+    if (in_segment)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
+}
+
 gboolean
 gst_mpd_client_stream_seek (GstMpdClient * client, GstActiveStream * stream,
     gboolean forward, GstSeekFlags flags, GstClockTime ts,
@@ -4781,67 +5293,54 @@ gst_mpd_client_stream_seek (GstMpdClient * client, GstActiveStream * stream,
   g_return_val_if_fail (stream != NULL, 0);
 
   if (stream->segments) {
-    for (index = 0; index < stream->segments->len; index++) {
-      gboolean in_segment = FALSE;
-      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
-      GstClockTime end_time;
+    index = gst_mpdparser_find_segment_index (client, stream->segments, ts,
+        forward);
 
-      GST_DEBUG ("Looking at fragment sequence chunk %d / %d", index,
-          stream->segments->len);
+    GST_DEBUG ("Found fragment sequence chunk %d / %d", index,
+        stream->segments->len);
 
-      end_time =
-          gst_mpdparser_get_segment_end_time (client, stream->segments,
-          segment, index);
-
-      /* avoid downloading another fragment just for 1ns in reverse mode */
-      if (forward)
-        in_segment = ts < end_time;
-      else
-        in_segment = ts <= end_time;
-
-      if (in_segment) {
-        GstClockTime chunk_time;
+    if (index < stream->segments->len) {
+      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
+      GstClockTime chunk_time;
 
-        selectedChunk = segment;
-        repeat_index = (ts - segment->start) / segment->duration;
+      selectedChunk = segment;
+      repeat_index = (ts - segment->start) / segment->duration;
 
-        chunk_time = segment->start + segment->duration * repeat_index;
+      chunk_time = segment->start + segment->duration * repeat_index;
 
-        /* At the end of a segment in reverse mode, start from the previous fragment */
-        if (!forward && repeat_index > 0
-            && ((ts - segment->start) % segment->duration == 0))
-          repeat_index--;
+      /* At the end of a segment in reverse mode, start from the previous fragment */
+      if (!forward && repeat_index > 0
+          && ((ts - segment->start) % segment->duration == 0))
+        repeat_index--;
 
-        if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
-          if (repeat_index + 1 < segment->repeat) {
-            if (ts - chunk_time > chunk_time + segment->duration - ts)
-              repeat_index++;
-          } else if (index + 1 < stream->segments->len) {
-            GstMediaSegment *next_segment =
-                g_ptr_array_index (stream->segments, index + 1);
+      if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
+        if (repeat_index < segment->repeat) {
+          if (ts - chunk_time > chunk_time + segment->duration - ts)
+            repeat_index++;
+        } else if (index + 1 < stream->segments->len) {
+          GstMediaSegment *next_segment =
+              g_ptr_array_index (stream->segments, index + 1);
 
-            if (ts - chunk_time > next_segment->start - ts) {
-              repeat_index = 0;
-              selectedChunk = next_segment;
-              index++;
-            }
+          if (ts - chunk_time > next_segment->start - ts) {
+            repeat_index = 0;
+            selectedChunk = next_segment;
+            index++;
           }
-        } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
-                (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
-            ts != chunk_time) {
+        }
+      } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
+              (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
+          ts != chunk_time) {
 
-          if (repeat_index + 1 < segment->repeat) {
-            repeat_index++;
+        if (repeat_index < segment->repeat) {
+          repeat_index++;
+        } else {
+          repeat_index = 0;
+          if (index + 1 >= stream->segments->len) {
+            selectedChunk = NULL;
           } else {
-            repeat_index = 0;
-            if (index + 1 >= stream->segments->len) {
-              selectedChunk = NULL;
-            } else {
-              selectedChunk = g_ptr_array_index (stream->segments, ++index);
-            }
+            selectedChunk = g_ptr_array_index (stream->segments, ++index);
           }
         }
-        break;
       }
     }
 
@@ -6003,6 +6502,36 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
   return rv;
 }
 
+/* Returns how long before its availability start time a segment of @stream
+ * can already be requested (its availabilityTimeOffset), or
+ * GST_CLOCK_TIME_NONE if segments are available at any time */
+GstClockTime
+gst_mpd_client_get_availability_time_offset (GstMpdClient * client,
+    GstActiveStream * stream)
+{
+  GstSegmentBaseType *base = NULL;
+
+  g_return_val_if_fail (client != NULL, 0);
+  g_return_val_if_fail (stream != NULL, 0);
+
+  if (stream->cur_seg_template && stream->cur_seg_template->MultSegBaseType)
+    base = stream->cur_seg_template->MultSegBaseType->SegBaseType;
+  else if (stream->cur_segment_list
+      && stream->cur_segment_list->MultSegBaseType)
+    base = stream->cur_segment_list->MultSegBaseType->SegBaseType;
+  else
+    base = stream->cur_segment_base;
+
+  if (base == NULL || !(base->availabilityTimeOffset > 0))
+    return 0;
+
+  /* "INF" or too far away to matter */
+  if (base->availabilityTimeOffset >= G_MAXUINT64 / GST_SECOND)
+    return GST_CLOCK_TIME_NONE;
+
+  return base->availabilityTimeOffset * GST_SECOND;
+}
+
 gboolean
 gst_mpd_client_seek_to_time (GstMpdClient * client, GDateTime * time)
 {
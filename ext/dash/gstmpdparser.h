@@ -169,6 +169,7 @@ struct _GstSegmentBaseType
   guint64 presentationTimeOffset;
   GstRange *indexRange;
   gboolean indexRangeExact;
+  gdouble availabilityTimeOffset;  /* in seconds, may be infinite */
   /* Initialization node */
   GstURLType *Initialization;
   /* RepresentationIndex node */
@@ -537,6 +538,7 @@ gboolean gst_mpd_parse (GstMpdClient *client, const gchar *data, gint size);
 gboolean gst_mpd_client_setup_media_presentation (GstMpdClient *client, GstClockTime time, gint period_index, const gchar *period_id);
 gboolean gst_mpd_client_setup_streaming (GstMpdClient * client, GstAdaptationSetNode * adapt_set);
 gboolean gst_mpd_client_setup_representation (GstMpdClient *client, GstActiveStream *stream, GstRepresentationNode *representation);
+gboolean gst_mpd_client_update_timelines (GstMpdClient * client, GstMpdClient * update);
 GstClockTime gst_mpd_client_get_next_fragment_duration (GstMpdClient * client, GstActiveStream * stream);
 GstClockTime gst_mpd_client_get_media_presentation_duration (GstMpdClient *client);
 GstClockTime gst_mpd_client_get_maximum_segment_duration (GstMpdClient * client);
@@ -582,6 +584,7 @@ gboolean gst_mpd_client_has_next_segment (GstMpdClient * client, GstActiveStream
 GstFlowReturn gst_mpd_client_advance_segment (GstMpdClient * client, GstActiveStream * stream, gboolean forward);
 void gst_mpd_client_seek_to_first_segment (GstMpdClient * client);
 GstDateTime *gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client, GstActiveStream * stream);
+GstClockTime gst_mpd_client_get_availability_time_offset (GstMpdClient * client, GstActiveStream * stream);
 
 /* Get audio/video stream parameters (caps, width, height, rate, number of channels) */
 GstCaps * gst_mpd_client_get_stream_caps (GstActiveStream * stream);
@@ -107,8 +107,12 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static GstFlowReturn gst_hls_demux_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
+static guint64 *gst_hls_demux_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates, guint * current);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
 static gboolean gst_hls_demux_get_live_seek_range (GstAdaptiveDemux * demux,
     gint64 * start, gint64 * stop);
@@ -174,7 +178,9 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment = gst_hls_demux_peek_fragment;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
+  adaptivedemux_class->stream_get_bitrates = gst_hls_demux_get_bitrates;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
   adaptivedemux_class->start_fragment = gst_hls_demux_start_fragment;
@@ -281,7 +287,7 @@ gst_hls_demux_set_current (GstHLSDemux * self, GstM3U8 * m3u8)
   if (m3u8 != self->current) {
     self->current = m3u8;
     self->current->duration = GST_CLOCK_TIME_NONE;
-    self->current->current_file = NULL;
+    self->current->current_file = -1;
 
 #if 0
     // FIXME: this makes no sense after we just set self->current=m3u8 above (tpm)
@@ -401,15 +407,15 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
     GstSeekFlags flags, GstClockTime ts, GstClockTime * final_ts)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GList *walk;
-  GstClockTime current_pos;
+  GstM3U8 *playlist = hls_stream->playlist;
+  GstClockTime current_pos, first_pos;
   gint64 current_sequence;
   gboolean snap_after, snap_nearest;
   GstM3U8MediaFile *file = NULL;
+  guint n_files, idx;
 
   current_sequence = 0;
-  current_pos = gst_m3u8_is_live (hls_stream->playlist) ?
-      hls_stream->playlist->first_file_start : 0;
+  first_pos = gst_m3u8_is_live (playlist) ? playlist->first_file_start : 0;
 
   /* Snap to segment boundary. Improves seek performance on slow machines. */
   snap_nearest =
@@ -418,40 +424,62 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
-    file = walk->data;
+  n_files = playlist->files->len;
+
+  /* the fragment containing the target position */
+  if (ts < first_pos)
+    idx = ((forward && snap_after) || snap_nearest) ? 0 : n_files;
+  else
+    idx = gst_m3u8_find_file_for_time (playlist, ts - first_pos);
+
+  if (idx < n_files && ts >= first_pos) {
+    file = g_ptr_array_index (playlist->files, idx);
+    current_pos = first_pos + gst_m3u8_get_file_start (playlist, idx);
 
-    current_sequence = file->sequence;
     if ((forward && snap_after) || snap_nearest) {
-      if (current_pos >= ts)
-        break;
-      if (snap_nearest && ts - current_pos < file->duration / 2)
-        break;
+      /* the next fragment, unless we are at the start of this one or
+       * close enough to it when snapping to the nearest */
+      if (current_pos < ts && (!snap_nearest
+              || ts - current_pos >= file->duration / 2))
+        idx++;
     } else if (!forward && snap_after) {
-      /* check if the next fragment is our target, in this case we want to
-       * start from the previous fragment */
-      GstClockTime next_pos = current_pos + file->duration;
-
-      if (next_pos <= ts && ts < next_pos + file->duration) {
-        break;
-      }
-    } else if (current_pos <= ts && ts < current_pos + file->duration) {
-      break;
+      /* the next fragment is our target, in this case we want to start
+       * from the previous fragment */
+      if (idx > 0)
+        idx--;
     }
-    current_pos += file->duration;
+  } else if (idx == n_files && n_files > 0 && ts >= first_pos
+      && !snap_nearest && !forward && snap_after) {
+    /* right after the last fragment, start from it */
+    file = g_ptr_array_index (playlist->files, n_files - 1);
+    current_pos = first_pos + gst_m3u8_get_file_start (playlist, n_files - 1);
+    if (ts < current_pos + 2 * file->duration)
+      idx = n_files - 1;
   }
 
-  if (walk == NULL) {
+  if (idx < n_files) {
+    file = g_ptr_array_index (playlist->files, idx);
+    current_sequence = file->sequence;
+    current_pos = first_pos + gst_m3u8_get_file_start (playlist, idx);
+  } else {
     GST_DEBUG_OBJECT (stream->pad, "seeking further than track duration");
+    file = NULL;
+    current_pos = first_pos;
+    if (n_files > 0) {
+      file = g_ptr_array_index (playlist->files, n_files - 1);
+      current_sequence = file->sequence;
+      current_pos += gst_m3u8_get_file_start (playlist, n_files - 1) +
+          file->duration;
+    }
     current_sequence++;
   }
 
   GST_DEBUG_OBJECT (stream->pad, "seeking to sequence %u",
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
-  hls_stream->playlist->sequence = current_sequence;
-  hls_stream->playlist->current_file = walk;
-  hls_stream->playlist->sequence_position = current_pos;
+  playlist->sequence = current_sequence;
+  playlist->current_file = idx < n_files ? idx : -1;
+  playlist->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
 
   /* Play from the end of the current selected segment */
@@ -1126,6 +1154,33 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+gst_hls_demux_peek_fragment (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, n);
+  if (file == NULL)
+    return GST_FLOW_EOS;
+
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1155,6 +1210,50 @@ gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
   return changed;
 }
 
+static guint64 *
+gst_hls_demux_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates, guint * current)
+{
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (stream->demux);
+  GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  guint64 *bitrates = NULL;
+  GList *variants, *l;
+  guint i = 0;
+
+  *n_bitrates = 0;
+  *current = 0;
+
+  /* only the primary stream switches variants */
+  if (hls_stream->is_primary_playlist == FALSE)
+    return NULL;
+
+  GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  if (hlsdemux->master == NULL || hlsdemux->master->is_simple
+      || hlsdemux->current_variant == NULL) {
+    GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+    return NULL;
+  }
+
+  /* variant lists are sorted low to high already */
+  if (hlsdemux->current_variant->iframe)
+    variants = hlsdemux->master->iframe_variants;
+  else
+    variants = hlsdemux->master->variants;
+
+  bitrates = g_new (guint64, g_list_length (variants));
+  for (l = variants; l != NULL; l = l->next) {
+    GstHLSVariantStream *variant = l->data;
+
+    if (variant == hlsdemux->current_variant)
+      *current = i;
+    bitrates[i++] = variant->bandwidth;
+  }
+  *n_bitrates = i;
+  GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
+
+  return bitrates;
+}
+
 static void
 gst_hls_demux_reset (GstAdaptiveDemux * ademux)
 {
@@ -1494,9 +1593,10 @@ retry:
 
     GST_M3U8_CLIENT_LOCK (demux->client);
     last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->files->len - 1))->sequence;
     first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, 0))->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1514,7 +1614,7 @@ retry:
   } else if (!gst_m3u8_is_live (m3u8)) {
     GstClockTime current_pos, target_pos;
     guint sequence = 0;
-    GList *walk;
+    guint idx;
 
     /* Sequence numbers are not guaranteed to be the same in different
      * playlists, so get the correct fragment here based on the current
@@ -1538,19 +1638,21 @@ retry:
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
     current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
-      GstM3U8MediaFile *file = walk->data;
+    idx = gst_m3u8_find_file_for_time (m3u8, target_pos);
+    if (idx < m3u8->files->len) {
+      sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              idx))->sequence;
+      current_pos = gst_m3u8_get_file_start (m3u8, idx);
+    } else {
+      /* End of playlist */
+      if (idx > 0) {
+        GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, idx - 1);
 
-      sequence = file->sequence;
-      if (current_pos <= target_pos
-          && target_pos < current_pos + file->duration) {
-        break;
+        sequence = file->sequence;
+        current_pos = gst_m3u8_get_file_start (m3u8, idx - 1) + file->duration;
       }
-      current_pos += file->duration;
-    }
-    /* End of playlist */
-    if (!walk)
       sequence++;
+    }
     m3u8->sequence = sequence;
     m3u8->sequence_position = current_pos;
     GST_M3U8_CLIENT_UNLOCK (demux->client);
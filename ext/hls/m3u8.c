@@ -31,6 +31,13 @@
 
 #define GST_CAT_DEFAULT hls_debug
 
+/* Byte offsets of the URI line of a media file in the playlist text */
+typedef struct
+{
+  gsize start;
+  gsize end;
+} GstM3U8FileLine;
+
 static GstM3U8MediaFile *gst_m3u8_media_file_new (gchar * uri,
     gchar * title, GstClockTime duration, guint sequence);
 static gchar *uri_join (const gchar * uri, const gchar * path);
@@ -42,7 +49,12 @@ gst_m3u8_new (void)
 
   m3u8 = g_new0 (GstM3U8, 1);
 
-  m3u8->current_file = NULL;
+  m3u8->files =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_m3u8_media_file_unref);
+  m3u8->file_starts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  m3u8->file_lines = g_array_new (FALSE, FALSE, sizeof (GstM3U8FileLine));
+  m3u8->current_file = -1;
   m3u8->current_file_duration = GST_CLOCK_TIME_NONE;
   m3u8->sequence = -1;
   m3u8->sequence_position = 0;
@@ -104,8 +116,9 @@ gst_m3u8_unref (GstM3U8 * self)
     g_free (self->base_uri);
     g_free (self->name);
 
-    g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (self->files);
+    g_ptr_array_unref (self->files);
+    g_array_unref (self->file_starts);
+    g_array_unref (self->file_lines);
 
     g_free (self->last_data);
     g_free (self);
@@ -308,9 +321,11 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
 
 static gboolean
 gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
-    gboolean have_mediasequence, GList * previous_files)
+    gboolean have_mediasequence, GPtrArray * previous_files)
 {
-  if (!previous_files)
+  GPtrArray *files = self->files;
+
+  if (!previous_files || previous_files->len == 0)
     return TRUE;
 
   /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
@@ -321,17 +336,17 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
    * playlist in relation to the old. That is, same URIs get the same number
    * and later URIs get higher numbers */
   if (have_mediasequence) {
-    GList *l, *m;
+    guint l, m = 0;
     GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
 
     /* Find first case of higher/equal sequence number in new playlist or
      * same URI. From there on we can linearly step ahead */
-    for (l = self->files; l; l = l->next) {
+    for (l = 0; l < files->len; l++) {
       gboolean match = FALSE;
 
-      f1 = l->data;
-      for (m = previous_files; m; m = m->next) {
-        f2 = m->data;
+      f1 = g_ptr_array_index (files, l);
+      for (m = 0; m < previous_files->len; m++) {
+        f2 = g_ptr_array_index (previous_files, m);
 
         if (f1->sequence >= f2->sequence || g_str_equal (f1->uri, f2->uri)) {
           match = TRUE;
@@ -342,7 +357,7 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
         break;
     }
 
-    if (!l) {
+    if (l == files->len) {
       /* No match, no sequence in the new playlist was higher than
        * any in the old, and no URI was found again. This is bad! */
       GST_ERROR ("Media sequences inconsistent, ignoring");
@@ -351,9 +366,9 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
       g_assert (f1 != NULL);
       g_assert (f2 != NULL);
 
-      for (; l && m; l = l->next, m = m->next) {
-        f1 = l->data;
-        f2 = m->data;
+      for (; l < files->len && m < previous_files->len; l++, m++) {
+        f1 = g_ptr_array_index (files, l);
+        f2 = g_ptr_array_index (previous_files, m);
 
         if (f1->sequence == f2->sequence) {
           if (!g_str_equal (f1->uri, f2->uri)) {
@@ -382,16 +397,16 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
       /* All good if we're getting here */
     }
   } else {
-    GList *l, *m;
+    guint l, m = 0;
     GstM3U8MediaFile *f1 = NULL, *f2 = NULL;
     gint64 mediasequence;
 
-    for (l = self->files; l; l = l->next) {
+    for (l = 0; l < files->len; l++) {
       gboolean match = FALSE;
 
-      f1 = l->data;
-      for (m = previous_files; m; m = m->next) {
-        f2 = m->data;
+      f1 = g_ptr_array_index (files, l);
+      for (m = 0; m < previous_files->len; m++) {
+        f2 = g_ptr_array_index (previous_files, m);
 
         if (g_str_equal (f1->uri, f2->uri)) {
           match = TRUE;
@@ -403,13 +418,13 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
         break;
     }
 
-    if (!l) {
+    if (l == files->len) {
       /* No match, this means f2 is the last item in the previous playlist
        * and we have to start our new playlist at that sequence */
       mediasequence = f2->sequence + 1;
 
-      for (l = self->files; l; l = l->next) {
-        f1 = l->data;
+      for (l = 0; l < files->len; l++) {
+        f1 = g_ptr_array_index (files, l);
         f1->sequence = mediasequence;
         mediasequence++;
       }
@@ -419,9 +434,10 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
 
       mediasequence = f2->sequence;
 
-      for (; l; l = l->next) {
-        f1 = l->data;
-        f2 = m ? m->data : NULL;
+      for (; l < files->len; l++, m++) {
+        f1 = g_ptr_array_index (files, l);
+        f2 = m < previous_files->len ?
+            g_ptr_array_index (previous_files, m) : NULL;
 
         f1->sequence = mediasequence;
         mediasequence++;
@@ -431,9 +447,6 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
             GST_WARNING ("Inconsistent URIs after playlist update");
           }
         }
-
-        if (m)
-          m = m->next;
       }
     }
   }
@@ -441,6 +454,157 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
   return TRUE;
 }
 
+/* call with M3U8_LOCK held. Returns the index of the first file with a
+ * sequence number of at least @sequence, or files->len if there is none.
+ * Sequence numbers go up by one from file to file so this is a direct
+ * lookup, the binary search only covers for playlists where they don't */
+static guint
+m3u8_find_file_index (GstM3U8 * m3u8, gint64 sequence)
+{
+  GPtrArray *files = m3u8->files;
+  GstM3U8MediaFile *file;
+  guint lo = 0, hi = files->len;
+  gint64 first_sequence;
+
+  if (files->len == 0)
+    return 0;
+
+  first_sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (files, 0))->sequence;
+  if (sequence <= first_sequence)
+    return 0;
+
+  if (sequence - first_sequence < files->len) {
+    file = g_ptr_array_index (files, sequence - first_sequence);
+    if (file->sequence == sequence)
+      return sequence - first_sequence;
+  }
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    file = g_ptr_array_index (files, mid);
+    if (file->sequence < sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* call with M3U8_LOCK held */
+static GstClockTime
+m3u8_get_file_start (GstM3U8 * m3u8, guint idx)
+{
+  return g_array_index (m3u8->file_starts, GstClockTime, idx) -
+      g_array_index (m3u8->file_starts, GstClockTime, 0);
+}
+
+/* Checks if the URI line @line of length @len resolves to the URI of
+ * @file */
+static gboolean
+gst_m3u8_line_is_file_uri (GstM3U8 * self, const gchar * line, gsize len,
+    GstM3U8MediaFile * file)
+{
+  gchar *path, *uri;
+  gboolean ret;
+
+  path = g_strndup (line, len);
+  uri = uri_join (self->base_uri ? self->base_uri : self->uri, path);
+  ret = uri != NULL && g_str_equal (uri, file->uri);
+  g_free (uri);
+  g_free (path);
+
+  return ret;
+}
+
+/* Looks for the media files that are already known in the media playlist
+ * @data, without modifying it. Only the lines up to the URI of the first
+ * file are looked at. If that is one of the current files, all following
+ * known files have to be listed exactly as in the previous version of the
+ * playlist, which is compared as a whole from the URI line offsets saved
+ * by the last update. Returns the position right after the URI of the last
+ * known file, and sets @first_sequence to the sequence of the first file
+ * and @first_line to its URI line. Otherwise returns %NULL and the
+ * playlist has to be parsed again from scratch */
+static const gchar *
+gst_m3u8_find_known_files_end (GstM3U8 * self, const gchar * data,
+    gint64 * first_sequence, const gchar ** first_line)
+{
+  GPtrArray *files = self->files;
+  GstM3U8FileLine *known, *last;
+  gboolean have_extinf = FALSE;
+  gint64 sequence = -1;
+  const gchar *line, *end, *rest;
+  gsize len = 0, rest_len;
+  guint idx;
+
+  if (files->len == 0 || self->last_data == NULL
+      || self->file_lines->len != files->len
+      || !GST_CLOCK_TIME_IS_VALID (self->duration))
+    return NULL;
+
+  for (line = data; line; line = end ? end + 1 : NULL) {
+    end = strchr (line, '\n');
+    len = end ? end - line : strlen (line);
+    if (len > 0 && line[len - 1] == '\r')
+      len--;
+
+    if (len == 0)
+      continue;
+
+    if (line[0] != '#')
+      break;
+
+    if (g_str_has_prefix (line, "#EXTINF:")) {
+      have_extinf = TRUE;
+    } else if (g_str_has_prefix (line, "#EXT-X-MEDIA-SEQUENCE:")) {
+      gint val;
+
+      if (sequence != -1
+          || !int_from_string ((gchar *) line + 22, NULL, &val))
+        return NULL;
+      sequence = val;
+    }
+  }
+
+  /* the first file has to come with a MEDIA-SEQUENCE and its EXTINF for
+   * the sequence numbers to match what a full parse gives */
+  if (line == NULL || sequence == -1 || !have_extinf)
+    return NULL;
+
+  idx = m3u8_find_file_index (self, sequence);
+  if (idx >= files->len
+      || GST_M3U8_MEDIA_FILE (g_ptr_array_index (files, idx))->sequence !=
+      sequence
+      || !gst_m3u8_line_is_file_uri (self, line, len,
+          g_ptr_array_index (files, idx)))
+    return NULL;
+
+  /* from there on up to the URI of the last known file nothing changed */
+  known = &g_array_index (self->file_lines, GstM3U8FileLine, idx);
+  last = &g_array_index (self->file_lines, GstM3U8FileLine, files->len - 1);
+  rest = line + len;
+  rest_len = last->end - known->end;
+  if (strncmp (rest, self->last_data + known->end, rest_len) != 0)
+    return NULL;
+  if (rest[rest_len] != '\0' && rest[rest_len] != '\r'
+      && rest[rest_len] != '\n')
+    return NULL;
+
+  /* in case the base URI changed */
+  if (idx < files->len - 1
+      && !gst_m3u8_line_is_file_uri (self, self->last_data + last->start,
+          last->end - last->start, g_ptr_array_index (files,
+              files->len - 1)))
+    return NULL;
+
+  *first_sequence = sequence;
+  *first_line = line;
+
+  return rest + rest_len;
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -456,8 +620,14 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GPtrArray *previous_files = NULL;
   gboolean have_mediasequence = FALSE;
+  const gchar *known_end, *first_line = NULL;
+  gsize known_end_offset = 0, first_line_offset = 0;
+  gint64 first_sequence = -1;
+  gchar *buf;
+  GstClockTime known_duration = 0;
+  guint i, first_new;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -487,12 +657,57 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   GST_TRACE ("data:\n%s", data);
 
+  /* For live playlists most of the media files are the ones we already
+   * have, so only the ones after them are parsed and the ones that left
+   * the playlist are dropped */
+  known_end =
+      gst_m3u8_find_known_files_end (self, data, &first_sequence, &first_line);
+  if (known_end) {
+    guint n_dropped = m3u8_find_file_index (self, first_sequence);
+    gssize shift;
+
+    known_end_offset = known_end - data;
+    first_line_offset = first_line - data;
+
+    known_duration = self->duration;
+    for (i = 0; i < n_dropped; i++)
+      known_duration -=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files, i))->duration;
+
+    g_ptr_array_remove_range (self->files, 0, n_dropped);
+    g_array_remove_range (self->file_starts, 0, n_dropped);
+    g_array_remove_range (self->file_lines, 0, n_dropped);
+
+    /* the URI lines of the kept files moved with the first one */
+    shift = first_line_offset -
+        g_array_index (self->file_lines, GstM3U8FileLine, 0).start;
+    for (i = 0; i < self->file_lines->len; i++) {
+      GstM3U8FileLine *line =
+          &g_array_index (self->file_lines, GstM3U8FileLine, i);
+
+      line->start += shift;
+      line->end += shift;
+    }
+
+    GST_DEBUG ("Updating playlist from sequence %" G_GINT64_FORMAT
+        ", dropped %u files", first_sequence, n_dropped);
+  } else {
+    previous_files = self->files;
+    self->files =
+        g_ptr_array_new_with_free_func ((GDestroyNotify)
+        gst_m3u8_media_file_unref);
+    g_array_set_size (self->file_starts, 0);
+    g_array_set_size (self->file_lines, 0);
+  }
+  first_new = self->files->len;
+
+  /* the text is kept as it was for comparing the next update, the lines
+   * are split in a copy */
   g_free (self->last_data);
   self->last_data = data;
+  data = buf = g_strdup (data);
 
-  self->current_file = NULL;
-  previous_files = self->files;
-  self->files = NULL;
+  self->current_file = -1;
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
 
@@ -514,11 +729,37 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
+      GstM3U8FileLine line;
+
+      if (known_end && (gsize) (data - buf) == first_line_offset) {
+        GstM3U8MediaFile *last =
+            g_ptr_array_index (self->files, self->files->len - 1);
+
+        /* the known files, continue after the last one with the state
+         * the previous update had there */
+        mediasequence = last->sequence + 1;
+        g_free (current_key);
+        current_key = g_strdup (last->key);
+        have_iv = self->last_have_iv;
+        memcpy (iv, self->last_iv, sizeof (iv));
+        duration = 0;
+        g_free (title);
+        title = NULL;
+        discontinuity = FALSE;
+        size = offset = -1;
+        if (end && buf + known_end_offset > end)
+          end = strchr (buf + known_end_offset, '\n');
+        goto next_line;
+      }
+
       if (duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
 
+      line.start = data - buf;
+      line.end = line.start + strlen (data);
+
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
         GstM3U8MediaFile *file;
@@ -540,7 +781,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
           if (offset != -1) {
             file->offset = offset;
           } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+            GstM3U8MediaFile *prev = NULL;
+
+            if (self->files->len > 0)
+              prev = g_ptr_array_index (self->files, self->files->len - 1);
 
             if (!prev) {
               offset = 0;
@@ -560,11 +804,15 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         title = NULL;
         discontinuity = FALSE;
         size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+        g_ptr_array_add (self->files, file);
+        g_array_append_val (self->file_lines, line);
+        self->last_have_iv = have_iv;
+        memcpy (self->last_iv, iv, sizeof (iv));
       }
 
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
       gdouble fval;
+
       if (!double_from_string (data + 8, &data, &fval)) {
         GST_WARNING ("Can't read EXTINF duration");
         goto next_line;
@@ -687,15 +935,26 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (current_key);
   current_key = NULL;
+  g_free (buf);
+
+  /* the new files start where the previous one ends */
+  for (i = first_new; i < self->files->len; i++) {
+    GstClockTime start = 0;
 
-  self->files = g_list_reverse (self->files);
+    if (i > 0) {
+      GstM3U8MediaFile *prev = g_ptr_array_index (self->files, i - 1);
+
+      start = g_array_index (self->file_starts, GstClockTime, i - 1) +
+          prev->duration;
+    }
+    g_array_append_val (self->file_starts, start);
+  }
 
   if (previous_files) {
     gboolean consistent = gst_m3u8_update_check_consistent_media_seqnums (self,
         have_mediasequence, previous_files);
 
-    g_list_foreach (previous_files, (GFunc) gst_m3u8_media_file_unref, NULL);
-    g_list_free (previous_files);
+    g_ptr_array_unref (previous_files);
     previous_files = NULL;
 
     /* error was reported above already */
@@ -705,7 +964,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
     }
   }
 
-  if (self->files == NULL) {
+  if (self->files->len == 0) {
     GST_ERROR ("Invalid media playlist, it does not contain any media files");
     GST_M3U8_UNLOCK (self);
     return FALSE;
@@ -713,14 +972,18 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   /* calculate the start and end times of this media playlist. */
   {
-    GList *walk;
     GstM3U8MediaFile *file;
-    GstClockTime duration = 0;
+    GstClockTime duration = known_duration;
 
     mediasequence = -1;
+    if (first_new > 0) {
+      file = g_ptr_array_index (self->files, first_new - 1);
+      mediasequence = file->sequence;
+    }
 
-    for (walk = self->files; walk; walk = walk->next) {
-      file = walk->data;
+    /* the known files were accounted for by previous updates */
+    for (i = first_new; i < self->files->len; i++) {
+      file = g_ptr_array_index (self->files, i);
 
       if (mediasequence == -1) {
         mediasequence = file->sequence;
@@ -758,40 +1021,42 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
-    GList *file;
+  if (self->files->len > 0 && self->sequence == -1) {
+    guint idx;
 
     if (GST_M3U8_IS_LIVE (self)) {
-      gint i;
+      GstM3U8MediaFile *file;
       GstClockTime sequence_pos = 0;
 
-      file = g_list_last (self->files);
+      idx = self->files->len - 1;
+      file = g_ptr_array_index (self->files, idx);
 
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
+      if (self->last_file_end >= file->duration) {
+        sequence_pos = self->last_file_end - file->duration;
       }
 
       /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
        * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && idx > 0 &&
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files,
+                  idx - 1))->duration <= sequence_pos; ++i) {
+        idx--;
+        file = g_ptr_array_index (self->files, idx);
+        sequence_pos -= file->duration;
       }
       self->sequence_position = sequence_pos;
     } else {
-      file = g_list_first (self->files);
+      idx = 0;
       self->sequence_position = 0;
     }
-    self->current_file = file;
-    self->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    self->current_file = idx;
+    self->sequence =
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (self->files, idx))->sequence;
     GST_DEBUG ("first sequence: %u", (guint) self->sequence);
   }
 
   GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+      self->files->len);
 
   GST_M3U8_UNLOCK (self);
 
@@ -799,35 +1064,24 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 }
 
 /* call with M3U8_LOCK held */
-static GList *
+static gint
 m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
-
-  if (forward) {
-    while (l) {
-      file = l->data;
-
-      if (file->sequence >= m3u8->sequence)
-        break;
+  guint idx;
 
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
-
-    while (l) {
-      file = l->data;
+  idx = m3u8_find_file_index (m3u8, m3u8->sequence);
 
-      if (file->sequence <= m3u8->sequence)
-        break;
+  if (forward)
+    return idx < m3u8->files->len ? idx : -1;
 
-      l = l->prev;
-    }
+  if (idx < m3u8->files->len) {
+    file = g_ptr_array_index (m3u8->files, idx);
+    if (file->sequence == m3u8->sequence)
+      return idx;
   }
 
-  return l;
+  return (gint) idx - 1;
 }
 
 GstM3U8MediaFile *
@@ -845,13 +1099,14 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file == -1)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
-  if (m3u8->current_file == NULL)
+  if (m3u8->current_file == -1)
     goto out;
 
-  file = gst_m3u8_media_file_ref (m3u8->current_file->data);
+  file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files,
+          m3u8->current_file));
 
   GST_DEBUG ("Got fragment with sequence %u (current sequence %u)",
       (guint) file->sequence, (guint) m3u8->sequence);
@@ -875,7 +1130,7 @@ gboolean
 gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
   gboolean have_next;
-  GList *cur;
+  gint cur;
 
   g_return_val_if_fail (m3u8 != NULL, FALSE);
 
@@ -884,26 +1139,73 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   GST_DEBUG ("Checking next fragment %" G_GINT64_FORMAT,
       m3u8->sequence + (forward ? 1 : -1));
 
-  if (m3u8->current_file) {
+  if (m3u8->current_file != -1) {
     cur = m3u8->current_file;
   } else {
     cur = m3u8_find_next_fragment (m3u8, forward);
   }
 
-  have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+  have_next = cur != -1 && ((forward && cur + 1 < m3u8->files->len)
+      || (!forward && cur > 0));
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the fragment @n positions after the current one without moving
+ * the current position, or %NULL if the playlist doesn't go that far */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint n)
+{
+  GstM3U8MediaFile *file = NULL;
+  gint idx;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (m3u8->current_file != -1) {
+    idx = m3u8->current_file;
+  } else {
+    idx = m3u8_find_next_fragment (m3u8, forward);
+  }
+
+  if (idx != -1) {
+    if (forward && n < m3u8->files->len - idx)
+      file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files,
+              idx + n));
+    else if (!forward && n <= idx)
+      file = gst_m3u8_media_file_ref (g_ptr_array_index (m3u8->files,
+              idx - n));
+  }
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
+/* call with M3U8_LOCK held. Returns the index of the file with sequence
+ * number @sequence, or -1 if it isn't in the playlist */
+static gint
+m3u8_find_file_with_sequence (GstM3U8 * m3u8, gint64 sequence)
+{
+  guint idx = m3u8_find_file_index (m3u8, sequence);
+
+  if (idx < m3u8->files->len
+      && GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              idx))->sequence == sequence)
+    return idx;
+
+  return -1;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
-  GList *tmp;
-  GstM3U8MediaFile *mf;
+  gint idx;
 
   /* figure out the target seqnum */
   if (forward)
@@ -911,18 +1213,15 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
-  if (tmp == NULL) {
+  idx = m3u8_find_file_with_sequence (m3u8, targetnum);
+  if (idx == -1) {
     GST_WARNING ("Can't find next fragment");
     return;
   }
-  m3u8->current_file = tmp;
+  m3u8->current_file = idx;
   m3u8->sequence = targetnum;
-  m3u8->current_file_duration = GST_M3U8_MEDIA_FILE (tmp->data)->duration;
+  m3u8->current_file_duration =
+      GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, idx))->duration;
 }
 
 void
@@ -948,30 +1247,24 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
-  if (!m3u8->current_file) {
-    GList *l;
-
+  if (m3u8->current_file == -1) {
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
-    if (m3u8->current_file == NULL) {
+    m3u8->current_file = m3u8_find_file_with_sequence (m3u8, m3u8->sequence);
+    if (m3u8->current_file == -1) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
       m3u8_alternate_advance (m3u8, forward);
 
       /* Resync sequence number if the above has failed for live streams */
-      if (m3u8->current_file == NULL && GST_M3U8_IS_LIVE (m3u8)) {
+      if (m3u8->current_file == -1 && GST_M3U8_IS_LIVE (m3u8)
+          && m3u8->files->len > 0) {
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
-        gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+        gint pos = m3u8->files->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file = pos >= 0 ? pos : 0;
         m3u8->current_file_duration =
-            GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+            GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+                m3u8->current_file))->duration;
 
         GST_WARNING ("Resyncing live playlist");
       }
@@ -979,28 +1272,33 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     }
   }
 
-  file = GST_M3U8_MEDIA_FILE (m3u8->current_file->data);
+  file = g_ptr_array_index (m3u8->files, m3u8->current_file);
   GST_DEBUG ("Advancing from sequence %u", (guint) file->sequence);
   if (forward) {
-    m3u8->current_file = m3u8->current_file->next;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file + 1 < m3u8->files->len) {
+      m3u8->current_file++;
+      m3u8->sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              m3u8->current_file))->sequence;
     } else {
+      m3u8->current_file = -1;
       m3u8->sequence = file->sequence + 1;
     }
   } else {
-    m3u8->current_file = m3u8->current_file->prev;
-    if (m3u8->current_file) {
-      m3u8->sequence = GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence;
+    if (m3u8->current_file > 0) {
+      m3u8->current_file--;
+      m3u8->sequence = GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+              m3u8->current_file))->sequence;
     } else {
+      m3u8->current_file = -1;
       m3u8->sequence = file->sequence - 1;
     }
   }
-  if (m3u8->current_file) {
+  if (m3u8->current_file != -1) {
     /* Store duration of the fragment we're using to update the position 
      * the next time we advance */
     m3u8->current_file_duration =
-        GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files,
+            m3u8->current_file))->duration;
   }
 
 out:
@@ -1021,12 +1319,13 @@ gst_m3u8_get_duration (GstM3U8 * m3u8)
   if (!m3u8->endlist)
     goto out;
 
-  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files != NULL) {
-    GList *f;
+  if (!GST_CLOCK_TIME_IS_VALID (m3u8->duration) && m3u8->files->len > 0) {
+    guint i;
 
     m3u8->duration = 0;
-    for (f = m3u8->files; f != NULL; f = f->next)
-      m3u8->duration += GST_M3U8_MEDIA_FILE (f)->duration;
+    for (i = 0; i < m3u8->files->len; i++)
+      m3u8->duration +=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->files, i))->duration;
   }
   duration = m3u8->duration;
 
@@ -1137,8 +1436,6 @@ gboolean
 gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 {
   GstClockTime duration = 0;
-  GList *walk;
-  GstM3U8MediaFile *file;
   guint count;
   guint min_distance = 0;
 
@@ -1146,7 +1443,7 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
 
   GST_M3U8_LOCK (m3u8);
 
-  if (m3u8->files == NULL)
+  if (m3u8->files->len == 0)
     goto out;
 
   if (GST_M3U8_IS_LIVE (m3u8)) {
@@ -1155,12 +1452,15 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
+  count = m3u8->files->len;
+
+  /* duration of the first count - min_distance files */
+  if (count > min_distance) {
+    GstM3U8MediaFile *file;
 
-  for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
-    file = walk->data;
-    --count;
-    duration += file->duration;
+    count -= min_distance;
+    file = g_ptr_array_index (m3u8->files, count - 1);
+    duration = m3u8_get_file_start (m3u8, count - 1) + file->duration;
   }
 
   if (duration <= 0)
@@ -1175,6 +1475,51 @@ out:
   return (duration > 0);
 }
 
+/* Returns the start time of the file at @idx, relative to the start of
+ * the first file of the playlist */
+GstClockTime
+gst_m3u8_get_file_start (GstM3U8 * m3u8, guint idx)
+{
+  GstClockTime start = GST_CLOCK_TIME_NONE;
+
+  g_return_val_if_fail (m3u8 != NULL, GST_CLOCK_TIME_NONE);
+
+  GST_M3U8_LOCK (m3u8);
+  if (idx < m3u8->file_starts->len)
+    start = m3u8_get_file_start (m3u8, idx);
+  GST_M3U8_UNLOCK (m3u8);
+
+  return start;
+}
+
+/* Returns the index of the file containing @time, relative to the start
+ * of the first file of the playlist, or the number of files if @time is
+ * after the end of the playlist */
+guint
+gst_m3u8_find_file_for_time (GstM3U8 * m3u8, GstClockTime time)
+{
+  guint lo = 0, hi;
+
+  g_return_val_if_fail (m3u8 != NULL, 0);
+
+  GST_M3U8_LOCK (m3u8);
+
+  hi = m3u8->file_starts->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstM3U8MediaFile *file = g_ptr_array_index (m3u8->files, mid);
+
+    if (m3u8_get_file_start (m3u8, mid) + file->duration > time)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return lo;
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
@@ -63,10 +63,11 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
-  GList *files;
+  GPtrArray *files;             /* GstM3U8MediaFile, by increasing sequence */
+  GArray *file_starts;          /* GstClockTime, running start of each file */
 
   /* state */
-  GList *current_file;
+  gint current_file;                  /* index of the current fragment, -1 if unknown */
   GstClockTime current_file_duration; /* Duration of current fragment */
   gint64 sequence;                    /* the next sequence for this client */
   GstClockTime sequence_position;     /* position of this sequence */
@@ -78,6 +79,9 @@ struct _GstM3U8
 
   /*< private > */
   gchar *last_data;
+  GArray *file_lines;           /* GstM3U8FileLine, URI line of each file in last_data */
+  gboolean last_have_iv;        /* EXT-X-KEY IV state after the last file */
+  guint8 last_iv[16];
   GMutex lock;
 
   gint ref_count;               /* ATOMIC */
@@ -123,6 +127,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     n);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -138,6 +146,12 @@ gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+GstClockTime       gst_m3u8_get_file_start       (GstM3U8 * m3u8,
+                                                  guint     idx);
+
+guint              gst_m3u8_find_file_for_time   (GstM3U8      * m3u8,
+                                                  GstClockTime   time);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
@@ -130,6 +130,8 @@ static GstFlowReturn
 gst_mss_demux_stream_advance_fragment (GstAdaptiveDemuxStream * stream);
 static gboolean gst_mss_demux_stream_select_bitrate (GstAdaptiveDemuxStream *
     stream, guint64 bitrate);
+static guint64 *gst_mss_demux_stream_get_bitrates (GstAdaptiveDemuxStream *
+    stream, guint * n_bitrates, guint * current);
 static GstFlowReturn
 gst_mss_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream);
 static gboolean gst_mss_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek);
@@ -197,6 +199,8 @@ gst_mss_demux_class_init (GstMssDemuxClass * klass)
       gst_mss_demux_stream_has_next_fragment;
   gstadaptivedemux_class->stream_select_bitrate =
       gst_mss_demux_stream_select_bitrate;
+  gstadaptivedemux_class->stream_get_bitrates =
+      gst_mss_demux_stream_get_bitrates;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_mss_demux_stream_update_fragment_info;
   gstadaptivedemux_class->stream_get_fragment_waiting_time =
@@ -602,6 +606,16 @@ gst_mss_demux_stream_select_bitrate (GstAdaptiveDemuxStream * stream,
   return ret;
 }
 
+static guint64 *
+gst_mss_demux_stream_get_bitrates (GstAdaptiveDemuxStream * stream,
+    guint * n_bitrates, guint * current)
+{
+  GstMssDemuxStream *mssstream = (GstMssDemuxStream *) stream;
+
+  return gst_mss_stream_get_bitrates (mssstream->manifest_stream, n_bitrates,
+      current);
+}
+
 #define SEEK_UPDATES_PLAY_POSITION(r, start_type, stop_type) \
   ((r >= 0 && start_type != GST_SEEK_TYPE_NONE) || \
    (r < 0 && stop_type != GST_SEEK_TYPE_NONE))
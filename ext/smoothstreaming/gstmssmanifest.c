@@ -80,7 +80,7 @@ struct _GstMssStream
   gboolean has_live_fragments;
   GstAdapter *live_adapter;
 
-  GList *fragments;
+  GArray *fragments;            /* GstMssStreamFragment runs */
   GList *qualities;
 
   gchar *url;
@@ -89,7 +89,7 @@ struct _GstMssStream
   GstMssFragmentParser fragment_parser;
 
   guint fragment_repetition_index;
-  GList *current_fragment;
+  gint current_fragment;        /* index in fragments, -1 when over */
   GList *current_quality;
 
   /* TODO move this to somewhere static */
@@ -115,9 +115,9 @@ struct _GstMssManifest
 /* For parsing and building a fragments list */
 typedef struct _GstMssFragmentListBuilder
 {
-  GList *fragments;
+  GArray *fragments;
 
-  GstMssStreamFragment *previous_fragment;
+  gint previous_fragment;       /* index of the run missing its duration */
   guint fragment_number;
   guint64 fragment_time_accum;
 } GstMssFragmentListBuilder;
@@ -125,8 +125,9 @@ typedef struct _GstMssFragmentListBuilder
 static void
 gst_mss_fragment_list_builder_init (GstMssFragmentListBuilder * builder)
 {
-  builder->fragments = NULL;
-  builder->previous_fragment = NULL;
+  builder->fragments =
+      g_array_new (FALSE, FALSE, sizeof (GstMssStreamFragment));
+  builder->previous_fragment = -1;
   builder->fragment_time_accum = 0;
   builder->fragment_number = 0;
 }
@@ -139,7 +140,7 @@ gst_mss_fragment_list_builder_add (GstMssFragmentListBuilder * builder,
   gchar *time_str;
   gchar *seqnum_str;
   gchar *repetition_str;
-  GstMssStreamFragment *fragment = g_new (GstMssStreamFragment, 1);
+  GstMssStreamFragment fragment = { 0, };
 
   duration_str = (gchar *) xmlGetProp (node, (xmlChar *) MSS_PROP_DURATION);
   time_str = (gchar *) xmlGetProp (node, (xmlChar *) MSS_PROP_TIME);
@@ -149,54 +150,85 @@ gst_mss_fragment_list_builder_add (GstMssFragmentListBuilder * builder,
 
   /* use the node's seq number or use the previous + 1 */
   if (seqnum_str) {
-    fragment->number = g_ascii_strtoull (seqnum_str, NULL, 10);
+    fragment.number = g_ascii_strtoull (seqnum_str, NULL, 10);
     xmlFree (seqnum_str);
-    builder->fragment_number = fragment->number;
+    builder->fragment_number = fragment.number;
   } else {
-    fragment->number = builder->fragment_number;
+    fragment.number = builder->fragment_number;
   }
-  builder->fragment_number = fragment->number + 1;
+  builder->fragment_number = fragment.number + 1;
 
   if (repetition_str) {
-    fragment->repetitions = g_ascii_strtoull (repetition_str, NULL, 10);
+    fragment.repetitions = g_ascii_strtoull (repetition_str, NULL, 10);
     xmlFree (repetition_str);
   } else {
-    fragment->repetitions = 1;
+    fragment.repetitions = 1;
   }
 
   if (time_str) {
-    fragment->time = g_ascii_strtoull (time_str, NULL, 10);
+    fragment.time = g_ascii_strtoull (time_str, NULL, 10);
 
     xmlFree (time_str);
-    builder->fragment_time_accum = fragment->time;
+    builder->fragment_time_accum = fragment.time;
   } else {
-    fragment->time = builder->fragment_time_accum;
+    fragment.time = builder->fragment_time_accum;
   }
 
   /* if we have a previous fragment, means we need to set its duration */
-  if (builder->previous_fragment)
-    builder->previous_fragment->duration =
-        (fragment->time -
-        builder->previous_fragment->time) /
-        builder->previous_fragment->repetitions;
+  if (builder->previous_fragment != -1) {
+    GstMssStreamFragment *previous = &g_array_index (builder->fragments,
+        GstMssStreamFragment, builder->previous_fragment);
+
+    previous->duration =
+        (fragment.time - previous->time) / previous->repetitions;
+  }
 
   if (duration_str) {
-    fragment->duration = g_ascii_strtoull (duration_str, NULL, 10);
+    fragment.duration = g_ascii_strtoull (duration_str, NULL, 10);
 
-    builder->previous_fragment = NULL;
-    builder->fragment_time_accum += fragment->duration * fragment->repetitions;
+    builder->previous_fragment = -1;
+    builder->fragment_time_accum += fragment.duration * fragment.repetitions;
     xmlFree (duration_str);
   } else {
     /* store to set the duration at the next iteration */
-    builder->previous_fragment = fragment;
+    builder->previous_fragment = builder->fragments->len;
   }
 
-  /* we reverse it later */
-  builder->fragments = g_list_prepend (builder->fragments, fragment);
+  g_array_append_val (builder->fragments, fragment);
   GST_LOG ("Adding fragment number: %u, time: %" G_GUINT64_FORMAT
       ", duration: %" G_GUINT64_FORMAT ", repetitions: %u",
-      fragment->number, fragment->time, fragment->duration,
-      fragment->repetitions);
+      fragment.number, fragment.time, fragment.duration,
+      fragment.repetitions);
+}
+
+static GstMssStreamFragment *
+gst_mss_stream_get_fragment (GstMssStream * stream, gint index)
+{
+  if (index < 0 || index >= stream->fragments->len)
+    return NULL;
+
+  return &g_array_index (stream->fragments, GstMssStreamFragment, index);
+}
+
+/* Returns the index of the first run ending after @time, or the number of
+ * runs if @time is past the end of all of them */
+static guint
+gst_mss_fragments_find (GArray * fragments, guint64 time)
+{
+  guint lo = 0, hi = fragments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstMssStreamFragment *fragment =
+        &g_array_index (fragments, GstMssStreamFragment, mid);
+
+    if (fragment->time + fragment->repetitions * fragment->duration > time)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
 }
 
 static GstBuffer *gst_buffer_from_hex_string (const gchar * s);
@@ -284,10 +316,8 @@ _gst_mss_stream_init (GstMssManifest * manifest, GstMssStream * stream,
     stream->live_adapter = gst_adapter_new ();
   }
 
-  if (builder.fragments) {
-    stream->fragments = g_list_reverse (builder.fragments);
-    stream->current_fragment = stream->fragments;
-  }
+  stream->fragments = builder.fragments;
+  stream->current_fragment = stream->fragments->len > 0 ? 0 : -1;
 
   /* order them from smaller to bigger based on bitrates */
   stream->qualities =
@@ -417,7 +447,7 @@ gst_mss_stream_free (GstMssStream * stream)
     g_object_unref (stream->live_adapter);
   }
 
-  g_list_free_full (stream->fragments, g_free);
+  g_array_free (stream->fragments, TRUE);
   g_list_free_full (stream->qualities,
       (GDestroyNotify) gst_mss_stream_quality_free);
   xmlFree (stream->url);
@@ -952,9 +982,9 @@ gst_mss_manifest_get_duration (GstMssManifest * manifest)
       GstMssStream *stream = iter->data;
 
       if (stream->active) {
-        if (stream->fragments) {
-          GList *l = g_list_last (stream->fragments);
-          GstMssStreamFragment *fragment = (GstMssStreamFragment *) l->data;
+        if (stream->fragments->len > 0) {
+          GstMssStreamFragment *fragment = gst_mss_stream_get_fragment (stream,
+              stream->fragments->len - 1);
           guint64 frag_dur =
               fragment->time + fragment->duration * fragment->repetitions;
           max_dur = MAX (frag_dur, max_dur);
@@ -1040,11 +1070,10 @@ gst_mss_stream_get_fragment_url (GstMssStream * stream, gchar ** url)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL) /* stream is over */
+  fragment = gst_mss_stream_get_fragment (stream, stream->current_fragment);
+  if (fragment == NULL)         /* stream is over */
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
-
   time =
       fragment->time + fragment->duration * stream->fragment_repetition_index;
   start_time_str = g_strdup_printf ("%" G_GUINT64_FORMAT, time);
@@ -1072,15 +1101,15 @@ gst_mss_stream_get_fragment_gst_timestamp (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_CLOCK_TIME_NONE);
 
-  if (!stream->current_fragment) {
-    GList *last = g_list_last (stream->fragments);
-    if (last == NULL)
+  fragment = gst_mss_stream_get_fragment (stream, stream->current_fragment);
+  if (fragment == NULL) {
+    fragment = gst_mss_stream_get_fragment (stream,
+        stream->fragments->len - 1);
+    if (fragment == NULL)
       return GST_CLOCK_TIME_NONE;
 
-    fragment = last->data;
     time = fragment->time + (fragment->duration * fragment->repetitions);
   } else {
-    fragment = stream->current_fragment->data;
     time =
         fragment->time +
         (fragment->duration * stream->fragment_repetition_index);
@@ -1100,11 +1129,10 @@ gst_mss_stream_get_fragment_gst_duration (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (!stream->current_fragment)
+  fragment = gst_mss_stream_get_fragment (stream, stream->current_fragment);
+  if (fragment == NULL)
     return GST_CLOCK_TIME_NONE;
 
-  fragment = stream->current_fragment->data;
-
   dur = fragment->duration;
   timescale = gst_mss_stream_get_timescale (stream);
   return (GstClockTime) gst_util_uint64_scale_round (dur, GST_SECOND,
@@ -1116,7 +1144,7 @@ gst_mss_stream_has_next_fragment (GstMssStream * stream)
 {
   g_return_val_if_fail (stream->active, FALSE);
 
-  if (stream->current_fragment == NULL)
+  if (stream->current_fragment == -1)
     return FALSE;
 
   return TRUE;
@@ -1131,20 +1159,22 @@ gst_mss_stream_advance_fragment (GstMssStream * stream)
 
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL)
+  fragment = gst_mss_stream_get_fragment (stream, stream->current_fragment);
+  if (fragment == NULL)
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
   stream->fragment_repetition_index++;
   if (stream->fragment_repetition_index < fragment->repetitions)
     goto beach;
 
   stream->fragment_repetition_index = 0;
-  stream->current_fragment = g_list_next (stream->current_fragment);
+  stream->current_fragment++;
+  if (stream->current_fragment >= stream->fragments->len)
+    stream->current_fragment = -1;
 
   GST_DEBUG ("Advanced to fragment #%d on %s stream", fragment->number,
       stream_type_name);
-  if (stream->current_fragment == NULL)
+  if (stream->current_fragment == -1)
     return GST_FLOW_EOS;
 
 beach:
@@ -1159,15 +1189,14 @@ gst_mss_stream_regress_fragment (GstMssStream * stream)
   GstMssStreamFragment *fragment;
   g_return_val_if_fail (stream->active, GST_FLOW_ERROR);
 
-  if (stream->current_fragment == NULL)
+  if (stream->current_fragment == -1)
     return GST_FLOW_EOS;
 
-  fragment = stream->current_fragment->data;
   if (stream->fragment_repetition_index == 0) {
-    stream->current_fragment = g_list_previous (stream->current_fragment);
-    if (stream->current_fragment == NULL)
+    stream->current_fragment--;
+    if (stream->current_fragment == -1)
       return GST_FLOW_EOS;
-    fragment = stream->current_fragment->data;
+    fragment = gst_mss_stream_get_fragment (stream, stream->current_fragment);
     stream->fragment_repetition_index = fragment->repetitions - 1;
   } else {
     stream->fragment_repetition_index--;
@@ -1219,7 +1248,8 @@ void
 gst_mss_stream_seek (GstMssStream * stream, gboolean forward,
     GstSeekFlags flags, guint64 time, guint64 * final_time)
 {
-  GList *iter;
+  guint index;
+  guint64 offset;
   guint64 timescale;
   GstMssStreamFragment *fragment = NULL;
 
@@ -1227,42 +1257,48 @@ gst_mss_stream_seek (GstMssStream * stream, gboolean forward,
   time = gst_util_uint64_scale_round (time, timescale, GST_SECOND);
 
   GST_DEBUG ("Stream %s seeking to %" G_GUINT64_FORMAT, stream->url, time);
-  for (iter = stream->fragments; iter; iter = g_list_next (iter)) {
-    fragment = iter->data;
-    if (fragment->time + fragment->repetitions * fragment->duration > time) {
-      stream->current_fragment = iter;
-      stream->fragment_repetition_index =
-          (time - fragment->time) / fragment->duration;
-      if (((time - fragment->time) % fragment->duration) == 0) {
-
-        /* for reverse playback, start from the previous fragment when we are
-         * exactly at a limit */
-        if (!forward)
-          stream->fragment_repetition_index--;
-      } else if (SNAP_AFTER (forward, flags))
-        stream->fragment_repetition_index++;
-
-      if (stream->fragment_repetition_index == fragment->repetitions) {
-        /* move to the next one */
-        stream->fragment_repetition_index = 0;
-        stream->current_fragment = g_list_next (iter);
+  index = gst_mss_fragments_find (stream->fragments, time);
+  fragment = gst_mss_stream_get_fragment (stream, index);
+  if (fragment) {
+    /* a time in a gap before the run, e.g. a position that has left the
+     * DVR window, is taken as the start of the run */
+    offset = time > fragment->time ? time - fragment->time : 0;
+
+    stream->current_fragment = index;
+    stream->fragment_repetition_index = offset / fragment->duration;
+    if ((offset % fragment->duration) == 0) {
+
+      /* for reverse playback, start from the previous fragment when we are
+       * exactly at a limit */
+      if (!forward)
+        stream->fragment_repetition_index--;
+    } else if (SNAP_AFTER (forward, flags))
+      stream->fragment_repetition_index++;
+
+    if (stream->fragment_repetition_index == fragment->repetitions) {
+      /* move to the next one */
+      stream->fragment_repetition_index = 0;
+      if (index + 1 < stream->fragments->len)
+        stream->current_fragment = index + 1;
+      else
+        stream->current_fragment = -1;
+      fragment =
+          gst_mss_stream_get_fragment (stream, stream->current_fragment);
+
+    } else if (stream->fragment_repetition_index == -1) {
+      if (index > 0) {
+        stream->current_fragment = index - 1;
         fragment =
-            stream->current_fragment ? stream->current_fragment->data : NULL;
-
-      } else if (stream->fragment_repetition_index == -1) {
-        if (g_list_previous (iter)) {
-          stream->current_fragment = g_list_previous (iter);
-          fragment = stream->current_fragment->data;
-          g_assert (fragment);
-          stream->fragment_repetition_index = fragment->repetitions - 1;
-        } else {
-          stream->fragment_repetition_index = 0;
-        }
+            gst_mss_stream_get_fragment (stream, stream->current_fragment);
+        stream->fragment_repetition_index = fragment->repetitions - 1;
+      } else {
+        stream->fragment_repetition_index = 0;
       }
-
-      break;
     }
-
+  } else {
+    /* past the end, the current position is left untouched */
+    fragment = gst_mss_stream_get_fragment (stream,
+        stream->fragments->len - 1);
   }
 
   GST_DEBUG ("Stream %s seeked to fragment time %" G_GUINT64_FORMAT
@@ -1274,8 +1310,9 @@ gst_mss_stream_seek (GstMssStream * stream, gboolean forward,
       *final_time = gst_util_uint64_scale_round (fragment->time +
           stream->fragment_repetition_index * fragment->duration,
           GST_SECOND, timescale);
-    } else {
-      GstMssStreamFragment *last_fragment = g_list_last (iter)->data;
+    } else if (stream->fragments->len > 0) {
+      GstMssStreamFragment *last_fragment =
+          gst_mss_stream_get_fragment (stream, stream->fragments->len - 1);
       *final_time = gst_util_uint64_scale_round (last_fragment->time +
           last_fragment->repetitions * last_fragment->duration,
           GST_SECOND, timescale);
@@ -1308,6 +1345,67 @@ gst_mss_manifest_is_live (GstMssManifest * manifest)
   return manifest->is_live;
 }
 
+/* Merges the runs of a reloaded manifest into the stream's table: runs that
+ * have left the DVR window are dropped from the head and the ones past the
+ * current end are appended, so the known entries are kept as they are.
+ * Returns FALSE if the new runs don't line up with the current ones and the
+ * table has to be replaced instead. */
+static gboolean
+gst_mss_stream_merge_fragments (GstMssStream * stream, GArray * fragments)
+{
+  GstMssStreamFragment *fragment;
+  guint64 start, end;
+  guint first_number, number;
+  guint dropped;
+  guint i;
+
+  if (stream->fragments->len == 0)
+    return FALSE;
+
+  start = g_array_index (fragments, GstMssStreamFragment, 0).time;
+  if (start < gst_mss_stream_get_fragment (stream, 0)->time)
+    return FALSE;
+
+  fragment = gst_mss_stream_get_fragment (stream, stream->fragments->len - 1);
+  end = fragment->time + fragment->duration * fragment->repetitions;
+  first_number = number = fragment->number + 1;
+
+  /* the run going over the current end must split on a fragment boundary */
+  i = gst_mss_fragments_find (fragments, end);
+  if (i < fragments->len) {
+    fragment = &g_array_index (fragments, GstMssStreamFragment, i);
+    if (fragment->time < end && (fragment->duration == 0
+            || (end - fragment->time) % fragment->duration != 0))
+      return FALSE;
+  }
+
+  dropped = gst_mss_fragments_find (stream->fragments, start);
+  if (dropped > 0) {
+    g_array_remove_range (stream->fragments, 0, dropped);
+    if (stream->current_fragment != -1)
+      stream->current_fragment =
+          MAX (stream->current_fragment - (gint) dropped, 0);
+  }
+
+  for (; i < fragments->len; i++) {
+    GstMssStreamFragment new_fragment =
+        g_array_index (fragments, GstMssStreamFragment, i);
+
+    if (new_fragment.time < end) {
+      new_fragment.repetitions -=
+          (end - new_fragment.time) / new_fragment.duration;
+      new_fragment.time = end;
+    }
+    new_fragment.number = number++;
+    g_array_append_val (stream->fragments, new_fragment);
+  }
+
+  GST_DEBUG ("Dropped %u and appended %u fragment runs, %u runs in total",
+      dropped, number - first_number, stream->fragments->len);
+
+  return TRUE;
+}
+
 static void
 gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
 {
@@ -1330,15 +1428,23 @@ gst_mss_stream_reload_fragments (GstMssStream * stream, xmlNodePtr streamIndex)
     }
   }
 
-  /* store the new fragments list */
-  if (builder.fragments) {
-    g_list_free_full (stream->fragments, g_free);
-    stream->fragments = g_list_reverse (builder.fragments);
-    stream->current_fragment = stream->fragments;
-    /* TODO Verify how repositioning here works for reverse
-     * playback - it might start from the wrong fragment */
-    gst_mss_stream_seek (stream, TRUE, 0, current_gst_time, NULL);
+  if (builder.fragments->len == 0) {
+    g_array_free (builder.fragments, TRUE);
+    return;
+  }
+
+  /* merge the new fragments into the table, or replace it */
+  if (gst_mss_stream_merge_fragments (stream, builder.fragments)) {
+    g_array_free (builder.fragments, TRUE);
+  } else {
+    g_array_free (stream->fragments, TRUE);
+    stream->fragments = builder.fragments;
+    stream->current_fragment = 0;
   }
+
+  /* TODO Verify how repositioning here works for reverse
+   * playback - it might start from the wrong fragment */
+  gst_mss_stream_seek (stream, TRUE, 0, current_gst_time, NULL);
 }
 
 static void
@@ -1430,6 +1536,30 @@ gst_mss_stream_get_current_bitrate (GstMssStream * stream)
   return q->bitrate;
 }
 
+/* qualities are sorted by increasing bitrate */
+guint64 *
+gst_mss_stream_get_bitrates (GstMssStream * stream, guint * n_bitrates,
+    guint * current)
+{
+  guint64 *bitrates;
+  GList *iter;
+  guint i = 0;
+
+  *current = 0;
+
+  bitrates = g_new (guint64, g_list_length (stream->qualities));
+  for (iter = stream->qualities; iter; iter = g_list_next (iter)) {
+    GstMssStreamQuality *q = iter->data;
+
+    if (iter == stream->current_quality)
+      *current = i;
+    bitrates[i++] = q->bitrate;
+  }
+  *n_bitrates = i;
+
+  return bitrates;
+}
+
 /**
  * gst_mss_manifest_change_bitrate:
  * @manifest: the manifest
@@ -1525,19 +1655,19 @@ static gboolean
 gst_mss_stream_get_live_seek_range (GstMssStream * stream, gint64 * start,
     gint64 * stop)
 {
-  GList *l;
   GstMssStreamFragment *fragment;
   guint64 timescale = gst_mss_stream_get_timescale (stream);
 
   g_return_val_if_fail (stream->active, FALSE);
 
+  if (stream->fragments->len == 0)
+    return FALSE;
+
   /* XXX: assumes all the data in the stream is still available */
-  l = g_list_first (stream->fragments);
-  fragment = (GstMssStreamFragment *) l->data;
+  fragment = gst_mss_stream_get_fragment (stream, 0);
   *start = gst_util_uint64_scale_round (fragment->time, GST_SECOND, timescale);
 
-  l = g_list_last (stream->fragments);
-  fragment = (GstMssStreamFragment *) l->data;
+  fragment = gst_mss_stream_get_fragment (stream, stream->fragments->len - 1);
   *stop = gst_util_uint64_scale_round (fragment->time + fragment->duration *
       fragment->repetitions, GST_SECOND, timescale);
 
@@ -1610,7 +1740,11 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
   if (!gst_mss_fragment_parser_add_buffer (&stream->fragment_parser, buffer))
     return;
 
-  current_fragment = stream->current_fragment->data;
+  current_fragment =
+      gst_mss_stream_get_fragment (stream, stream->current_fragment);
+  if (current_fragment == NULL)
+    return;
+
   current_fragment->time = stream->fragment_parser.tfxd.time;
   current_fragment->duration = stream->fragment_parser.tfxd.duration;
 
@@ -1618,33 +1752,30 @@ gst_mss_stream_parse_fragment (GstMssStream * stream, GstBuffer * buffer)
       gst_mss_stream_type_name (gst_mss_stream_get_type (stream));
 
   for (index = 0; index < stream->fragment_parser.tfrf.entries_count; index++) {
-    GList *l = g_list_last (stream->fragments);
     GstMssStreamFragment *last;
-    GstMssStreamFragment *fragment;
+    GstMssStreamFragment fragment;
     guint64 parsed_time = stream->fragment_parser.tfrf.entries[index].time;
     guint64 parsed_duration =
         stream->fragment_parser.tfrf.entries[index].duration;
 
-    if (l == NULL)
+    last = gst_mss_stream_get_fragment (stream, stream->fragments->len - 1);
+    if (last == NULL)
       break;
 
-    last = (GstMssStreamFragment *) l->data;
-
     /* only add the fragment to the list if it's outside the time in the
      * current list */
     if (last->time >= stream->fragment_parser.tfrf.entries[index].time)
       continue;
 
-    fragment = g_new (GstMssStreamFragment, 1);
-    fragment->number = last->number + 1;
-    fragment->repetitions = 1;
-    fragment->time = parsed_time;
-    fragment->duration = parsed_duration;
+    fragment.number = last->number + 1;
+    fragment.repetitions = 1;
+    fragment.time = parsed_time;
+    fragment.duration = parsed_duration;
 
-    stream->fragments = g_list_append (stream->fragments, fragment);
+    g_array_append_val (stream->fragments, fragment);
     GST_LOG ("Adding fragment number: %u to %s stream, time: %"
         G_GUINT64_FORMAT ", duration: %" G_GUINT64_FORMAT ", repetitions: %u",
-        fragment->number, stream_type_name, fragment->time,
-        fragment->duration, fragment->repetitions);
+        fragment.number, stream_type_name, fragment.time,
+        fragment.duration, fragment.repetitions);
   }
 }
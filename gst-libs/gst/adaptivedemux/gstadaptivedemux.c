@@ -123,6 +123,8 @@ that the demux object and its streams are not changed by anybody else.
 #include "gst/gst-i18n-plugin.h"
 #include <gst/base/gstadapter.h>
 
+#include <math.h>
+
 GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define GST_CAT_DEFAULT adaptivedemux_debug
 
@@ -134,6 +136,15 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_PREFETCH_DEPTH 0
+#define MAX_PREFETCH_DEPTH 16
+#define DEFAULT_ABR_ALGORITHM GST_ADAPTIVE_DEMUX_ABR_THROUGHPUT
+#define DEFAULT_ABR_BUFFER_TARGET (12 * GST_SECOND)
+#define DEFAULT_LOW_LATENCY FALSE
+
+/* In low-latency mode, gaps between buffers longer than this are taken as
+ * the server waiting for more data and not counted as download time */
+#define LOW_LATENCY_IDLE_GAP (100 * GST_MSECOND)
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
 
@@ -162,9 +173,46 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_DEPTH,
+  PROP_ABR_ALGORITHM,
+  PROP_ABR_BUFFER_TARGET,
+  PROP_LOW_LATENCY,
   PROP_LAST
 };
 
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_THROUGHPUT,
+  GST_ADAPTIVE_DEMUX_ABR_BUFFER
+} GstAdaptiveDemuxAbrAlgorithm;
+
+typedef guint64 (*GstAdaptiveDemuxAbrPolicy) (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 download_rate,
+    GstClockTime buffer_level);
+
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM \
+  (gst_adaptive_demux_abr_algorithm_get_type ())
+static GType
+gst_adaptive_demux_abr_algorithm_get_type (void)
+{
+  static GType abr_algorithm_type = 0;
+  static const GEnumValue abr_algorithms[] = {
+    {GST_ADAPTIVE_DEMUX_ABR_THROUGHPUT,
+        "Select from the measured download rate only", "throughput"},
+    {GST_ADAPTIVE_DEMUX_ABR_BUFFER,
+          "Select from the downstream buffer level (BOLA), capped by the "
+          "download rate", "buffer"},
+    {0, NULL, NULL}
+  };
+
+  if (!abr_algorithm_type) {
+    abr_algorithm_type =
+        g_enum_register_static ("GstAdaptiveDemuxAbrAlgorithm",
+        abr_algorithms);
+  }
+  return abr_algorithm_type;
+}
+
 /* Internal, so not using GST_FLOW_CUSTOM_SUCCESS_N */
 #define GST_ADAPTIVE_DEMUX_FLOW_SWITCH (GST_FLOW_CUSTOM_SUCCESS_2 + 1)
 
@@ -210,8 +258,37 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  /* number of fragments fetched ahead of the current one */
+  guint prefetch_depth;         /* protected by manifest_lock */
+  GThreadPool *prefetch_pool;   /* MT safe */
+
+  /* bitrate selection, protected by manifest_lock */
+  GstAdaptiveDemuxAbrAlgorithm abr_algorithm;
+  GstClockTime abr_buffer_target;
+
+  gboolean low_latency;         /* protected by manifest_lock */
 };
 
+/* A fragment fetched ahead of time with its own #GstUriDownloader. Owned by
+ * the stream's prefetch queue and, while downloading, by the pool thread */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  volatile gint ref_count;
+  GstAdaptiveDemuxStream *stream;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  GstUriDownloader *downloader;
+
+  /* protected by stream->fragment_download_lock */
+  gboolean done;
+  GstBuffer *buffer;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   volatile gint ref_count;
@@ -296,6 +373,9 @@ gst_adaptive_demux_stream_data_received_default (GstAdaptiveDemux * demux,
 static GstFlowReturn
 gst_adaptive_demux_stream_finish_fragment_default (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream);
+static guint64
+gst_adaptive_demux_stream_get_target_bitrate_default (GstAdaptiveDemuxStream *
+    stream, guint64 download_rate, GstClockTime buffer_level);
 static GstFlowReturn
 gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstClockTime duration);
@@ -307,6 +387,10 @@ static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
 static gboolean
 gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
     * demux);
+static void gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch *
+    prefetch, GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_stream_drop_prefetch (GstAdaptiveDemuxStream *
+    stream, guint keep);
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
  * method to get to the padtemplates */
@@ -354,6 +438,18 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_DEPTH:
+      demux->priv->prefetch_depth = g_value_get_uint (value);
+      break;
+    case PROP_ABR_ALGORITHM:
+      demux->priv->abr_algorithm = g_value_get_enum (value);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      demux->priv->abr_buffer_target = g_value_get_uint64 (value);
+      break;
+    case PROP_LOW_LATENCY:
+      demux->priv->low_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,6 +474,18 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_DEPTH:
+      g_value_set_uint (value, demux->priv->prefetch_depth);
+      break;
+    case PROP_ABR_ALGORITHM:
+      g_value_set_enum (value, demux->priv->abr_algorithm);
+      break;
+    case PROP_ABR_BUFFER_TARGET:
+      g_value_set_uint64 (value, demux->priv->abr_buffer_target);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, demux->priv->low_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -421,12 +529,80 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-depth:
+   *
+   * Number of fragments after the current one to download in parallel on
+   * each stream, so that the link doesn't stay idle for a request round
+   * trip between fragments. Only used for non-live streams whose subclass
+   * can tell the upcoming fragments in advance.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_DEPTH,
+      g_param_spec_uint ("prefetch-depth", "Prefetch depth",
+          "Number of upcoming fragments to download in parallel"
+          " (0 = disabled)", 0, MAX_PREFETCH_DEPTH, DEFAULT_PREFETCH_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-algorithm:
+   *
+   * How to pick the bitrate of the next fragment. "throughput" only looks at
+   * the measured download rate. "buffer" chooses from the amount of data
+   * buffered downstream (BOLA), which switches less often on links with
+   * varying throughput. It needs the subclass to list its bitrates and
+   * falls back to "throughput" when the buffer level can't be queried.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_ALGORITHM,
+      g_param_spec_enum ("abr-algorithm", "ABR algorithm",
+          "Algorithm used to select the bitrate of the alternates",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_ALGORITHM, DEFAULT_ABR_ALGORITHM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-buffer-target:
+   *
+   * Downstream buffer level at which the "buffer"
+   * #GstAdaptiveDemux:abr-algorithm selects the highest bitrate. Should not
+   * be above the amount of data downstream elements are able to queue.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_BUFFER_TARGET,
+      g_param_spec_uint64 ("abr-buffer-target", "ABR buffer target",
+          "Buffer level (in ns) at which the buffer-based algorithm selects"
+          " the highest bitrate", GST_SECOND, G_MAXUINT64,
+          DEFAULT_ABR_BUFFER_TARGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:low-latency:
+   *
+   * Request live fragments as soon as the server announces them as
+   * partially available, e.g. with a DASH availabilityTimeOffset, instead of
+   * waiting for them to be complete. Their data, such as the chunks of a
+   * CMAF fragment sent with chunked transfer encoding, is pushed downstream
+   * as it arrives. The download rate is then only measured while data is
+   * flowing, as the server sends each chunk once it is produced.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Request live fragments as soon as they are partially available",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
 
   klass->data_received = gst_adaptive_demux_stream_data_received_default;
   klass->finish_fragment = gst_adaptive_demux_stream_finish_fragment_default;
+  klass->stream_get_target_bitrate =
+      gst_adaptive_demux_stream_get_target_bitrate_default;
   klass->update_manifest = gst_adaptive_demux_update_manifest_default;
   klass->requires_periodical_playlist_update =
       gst_adaptive_demux_requires_periodical_playlist_update_default;
@@ -500,6 +676,10 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   g_cond_init (&demux->priv->preroll_cond);
   g_mutex_init (&demux->priv->preroll_lock);
 
+  demux->priv->prefetch_pool =
+      g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_func, demux, -1,
+      FALSE, NULL);
+
   pad_template =
       gst_element_class_get_pad_template (GST_ELEMENT_CLASS (klass), "sink");
   g_return_if_fail (pad_template != NULL);
@@ -513,6 +693,10 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_depth = DEFAULT_PREFETCH_DEPTH;
+  demux->priv->abr_algorithm = DEFAULT_ABR_ALGORITHM;
+  demux->priv->abr_buffer_target = DEFAULT_ABR_BUFFER_TARGET;
+  demux->priv->low_latency = DEFAULT_LOW_LATENCY;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -545,6 +729,9 @@ gst_adaptive_demux_finalize (GObject * object)
   g_cond_clear (&demux->priv->preroll_cond);
   g_mutex_clear (&demux->priv->preroll_lock);
 
+  /* all streams are gone, so is any pending prefetch */
+  g_thread_pool_free (priv->prefetch_pool, FALSE, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1309,6 +1496,7 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
       g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
+  stream->downstream_position = -1;
 
   g_mutex_lock (&demux->priv->preroll_lock);
   stream->do_block = TRUE;
@@ -1324,6 +1512,9 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   g_cond_init (&stream->fragment_download_cond);
   g_mutex_init (&stream->fragment_download_lock);
 
+  g_queue_init (&stream->prefetch);
+  stream->prefetch_last_end = GST_CLOCK_TIME_NONE;
+
   demux->next_streams = g_list_append (demux->next_streams, stream);
 
   return stream;
@@ -1389,6 +1580,19 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
 
+  /* the pool threads still use the stream until they are done */
+  gst_adaptive_demux_stream_drop_prefetch (stream, 0);
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&stream->fragment_download_lock);
+  while (stream->prefetch_pending > 0) {
+    g_cond_wait (&stream->fragment_download_cond,
+        &stream->fragment_download_lock);
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+  GST_MANIFEST_LOCK (demux);
+  g_list_free_full (stream->prefetch_downloaders, g_object_unref);
+  stream->prefetch_downloaders = NULL;
+
   if (stream->pending_segment) {
     gst_event_unref (stream->pending_segment);
     stream->pending_segment = NULL;
@@ -2073,6 +2277,8 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
     gst_task_stop (stream->download_task);
     g_cond_signal (&stream->fragment_download_cond);
     g_mutex_unlock (&stream->fragment_download_lock);
+
+    gst_adaptive_demux_stream_drop_prefetch (stream, 0);
   }
 
   GST_MANIFEST_UNLOCK (demux);
@@ -2238,6 +2444,162 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   return stream->current_download_rate;
 }
 
+/* Queries the position downstream of @stream for its buffer level. Must be
+ * called without the manifest_lock, the query can block in the sink */
+static void
+gst_adaptive_demux_stream_query_downstream_position (GstAdaptiveDemuxStream *
+    stream)
+{
+  gint64 position;
+
+  if (!gst_pad_peer_query_position (stream->pad, GST_FORMAT_TIME, &position))
+    position = -1;
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->downstream_position = position;
+  g_mutex_unlock (&stream->fragment_download_lock);
+}
+
+/* Returns how much of @stream is buffered downstream, from the position
+ * last reported by the sink and the position of the last pushed fragment.
+ * must be called with manifest_lock taken */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstClockTime pushed;
+  gint64 position;
+
+  if (stream->segment.rate < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  position = stream->downstream_position;
+  g_mutex_unlock (&stream->fragment_download_lock);
+  if (position < 0)
+    return GST_CLOCK_TIME_NONE;
+
+  pushed = gst_segment_to_stream_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  if (!GST_CLOCK_TIME_IS_VALID (pushed))
+    return GST_CLOCK_TIME_NONE;
+
+  return pushed > position ? pushed - position : 0;
+}
+
+/* Throughput based selection: the measured download rate */
+static guint64
+gst_adaptive_demux_abr_throughput (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 download_rate,
+    GstClockTime buffer_level)
+{
+  return download_rate;
+}
+
+/* Buffer occupancy based selection (BOLA, Spiteri et al.) with the
+ * throughput cap of BOLA-O: picks the bitrate maximizing
+ * (V * (utility + gamma) - buffer level) / bitrate, where the utility of a
+ * bitrate is the log of its ratio to the lowest one. V and gamma are set so
+ * that the lowest bitrate is used below half the buffer target and the
+ * highest one from the buffer target on */
+static guint64
+gst_adaptive_demux_abr_bola (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, guint64 download_rate,
+    GstClockTime buffer_level)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  guint64 *bitrates, ret;
+  guint n_bitrates = 0, current = 0, i, best;
+  gdouble min_buffer, gp, vp, best_score;
+
+  if (klass->stream_get_bitrates == NULL)
+    return download_rate;
+
+  if (!GST_CLOCK_TIME_IS_VALID (buffer_level)) {
+    GST_LOG_OBJECT (stream->pad, "Unknown buffer level, using download rate");
+    return download_rate;
+  }
+
+  bitrates = klass->stream_get_bitrates (stream, &n_bitrates, &current);
+  if (bitrates == NULL || n_bitrates < 2 || current >= n_bitrates
+      || bitrates[0] == 0 || bitrates[n_bitrates - 1] <= bitrates[0]) {
+    g_free (bitrates);
+    return download_rate;
+  }
+
+  min_buffer = (gdouble) demux->priv->abr_buffer_target / GST_SECOND / 2;
+  gp = log ((gdouble) bitrates[n_bitrates - 1] / bitrates[0]);
+  vp = min_buffer / gp;
+
+  best = 0;
+  best_score = -G_MAXDOUBLE;
+  for (i = 0; i < n_bitrates; i++) {
+    gdouble utility = log ((gdouble) bitrates[i] / bitrates[0]) + 1;
+    gdouble score = (vp * (utility + gp) -
+        (gdouble) buffer_level / GST_SECOND) / bitrates[i];
+
+    if (score >= best_score) {
+      best_score = score;
+      best = i;
+    }
+  }
+
+  /* Only go above what the link sustains when already there, the buffer
+   * would drain while downloading otherwise */
+  if (bitrates[best] > download_rate) {
+    guint safe = 0;
+
+    for (i = 0; i < n_bitrates; i++) {
+      if (bitrates[i] <= download_rate)
+        safe = i;
+    }
+    best = MIN (best, MAX (safe, current));
+  }
+
+  GST_DEBUG_OBJECT (stream->pad, "Buffer level %" GST_TIME_FORMAT
+      ", download rate %" G_GUINT64_FORMAT ", selecting %" G_GUINT64_FORMAT,
+      GST_TIME_ARGS (buffer_level), download_rate, bitrates[best]);
+
+  ret = bitrates[best];
+  g_free (bitrates);
+
+  return ret;
+}
+
+/* The built-in policies, indexed by #GstAdaptiveDemux:abr-algorithm */
+static const GstAdaptiveDemuxAbrPolicy abr_policies[] = {
+  gst_adaptive_demux_abr_throughput,
+  gst_adaptive_demux_abr_bola
+};
+
+/* must be called with manifest_lock taken */
+static guint64
+gst_adaptive_demux_stream_get_target_bitrate_default (GstAdaptiveDemuxStream *
+    stream, guint64 download_rate, GstClockTime buffer_level)
+{
+  GstAdaptiveDemux *demux = stream->demux;
+
+  return abr_policies[demux->priv->abr_algorithm] (demux, stream,
+      download_rate, buffer_level);
+}
+
+/* must be called with manifest_lock taken */
+static guint64
+gst_adaptive_demux_stream_get_target_bitrate (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  guint64 bitrate;
+
+  bitrate = gst_adaptive_demux_stream_update_current_bitrate (demux, stream);
+
+  if (klass->stream_get_target_bitrate && !demux->connection_speed)
+    bitrate = klass->stream_get_target_bitrate (stream, bitrate,
+        gst_adaptive_demux_stream_get_buffer_level (demux, stream));
+
+  return bitrate;
+}
+
 /* must be called with manifest_lock taken */
 static GstFlowReturn
 gst_adaptive_demux_combine_flows (GstAdaptiveDemux * demux)
@@ -2494,27 +2856,22 @@ gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
   return TRUE;
 }
 
+/* must be called with manifest_lock taken.
+ * Handles a buffer of the fragment being downloaded, whether it comes from
+ * the source element or from the prefetch queue */
 static GstFlowReturn
-_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_adaptive_demux_stream_handle_data (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
-  GstAdaptiveDemuxStream *stream;
-  GstAdaptiveDemux *demux;
-  GstAdaptiveDemuxClass *klass;
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
   GstFlowReturn ret = GST_FLOW_OK;
 
-  demux = GST_ADAPTIVE_DEMUX_CAST (parent);
-  stream = gst_pad_get_element_private (pad);
-  klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
-
-  GST_MANIFEST_LOCK (demux);
-
   /* do not make any changes if the stream is cancelled */
   g_mutex_lock (&stream->fragment_download_lock);
   if (G_UNLIKELY (stream->cancelled)) {
     g_mutex_unlock (&stream->fragment_download_lock);
     gst_buffer_unref (buffer);
     ret = stream->last_ret = GST_FLOW_FLUSHING;
-    GST_MANIFEST_UNLOCK (demux);
     return ret;
   }
   g_mutex_unlock (&stream->fragment_download_lock);
@@ -2611,7 +2968,6 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     g_mutex_lock (&stream->fragment_download_lock);
     if (G_UNLIKELY (stream->cancelled)) {
       g_mutex_unlock (&stream->fragment_download_lock);
-      GST_MANIFEST_UNLOCK (demux);
       return ret;
     }
     g_mutex_unlock (&stream->fragment_download_lock);
@@ -2650,7 +3006,18 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   }
 
 error:
+  return ret;
+}
 
+static GstFlowReturn
+_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstAdaptiveDemux *demux = GST_ADAPTIVE_DEMUX_CAST (parent);
+  GstAdaptiveDemuxStream *stream = gst_pad_get_element_private (pad);
+  GstFlowReturn ret;
+
+  GST_MANIFEST_LOCK (demux);
+  ret = gst_adaptive_demux_stream_handle_data (demux, stream, buffer);
   GST_MANIFEST_UNLOCK (demux);
 
   return ret;
@@ -2705,6 +3072,11 @@ _src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_EOS:{
       GST_DEBUG_OBJECT (pad, "Saw EOS on src pad");
+
+      /* the bitrate for the next fragment is selected while handling EOS,
+       * the buffer level for that is queried before locking */
+      gst_adaptive_demux_stream_query_downstream_position (stream);
+
       GST_MANIFEST_LOCK (demux);
 
       gst_adaptive_demux_eos_handling (stream);
@@ -2754,14 +3126,20 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
 
   if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
     GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime now = gst_adaptive_demux_get_monotonic_time (stream->demux);
+
     if (stream->fragment_bytes_downloaded == 0) {
-      stream->last_latency =
-          gst_adaptive_demux_get_monotonic_time (stream->demux) -
-          (stream->download_start_time * GST_USECOND);
+      stream->last_latency = now - (stream->download_start_time * GST_USECOND);
+      stream->fragment_busy_time = 0;
+      stream->fragment_busy_bytes = 0;
       GST_DEBUG_OBJECT (pad,
           "FIRST BYTE since download_start %" GST_TIME_FORMAT,
           GST_TIME_ARGS (stream->last_latency));
+    } else if (now - stream->fragment_last_buffer_time < LOW_LATENCY_IDLE_GAP) {
+      stream->fragment_busy_time += now - stream->fragment_last_buffer_time;
+      stream->fragment_busy_bytes += gst_buffer_get_size (buf);
     }
+    stream->fragment_last_buffer_time = now;
     stream->fragment_bytes_downloaded += gst_buffer_get_size (buf);
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
@@ -2780,9 +3158,16 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
         stream->last_download_time =
             gst_adaptive_demux_get_monotonic_time (stream->demux) -
             (stream->download_start_time * GST_USECOND);
-        stream->last_bitrate =
-            gst_util_uint64_scale (stream->fragment_bytes_downloaded,
-            8 * GST_SECOND, stream->last_download_time);
+        /* A low-latency fragment arrives at the pace it is produced at, so
+         * leave out the time spent waiting for the next chunk */
+        if (stream->fragment_low_latency && stream->fragment_busy_time > 0)
+          stream->last_bitrate =
+              gst_util_uint64_scale (stream->fragment_busy_bytes,
+              8 * GST_SECOND, stream->fragment_busy_time);
+        else
+          stream->last_bitrate =
+              gst_util_uint64_scale (stream->fragment_bytes_downloaded,
+              8 * GST_SECOND, stream->last_download_time);
         GST_DEBUG_OBJECT (pad,
             "EOS since download_start %" GST_TIME_FORMAT " bitrate %"
             G_GUINT64_FORMAT " bps", GST_TIME_ARGS (stream->last_download_time),
@@ -3138,6 +3523,9 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
     if (G_LIKELY (stream->last_ret == GST_FLOW_OK)) {
       stream->download_start_time =
           GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+      /* the probe runs on the source's streaming thread without the
+       * manifest lock, so it uses this copy */
+      stream->fragment_low_latency = demux->priv->low_latency;
 
       /* src element is in state READY. Before we start it, we reset
        * download_finished
@@ -3285,6 +3673,290 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_ref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_atomic_int_inc (&prefetch->ref_count);
+  return prefetch;
+}
+
+static void
+gst_adaptive_demux_prefetch_unref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (g_atomic_int_dec_and_test (&prefetch->ref_count)) {
+    g_free (prefetch->uri);
+    if (prefetch->downloader)
+      g_object_unref (prefetch->downloader);
+    if (prefetch->buffer)
+      gst_buffer_unref (prefetch->buffer);
+    g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+  }
+}
+
+static gboolean
+gst_adaptive_demux_prefetch_matches (GstAdaptiveDemuxPrefetch * prefetch,
+    const GstAdaptiveDemuxStreamFragment * fragment)
+{
+  return g_strcmp0 (prefetch->uri, fragment->uri) == 0
+      && prefetch->range_start == fragment->range_start
+      && prefetch->range_end == fragment->range_end;
+}
+
+/* runs in the prefetch pool, without any demux lock */
+static void
+gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxStream *stream = prefetch->stream;
+  GstFragment *download;
+  GstBuffer *buffer = NULL;
+  GstClockTime start, end;
+  gint64 range_end = prefetch->range_end;
+  GError *err = NULL;
+
+  /* HTTP ranges are inclusive, GStreamer segments are exclusive for the
+   * stop position */
+  if (range_end != -1)
+    range_end += 1;
+
+  start = gst_adaptive_demux_get_monotonic_time (demux);
+  download = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      range_end, &err);
+  end = gst_adaptive_demux_get_monotonic_time (demux);
+
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    g_object_unref (download);
+  } else {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetching %s failed: %s", prefetch->uri,
+        err ? err->message : "cancelled");
+    g_clear_error (&err);
+  }
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  /* Downloads overlap, so measure from the end of the previous one to get
+   * the throughput of the link rather than the one of each connection */
+  if (GST_CLOCK_TIME_IS_VALID (stream->prefetch_last_end)) {
+    start = MAX (start, stream->prefetch_last_end);
+    stream->prefetch_last_end = MAX (end, stream->prefetch_last_end);
+  } else {
+    stream->prefetch_last_end = end;
+  }
+  prefetch->download_time = end > start ? end - start : 0;
+  prefetch->buffer = buffer;
+  prefetch->done = TRUE;
+  stream->prefetch_pending--;
+  g_cond_broadcast (&stream->fragment_download_cond);
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  gst_adaptive_demux_prefetch_unref (prefetch);
+}
+
+/* must be called with manifest_lock taken.
+ * Cancels and drops everything after the first @keep queued fragments */
+static void
+gst_adaptive_demux_stream_drop_prefetch (GstAdaptiveDemuxStream * stream,
+    guint keep)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  while (g_queue_get_length (&stream->prefetch) > keep) {
+    prefetch = g_queue_pop_tail (&stream->prefetch);
+    GST_DEBUG_OBJECT (stream->pad, "Dropping prefetched fragment %s",
+        prefetch->uri);
+    gst_uri_downloader_cancel (prefetch->downloader);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  }
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_queue_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream,
+    const GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  GST_DEBUG_OBJECT (stream->pad, "Prefetching %s, range:%" G_GINT64_FORMAT
+      " - %" G_GINT64_FORMAT, fragment->uri, fragment->range_start,
+      fragment->range_end);
+
+  prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+  prefetch->ref_count = 1;
+  prefetch->stream = stream;
+  prefetch->uri = g_strdup (fragment->uri);
+  prefetch->range_start = fragment->range_start;
+  prefetch->range_end = fragment->range_end;
+  prefetch->download_time = GST_CLOCK_TIME_NONE;
+
+  /* re-use the downloaders of consumed fragments */
+  if (stream->prefetch_downloaders) {
+    prefetch->downloader = stream->prefetch_downloaders->data;
+    stream->prefetch_downloaders =
+        g_list_delete_link (stream->prefetch_downloaders,
+        stream->prefetch_downloaders);
+    gst_uri_downloader_reset (prefetch->downloader);
+  } else {
+    prefetch->downloader = gst_uri_downloader_new ();
+    gst_uri_downloader_set_parent (prefetch->downloader,
+        GST_ELEMENT_CAST (demux));
+  }
+
+  g_queue_push_tail (&stream->prefetch, prefetch);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->prefetch_pending++;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  g_thread_pool_push (demux->priv->prefetch_pool,
+      gst_adaptive_demux_prefetch_ref (prefetch), NULL);
+}
+
+/* must be called with manifest_lock taken.
+ * Makes the prefetch queue hold the current fragment followed by up to
+ * prefetch-depth upcoming ones, dropping whatever doesn't match anymore
+ * after a seek or a bitrate switch */
+static void
+gst_adaptive_demux_stream_update_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxStreamFragment *next;
+  GstAdaptiveDemuxPrefetch *prefetch;
+  guint depth = demux->priv->prefetch_depth;
+  guint n, n_next = 0;
+
+  /* live fragments might not be available yet and key unit trick modes
+   * only download parts of each fragment */
+  if (depth == 0 || klass->stream_peek_fragment == NULL
+      || stream->fragment.uri == NULL || gst_adaptive_demux_is_live (demux)
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (demux)) {
+    gst_adaptive_demux_stream_drop_prefetch (stream, 0);
+    return;
+  }
+
+  next = g_new0 (GstAdaptiveDemuxStreamFragment, depth);
+  for (n = 0; n < depth; n++) {
+    next[n].timestamp = next[n].duration = GST_CLOCK_TIME_NONE;
+    next[n].range_end = -1;
+    if (klass->stream_peek_fragment (stream, n + 1, &next[n]) != GST_FLOW_OK)
+      break;
+    n_next++;
+  }
+
+  /* nothing known ahead of the current fragment, don't bother */
+  if (n_next == 0 && g_queue_is_empty (&stream->prefetch))
+    goto done;
+
+  for (n = 0; n <= n_next; n++) {
+    const GstAdaptiveDemuxStreamFragment *fragment =
+        n == 0 ? &stream->fragment : &next[n - 1];
+
+    prefetch = g_queue_peek_nth (&stream->prefetch, n);
+    if (prefetch && !gst_adaptive_demux_prefetch_matches (prefetch, fragment)) {
+      gst_adaptive_demux_stream_drop_prefetch (stream, n);
+      prefetch = NULL;
+    }
+    if (prefetch == NULL)
+      gst_adaptive_demux_stream_queue_prefetch (demux, stream, fragment);
+  }
+  gst_adaptive_demux_stream_drop_prefetch (stream, n_next + 1);
+
+done:
+  for (n = 0; n < depth; n++)
+    gst_adaptive_demux_stream_fragment_clear (&next[n]);
+  g_free (next);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock.
+ * Pushes the current fragment from the prefetch queue. Returns FALSE if it
+ * wasn't prefetched or the prefetch failed, in which case it has to be
+ * downloaded the usual way */
+static gboolean
+gst_adaptive_demux_stream_take_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstFlowReturn * ret)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+  GstClockTime download_time;
+  GstBuffer *buffer;
+  gsize size;
+
+  prefetch = g_queue_peek_head (&stream->prefetch);
+  if (prefetch == NULL
+      || !gst_adaptive_demux_prefetch_matches (prefetch, &stream->fragment))
+    return FALSE;
+  g_queue_pop_head (&stream->prefetch);
+
+  GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetched fragment %s",
+      prefetch->uri);
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&stream->fragment_download_lock);
+  while (!stream->cancelled && !prefetch->done) {
+    g_cond_wait (&stream->fragment_download_cond,
+        &stream->fragment_download_lock);
+  }
+  buffer = prefetch->buffer;
+  prefetch->buffer = NULL;
+  download_time = prefetch->download_time;
+  g_mutex_unlock (&stream->fragment_download_lock);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    gst_uri_downloader_cancel (prefetch->downloader);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+    if (buffer)
+      gst_buffer_unref (buffer);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  stream->prefetch_downloaders =
+      g_list_prepend (stream->prefetch_downloaders, prefetch->downloader);
+  prefetch->downloader = NULL;
+  gst_adaptive_demux_prefetch_unref (prefetch);
+
+  if (buffer == NULL) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch failed, downloading again");
+    return FALSE;
+  }
+
+  /* what the uri_handler probe measures for regular downloads */
+  size = gst_buffer_get_size (buffer);
+  stream->fragment_bytes_downloaded = size;
+  if (download_time > 0) {
+    stream->last_download_time = download_time;
+    stream->last_bitrate =
+        gst_util_uint64_scale (size, 8 * GST_SECOND, download_time);
+  }
+  if (stream->fragment.bitrate == 0 &&
+      GST_CLOCK_TIME_IS_VALID (stream->fragment.duration) &&
+      stream->fragment.duration != 0) {
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+  }
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (gst_adaptive_demux_stream_handle_data (demux, stream,
+          buffer) == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  *ret = stream->last_ret;
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3402,6 +4074,9 @@ again:
       if (range_end != -1)
         chunk_end = MIN (chunk_end, range_end);
     }
+  } else if (gst_adaptive_demux_stream_take_prefetch (demux, stream, &ret)) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetched fragment result: %d %s",
+        stream->last_ret, gst_flow_get_name (stream->last_ret));
   } else {
     ret =
         gst_adaptive_demux_stream_download_uri (demux, stream, url,
@@ -3721,6 +4396,8 @@ gst_adaptive_demux_stream_download_loop (GstAdaptiveDemuxStream * stream)
 
     stream->last_ret = GST_FLOW_OK;
 
+    gst_adaptive_demux_stream_update_prefetch (demux, stream);
+
     next_download = gst_adaptive_demux_get_monotonic_time (demux);
     ret = gst_adaptive_demux_stream_download_fragment (stream);
 
@@ -4185,7 +4862,7 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
 
   if (ret == GST_FLOW_OK) {
     if (gst_adaptive_demux_stream_select_bitrate (demux, stream,
-            gst_adaptive_demux_stream_update_current_bitrate (demux, stream))) {
+            gst_adaptive_demux_stream_get_target_bitrate (demux, stream))) {
       stream->need_header = TRUE;
       ret = (GstFlowReturn) GST_ADAPTIVE_DEMUX_FLOW_SWITCH;
     }
@@ -4399,6 +5076,24 @@ gst_adaptive_demux_advance_period (GstAdaptiveDemux * demux)
   gst_adaptive_demux_start_tasks (demux, TRUE);
 }
 
+/**
+ * gst_adaptive_demux_is_low_latency:
+ * @demux: #GstAdaptiveDemux
+ *
+ * Must be called with the manifest lock taken, as from the stream vfuncs.
+ *
+ * Returns: %TRUE if live fragments should be requested as soon as they are
+ * partially available, see #GstAdaptiveDemux:low-latency.
+ *
+ * Since: 1.14
+ */
+gboolean
+gst_adaptive_demux_is_low_latency (GstAdaptiveDemux * demux)
+{
+  g_return_val_if_fail (demux != NULL, FALSE);
+  return demux->priv->low_latency;
+}
+
 /**
  * gst_adaptive_demux_get_monotonic_time:
  * Returns: a monotonically increasing time, using the system realtime clock
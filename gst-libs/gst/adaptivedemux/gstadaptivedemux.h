@@ -176,6 +176,16 @@ struct _GstAdaptiveDemuxStream
    * of previous fragment (pre-queue2) */
   GstClockTime last_latency;
   GstClockTime last_download_time;
+  /* data received while the transfer was not idle, and arrival time of the
+   * last buffer, in the current fragment (pre-queue2) */
+  GstClockTime fragment_busy_time;
+  guint64 fragment_busy_bytes;
+  GstClockTime fragment_last_buffer_time;
+  /* low-latency setting when the current download was started */
+  gboolean fragment_low_latency;
+  /* position reported downstream at the end of the last fragment,
+   * -1 if unknown. Protected by fragment_download_lock */
+  gint64 downstream_position;
 
   /* Average for the last fragments */
   guint64 moving_bitrate;
@@ -193,6 +203,12 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* fragments fetched ahead of the current one, in playback order */
+  GQueue prefetch;              /* protected by manifest_lock */
+  GList *prefetch_downloaders;  /* idle downloaders, protected by manifest_lock */
+  guint prefetch_pending;       /* protected by fragment_download_lock */
+  GstClockTime prefetch_last_end; /* protected by fragment_download_lock */
 };
 
 /**
@@ -369,6 +385,23 @@ struct _GstAdaptiveDemuxClass
    *          if there is no fragment.
    */
   GstFlowReturn (*stream_update_fragment_info) (GstAdaptiveDemuxStream * stream);
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n: how many fragments after the current one to look, starting at 1
+   * @fragment: #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Sets the uri, byte range, timestamp and duration of the fragment @n
+   * positions after the current one, without changing the stream's
+   * position. Used to fetch fragments ahead of time when the
+   * #GstAdaptiveDemux:prefetch-depth property is set.
+   *
+   * Returns: #GST_FLOW_OK in success, #GST_FLOW_EOS if there is no such
+   *          fragment or it can't be known in advance.
+   *
+   * Since: 1.14
+   */
+  GstFlowReturn (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
   /**
    * stream_select_bitrate:
    * @stream: #GstAdaptiveDemuxStream
@@ -383,6 +416,40 @@ struct _GstAdaptiveDemuxClass
    * Returns: #TRUE if the stream changed bitrate, #FALSE otherwise
    */
   gboolean      (*stream_select_bitrate) (GstAdaptiveDemuxStream * stream, guint64 bitrate);
+  /**
+   * stream_get_bitrates:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n_bitrates: (out): the number of bitrates returned
+   * @current: (out): the index of the bitrate @stream currently uses
+   *
+   * Lists the nominal bitrates of the alternates @stream can switch between,
+   * in increasing order. Needed by the "buffer"
+   * #GstAdaptiveDemux:abr-algorithm.
+   *
+   * Returns: (transfer full): a newly allocated array of bitrates, or %NULL
+   *
+   * Since: 1.14
+   */
+  guint64 *     (*stream_get_bitrates) (GstAdaptiveDemuxStream * stream, guint * n_bitrates, guint * current);
+  /**
+   * stream_get_target_bitrate:
+   * @stream: #GstAdaptiveDemuxStream
+   * @download_rate: the download rate measured for @stream, in bits per second
+   * @buffer_level: how much of @stream is buffered downstream, or
+   *     #GST_CLOCK_TIME_NONE if unknown
+   *
+   * The bitrate adaptation policy. Returns the bitrate that is passed to
+   * stream_select_bitrate() for the next fragment. The default
+   * implementation uses the policy chosen by
+   * #GstAdaptiveDemux:abr-algorithm, subclasses can replace it or chain up
+   * to adjust its result. Not called if #GstAdaptiveDemux:connection-speed
+   * is set.
+   *
+   * Returns: the target bitrate, in bits per second
+   *
+   * Since: 1.14
+   */
+  guint64       (*stream_get_target_bitrate) (GstAdaptiveDemuxStream * stream, guint64 download_rate, GstClockTime buffer_level);
   /**
    * stream_get_fragment_waiting_time:
    * @stream: #GstAdaptiveDemuxStream
@@ -521,6 +588,9 @@ GST_EXPORT
 void gst_adaptive_demux_stream_queue_event (GstAdaptiveDemuxStream * stream,
     GstEvent * event);
 
+GST_EXPORT
+gboolean gst_adaptive_demux_is_low_latency (GstAdaptiveDemux * demux);
+
 GST_EXPORT
 GstClockTime gst_adaptive_demux_get_monotonic_time (GstAdaptiveDemux * demux);
 
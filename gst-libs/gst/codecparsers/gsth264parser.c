@@ -2041,24 +2041,13 @@ gst_h264_pps_clear (GstH264PPS * pps)
   pps->slice_group_id = NULL;
 }
 
-/**
- * gst_h264_parser_parse_slice_hdr:
- * @nalparser: a #GstH264NalParser
- * @nalu: The #GST_H264_NAL_SLICE to #GST_H264_NAL_SLICE_IDR #GstH264NalUnit to parse
- * @slice: The #GstH264SliceHdr to fill.
- * @parse_pred_weight_table: Whether to parse the pred_weight_table or not
- * @parse_dec_ref_pic_marking: Whether to parse the dec_ref_pic_marking or not
- *
- * Parses @nalu containing a coded slice, and fills @slice.
- *
- * Returns: a #GstH264ParserResult
- */
-GstH264ParserResult
-gst_h264_parser_parse_slice_hdr (GstH264NalParser * nalparser,
-    GstH264NalUnit * nalu, GstH264SliceHdr * slice,
-    gboolean parse_pred_weight_table, gboolean parse_dec_ref_pic_marking)
+/* Parses the slice header up to the fields used by 7.4.1.2.4 to detect
+ * the first VCL NAL unit of a new primary coded picture, leaving @nr
+ * positioned right after them */
+static GstH264ParserResult
+gst_h264_parser_parse_slice_hdr_start (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SliceHdr * slice, NalReader * nr)
 {
-  NalReader nr;
   gint pps_id;
   GstH264PPS *pps;
   GstH264SPS *sps;
@@ -2070,15 +2059,15 @@ gst_h264_parser_parse_slice_hdr (GstH264NalParser * nalparser,
     return GST_H264_PARSER_ERROR;
   }
 
-  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+  nal_reader_init (nr, nalu->data + nalu->offset + nalu->header_bytes,
       nalu->size - nalu->header_bytes);
 
-  READ_UE (&nr, slice->first_mb_in_slice);
-  READ_UE (&nr, slice->type);
+  READ_UE (nr, slice->first_mb_in_slice);
+  READ_UE (nr, slice->type);
 
   GST_DEBUG ("parsing \"Slice header\", slice type %u", slice->type);
 
-  READ_UE_MAX (&nr, pps_id, GST_H264_MAX_PPS_COUNT - 1);
+  READ_UE_MAX (nr, pps_id, GST_H264_MAX_PPS_COUNT - 1);
   pps = gst_h264_parser_get_pps (nalparser, pps_id);
 
   if (!pps) {
@@ -2108,14 +2097,14 @@ gst_h264_parser_parse_slice_hdr (GstH264NalParser * nalparser,
   slice->num_ref_idx_l1_active_minus1 = pps->num_ref_idx_l1_active_minus1;
 
   if (sps->separate_colour_plane_flag)
-    READ_UINT8 (&nr, slice->colour_plane_id, 2);
+    READ_UINT8 (nr, slice->colour_plane_id, 2);
 
-  READ_UINT16 (&nr, slice->frame_num, sps->log2_max_frame_num_minus4 + 4);
+  READ_UINT16 (nr, slice->frame_num, sps->log2_max_frame_num_minus4 + 4);
 
   if (!sps->frame_mbs_only_flag) {
-    READ_UINT8 (&nr, slice->field_pic_flag, 1);
+    READ_UINT8 (nr, slice->field_pic_flag, 1);
     if (slice->field_pic_flag)
-      READ_UINT8 (&nr, slice->bottom_field_flag, 1);
+      READ_UINT8 (nr, slice->bottom_field_flag, 1);
   }
 
   /* calculate MaxPicNum */
@@ -2125,22 +2114,58 @@ gst_h264_parser_parse_slice_hdr (GstH264NalParser * nalparser,
     slice->max_pic_num = sps->max_frame_num;
 
   if (nalu->idr_pic_flag)
-    READ_UE_MAX (&nr, slice->idr_pic_id, G_MAXUINT16);
+    READ_UE_MAX (nr, slice->idr_pic_id, G_MAXUINT16);
 
   if (sps->pic_order_cnt_type == 0) {
-    READ_UINT16 (&nr, slice->pic_order_cnt_lsb,
+    READ_UINT16 (nr, slice->pic_order_cnt_lsb,
         sps->log2_max_pic_order_cnt_lsb_minus4 + 4);
 
     if (pps->pic_order_present_flag && !slice->field_pic_flag)
-      READ_SE (&nr, slice->delta_pic_order_cnt_bottom);
+      READ_SE (nr, slice->delta_pic_order_cnt_bottom);
   }
 
   if (sps->pic_order_cnt_type == 1 && !sps->delta_pic_order_always_zero_flag) {
-    READ_SE (&nr, slice->delta_pic_order_cnt[0]);
+    READ_SE (nr, slice->delta_pic_order_cnt[0]);
     if (pps->pic_order_present_flag && !slice->field_pic_flag)
-      READ_SE (&nr, slice->delta_pic_order_cnt[1]);
+      READ_SE (nr, slice->delta_pic_order_cnt[1]);
   }
 
+  return GST_H264_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Slice header\"");
+  return GST_H264_PARSER_ERROR;
+}
+
+/**
+ * gst_h264_parser_parse_slice_hdr:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_SLICE to #GST_H264_NAL_SLICE_IDR #GstH264NalUnit to parse
+ * @slice: The #GstH264SliceHdr to fill.
+ * @parse_pred_weight_table: Whether to parse the pred_weight_table or not
+ * @parse_dec_ref_pic_marking: Whether to parse the dec_ref_pic_marking or not
+ *
+ * Parses @nalu containing a coded slice, and fills @slice.
+ *
+ * Returns: a #GstH264ParserResult
+ */
+GstH264ParserResult
+gst_h264_parser_parse_slice_hdr (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SliceHdr * slice,
+    gboolean parse_pred_weight_table, gboolean parse_dec_ref_pic_marking)
+{
+  NalReader nr;
+  GstH264ParserResult res;
+  GstH264PPS *pps;
+  GstH264SPS *sps;
+
+  res = gst_h264_parser_parse_slice_hdr_start (nalparser, nalu, slice, &nr);
+  if (res != GST_H264_PARSER_OK)
+    return res;
+
+  pps = slice->pps;
+  sps = pps->sequence;
+
   if (pps->redundant_pic_cnt_present_flag)
     READ_UE_MAX (&nr, slice->redundant_pic_cnt, G_MAXINT8);
 
@@ -2220,6 +2245,35 @@ error:
   return GST_H264_PARSER_ERROR;
 }
 
+/**
+ * gst_h264_parser_parse_slice_hdr_light:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_SLICE to #GST_H264_NAL_SLICE_IDR #GstH264NalUnit to parse
+ * @slice: The #GstH264SliceHdr to fill.
+ *
+ * Parses the start of the slice header in @nalu, up to and including the
+ * fields needed to detect the first slice of a new picture: first_mb_in_slice,
+ * slice type, the picture parameter set, frame_num, the field flags,
+ * idr_pic_id and the picture order count fields. The remaining fields of
+ * @slice, including header_size and n_emulation_prevention_bytes, are left
+ * zeroed.
+ *
+ * This is much cheaper than gst_h264_parser_parse_slice_hdr() for callers
+ * that only need to find access unit boundaries and keyframes.
+ *
+ * Returns: a #GstH264ParserResult
+ *
+ * Since: 1.14
+ */
+GstH264ParserResult
+gst_h264_parser_parse_slice_hdr_light (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SliceHdr * slice)
+{
+  NalReader nr;
+
+  return gst_h264_parser_parse_slice_hdr_start (nalparser, nalu, slice, &nr);
+}
+
 /* Free MVC-specific data from subset SPS header */
 static void
 gst_h264_sps_mvc_clear (GstH264SPS * sps)
@@ -1875,31 +1875,18 @@ gst_h265_parser_parse_pps (GstH265Parser * parser,
   return res;
 }
 
-/**
- * gst_h265_parser_parse_slice_hdr:
- * @parser: a #GstH265Parser
- * @nalu: The #GST_H265_NAL_SLICE #GstH265NalUnit to parse
- * @slice: The #GstH265SliceHdr to fill.
- *
- * Parses @data, and fills the @slice structure.
- * The resulting @slice_hdr structure shall be deallocated with
- * gst_h265_slice_hdr_free() when it is no longer needed
- *
- * Returns: a #GstH265ParserResult
- */
-GstH265ParserResult
-gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
-    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+/* Parses the slice segment header up to slice_pic_order_cnt_lsb, which
+ * covers everything needed to find the first slice segment of a picture
+ * and its type, leaving @nr positioned right after it */
+static GstH265ParserResult
+gst_h265_parser_parse_slice_hdr_start (GstH265Parser * parser,
+    GstH265NalUnit * nalu, GstH265SliceHdr * slice, NalReader * nr)
 {
-  NalReader nr;
   gint pps_id;
   GstH265PPS *pps;
   GstH265SPS *sps;
   guint i;
-  GstH265ShortTermRefPicSet *stRPS = NULL;
-  guint32 UsedByCurrPicLt[16];
   guint32 PicSizeInCtbsY;
-  gint NumPocTotalCurr = 0;
 
   memset (slice, 0, sizeof (*slice));
 
@@ -1908,18 +1895,18 @@ gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
     return GST_H265_PARSER_ERROR;
   }
 
-  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+  nal_reader_init (nr, nalu->data + nalu->offset + nalu->header_bytes,
       nalu->size - nalu->header_bytes);
 
   GST_DEBUG ("parsing \"Slice header\", slice type");
 
-  READ_UINT8 (&nr, slice->first_slice_segment_in_pic_flag, 1);
+  READ_UINT8 (nr, slice->first_slice_segment_in_pic_flag, 1);
 
   if (nalu->type >= GST_H265_NAL_SLICE_BLA_W_LP
       && nalu->type <= RESERVED_IRAP_NAL_TYPE_MAX)
-    READ_UINT8 (&nr, slice->no_output_of_prior_pics_flag, 1);
+    READ_UINT8 (nr, slice->no_output_of_prior_pics_flag, 1);
 
-  READ_UE_MAX (&nr, pps_id, GST_H265_MAX_PPS_COUNT - 1);
+  READ_UE_MAX (nr, pps_id, GST_H265_MAX_PPS_COUNT - 1);
   pps = gst_h265_parser_get_pps (parser, pps_id);
   if (!pps) {
     GST_WARNING
@@ -1951,27 +1938,69 @@ gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
     const guint n = ceil_log2 (PicSizeInCtbsY);
 
     if (pps->dependent_slice_segments_enabled_flag)
-      READ_UINT8 (&nr, slice->dependent_slice_segment_flag, 1);
+      READ_UINT8 (nr, slice->dependent_slice_segment_flag, 1);
     /* sice_segment_address parsing */
-    READ_UINT32 (&nr, slice->segment_address, n);
+    READ_UINT32 (nr, slice->segment_address, n);
   }
 
   if (!slice->dependent_slice_segment_flag) {
     for (i = 0; i < pps->num_extra_slice_header_bits; i++)
-      nal_reader_skip (&nr, 1);
-    READ_UE_MAX (&nr, slice->type, 63);
-
+      nal_reader_skip (nr, 1);
+    READ_UE_MAX (nr, slice->type, 63);
 
     if (pps->output_flag_present_flag)
-      READ_UINT8 (&nr, slice->pic_output_flag, 1);
+      READ_UINT8 (nr, slice->pic_output_flag, 1);
     if (sps->separate_colour_plane_flag == 1)
-      READ_UINT8 (&nr, slice->colour_plane_id, 2);
+      READ_UINT8 (nr, slice->colour_plane_id, 2);
 
     if ((nalu->type != GST_H265_NAL_SLICE_IDR_W_RADL)
-        && (nalu->type != GST_H265_NAL_SLICE_IDR_N_LP)) {
-      READ_UINT16 (&nr, slice->pic_order_cnt_lsb,
+        && (nalu->type != GST_H265_NAL_SLICE_IDR_N_LP))
+      READ_UINT16 (nr, slice->pic_order_cnt_lsb,
           (sps->log2_max_pic_order_cnt_lsb_minus4 + 4));
+  }
+
+  return GST_H265_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Slice header\"");
+  return GST_H265_PARSER_ERROR;
+}
+
+/**
+ * gst_h265_parser_parse_slice_hdr:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_SLICE #GstH265NalUnit to parse
+ * @slice: The #GstH265SliceHdr to fill.
+ *
+ * Parses @data, and fills the @slice structure.
+ * The resulting @slice_hdr structure shall be deallocated with
+ * gst_h265_slice_hdr_free() when it is no longer needed
+ *
+ * Returns: a #GstH265ParserResult
+ */
+GstH265ParserResult
+gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
+    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+{
+  NalReader nr;
+  GstH265ParserResult res;
+  GstH265PPS *pps;
+  GstH265SPS *sps;
+  guint i;
+  GstH265ShortTermRefPicSet *stRPS = NULL;
+  guint32 UsedByCurrPicLt[16];
+  gint NumPocTotalCurr = 0;
+
+  res = gst_h265_parser_parse_slice_hdr_start (parser, nalu, slice, &nr);
+  if (res != GST_H265_PARSER_OK)
+    return res;
+
+  pps = slice->pps;
+  sps = pps->sps;
 
+  if (!slice->dependent_slice_segment_flag) {
+    if ((nalu->type != GST_H265_NAL_SLICE_IDR_W_RADL)
+        && (nalu->type != GST_H265_NAL_SLICE_IDR_N_LP)) {
       READ_UINT8 (&nr, slice->short_term_ref_pic_set_sps_flag, 1);
       if (!slice->short_term_ref_pic_set_sps_flag) {
         if (!gst_h265_parser_parse_short_term_ref_pic_sets
@@ -2174,6 +2203,36 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/**
+ * gst_h265_parser_parse_slice_hdr_light:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_SLICE #GstH265NalUnit to parse
+ * @slice: The #GstH265SliceHdr to fill.
+ *
+ * Parses the start of the slice segment header in @nalu, up to and
+ * including slice_pic_order_cnt_lsb. This covers the fields needed to
+ * detect the first slice segment of a new picture and its slice type. The
+ * remaining fields of @slice, including header_size and
+ * n_emulation_prevention_bytes, are left at their default values.
+ *
+ * This is much cheaper than gst_h265_parser_parse_slice_hdr() for callers
+ * that only need to find access unit boundaries and keyframes. Unlike a
+ * full parse, the resulting @slice never holds allocated memory, so it
+ * doesn't need to be freed with gst_h265_slice_hdr_free().
+ *
+ * Returns: a #GstH265ParserResult
+ *
+ * Since: 1.14
+ */
+GstH265ParserResult
+gst_h265_parser_parse_slice_hdr_light (GstH265Parser * parser,
+    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+{
+  NalReader nr;
+
+  return gst_h265_parser_parse_slice_hdr_start (parser, nalu, slice, &nr);
+}
+
 static gboolean
 nal_reader_has_more_data_in_payload (NalReader * nr,
     guint32 payload_start_pos_bit, guint32 payloadSize)
@@ -1031,6 +1031,11 @@ GstH265ParserResult gst_h265_parser_parse_slice_hdr (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265SliceHdr * slice);
 
+GST_EXPORT
+GstH265ParserResult gst_h265_parser_parse_slice_hdr_light (GstH265Parser   * parser,
+                                                     GstH265NalUnit  * nalu,
+                                                     GstH265SliceHdr * slice);
+
 GST_EXPORT
 GstH265ParserResult gst_h265_parser_parse_vps       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
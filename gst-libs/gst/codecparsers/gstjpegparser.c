@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <gst/base/gstbytereader.h>
 #include "gstjpegparser.h"
+#include "startcodeutils.h"
 
 #ifndef GST_DISABLE_GST_DEBUG
 
@@ -252,19 +253,16 @@ jpeg_parse_to_next_marker (GstByteReader * br, GstJpegMarker * marker)
 static gint
 gst_jpeg_scan_for_marker_code (const guint8 * data, gsize size, guint offset)
 {
-  guint i;
+  gint ofs;
 
-  i = offset + 1;
-  while (i < size) {
-    const guint8 v = data[i];
-    if (v < 0xc0)
-      i += 2;
-    else if (v < 0xff && data[i - 1] == 0xff)
-      return i - 1;
-    else
-      i++;
-  }
-  return -1;
+  if (offset >= size)
+    return -1;
+
+  ofs = scan_for_jpeg_marker (data + offset, size - offset);
+  if (ofs < 0)
+    return -1;
+
+  return offset + ofs;
 }
 
 /**
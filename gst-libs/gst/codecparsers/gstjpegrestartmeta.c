@@ -0,0 +1,159 @@
+/*
+ * GStreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstjpegrestartmeta
+ * @title: GstJpegRestartMeta
+ * @short_description: JPEG restart interval locations
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstjpegrestartmeta.h"
+
+GST_DEBUG_CATEGORY (jpeg_restart_meta_debug);
+#define GST_CAT_DEFAULT jpeg_restart_meta_debug
+
+static gboolean
+gst_jpeg_restart_meta_init (GstJpegRestartMeta * restart_meta,
+    gpointer params, GstBuffer * buffer)
+{
+  restart_meta->restart_interval = 0;
+  restart_meta->scan_offset = 0;
+  restart_meta->n_restarts = 0;
+  restart_meta->restart_offsets = NULL;
+
+  return TRUE;
+}
+
+static void
+gst_jpeg_restart_meta_free (GstJpegRestartMeta * restart_meta,
+    GstBuffer * buffer)
+{
+  g_free (restart_meta->restart_offsets);
+}
+
+static gboolean
+gst_jpeg_restart_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstJpegRestartMeta *smeta, *dmeta;
+
+  smeta = (GstJpegRestartMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    /* the offsets are only meaningful for the complete image */
+    if (!copy->region) {
+      dmeta = gst_buffer_add_jpeg_restart_meta (dest,
+          smeta->restart_interval, smeta->scan_offset,
+          smeta->restart_offsets, smeta->n_restarts);
+
+      if (!dmeta)
+        return FALSE;
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_jpeg_restart_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { "memory", NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstJpegRestartMetaAPI", tags);
+    GST_DEBUG_CATEGORY_INIT (jpeg_restart_meta_debug, "jpegrestartmeta", 0,
+        "JPEG restart interval GstMeta");
+
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_jpeg_restart_meta_get_info (void)
+{
+  static const GstMetaInfo *jpeg_restart_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & jpeg_restart_meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_JPEG_RESTART_META_API_TYPE,
+        "GstJpegRestartMeta", sizeof (GstJpegRestartMeta),
+        (GstMetaInitFunction) gst_jpeg_restart_meta_init,
+        (GstMetaFreeFunction) gst_jpeg_restart_meta_free,
+        (GstMetaTransformFunction) gst_jpeg_restart_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & jpeg_restart_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return jpeg_restart_meta_info;
+}
+
+/**
+ * gst_buffer_add_jpeg_restart_meta:
+ * @buffer: a #GstBuffer
+ * @restart_interval: number of MCUs in each restart interval
+ * @scan_offset: offset of the first entropy-coded byte of the scan
+ * @restart_offsets: (array length=n_restarts) (allow-none): offsets of the
+ *   RSTn markers of the scan
+ * @n_restarts: number of entries in @restart_offsets
+ *
+ * Creates and adds a #GstJpegRestartMeta to a @buffer. The offsets are
+ * copied.
+ *
+ * Returns: (transfer none): a newly created #GstJpegRestartMeta
+ *
+ * Since: 1.14
+ */
+GstJpegRestartMeta *
+gst_buffer_add_jpeg_restart_meta (GstBuffer * buffer, guint restart_interval,
+    guint scan_offset, const guint * restart_offsets, guint n_restarts)
+{
+  GstJpegRestartMeta *restart_meta;
+
+  g_return_val_if_fail (restart_offsets != NULL || n_restarts == 0, NULL);
+
+  restart_meta =
+      (GstJpegRestartMeta *) gst_buffer_add_meta (buffer,
+      GST_JPEG_RESTART_META_INFO, NULL);
+
+  GST_DEBUG ("interval:%u, scan offset:%u, restarts:%u", restart_interval,
+      scan_offset, n_restarts);
+
+  restart_meta->restart_interval = restart_interval;
+  restart_meta->scan_offset = scan_offset;
+  restart_meta->n_restarts = n_restarts;
+  if (n_restarts > 0)
+    restart_meta->restart_offsets =
+        g_memdup (restart_offsets, n_restarts * sizeof (guint));
+
+  return restart_meta;
+}
@@ -0,0 +1,83 @@
+/* Gstreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_JPEG_RESTART_META_H__
+#define __GST_JPEG_RESTART_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The JPEG parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstJpegRestartMeta GstJpegRestartMeta;
+
+GST_EXPORT
+GType gst_jpeg_restart_meta_api_get_type (void);
+#define GST_JPEG_RESTART_META_API_TYPE  (gst_jpeg_restart_meta_api_get_type())
+#define GST_JPEG_RESTART_META_INFO  (gst_jpeg_restart_meta_get_info())
+GST_EXPORT
+const GstMetaInfo * gst_jpeg_restart_meta_get_info (void);
+
+/**
+ * GstJpegRestartMeta:
+ * @meta: parent #GstMeta
+ * @restart_interval: number of MCUs in each restart interval (Ri)
+ * @scan_offset: offset in the buffer of the first entropy-coded byte of
+ *   the scan
+ * @n_restarts: number of entries in @restart_offsets
+ * @restart_offsets: offsets in the buffer of the 0xff byte of each RSTn
+ *   marker of the scan, in bitstream order
+ *
+ * Extra buffer metadata locating the restart intervals of a JPEG image.
+ *
+ * The entropy-coded data of the first interval starts at @scan_offset and
+ * that of interval n + 1 starts two bytes after @restart_offsets[n]. Since
+ * the DC predictors are reset at every restart marker, decoders can use
+ * this to decode the intervals independently, e.g. on several threads,
+ * without scanning the entropy-coded data themselves.
+ *
+ * Since: 1.14
+ */
+struct _GstJpegRestartMeta {
+  GstMeta meta;
+
+  guint restart_interval;
+  guint scan_offset;
+
+  guint n_restarts;
+  guint *restart_offsets;
+};
+
+#define gst_buffer_get_jpeg_restart_meta(b) ((GstJpegRestartMeta*)gst_buffer_get_meta((b),GST_JPEG_RESTART_META_API_TYPE))
+
+GST_EXPORT
+GstJpegRestartMeta *
+gst_buffer_add_jpeg_restart_meta (GstBuffer * buffer,
+                                  guint restart_interval,
+                                  guint scan_offset,
+                                  const guint * restart_offsets,
+                                  guint n_restarts);
+
+G_END_DECLS
+
+#endif
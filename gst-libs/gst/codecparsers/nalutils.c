@@ -36,6 +36,7 @@
 #endif
 
 #include "nalutils.h"
+#include "startcodeutils.h"
 
 /* Compute Ceil(Log2(v)) */
 /* Derived from branchless code for integer log2(v) from:
@@ -63,6 +64,30 @@ ceil_log2 (guint32 v)
 
 /****** Nal parser ******/
 
+/* How far ahead to look for emulation prevention bytes at once. Most
+ * users only parse the first few bytes of a slice, so don't scan all of
+ * it up front. */
+#define EPB_SCAN_WINDOW 256
+
+/* Sets epb_check to the first byte at or after @from that follows 00 00
+ * and is 03, or to the end of the scan window if there is none. Only
+ * that byte needs the full emulation prevention check when loaded. */
+static void
+nal_reader_find_next_epb (NalReader * nr, guint from)
+{
+  guint end = MIN (from + EPB_SCAN_WINDOW, nr->size);
+  gint off;
+
+  if (from >= end) {
+    nr->epb_check = end;
+    return;
+  }
+
+  /* @from is at least 2, the first two bytes can never be an EPB */
+  off = scan_for_emulation_prevention (nr->data + from - 2, end - from + 2);
+  nr->epb_check = off >= 0 ? from + off : end;
+}
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -75,6 +100,8 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
   /* fill with something other than 0 to detect emulation prevention bytes */
   nr->first_byte = 0xff;
   nr->cache = 0xff;
+
+  nal_reader_find_next_epb (nr, 2);
 }
 
 gboolean
@@ -88,6 +115,7 @@ nal_reader_read (NalReader * nr, guint nbits)
 
   while (nr->bits_in_cache < nbits) {
     guint8 byte;
+    guint pos;
     gboolean check_three_byte;
 
     check_three_byte = TRUE;
@@ -95,15 +123,23 @@ nal_reader_read (NalReader * nr, guint nbits)
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
-    byte = nr->data[nr->byte++];
-
-    /* check if the byte is a emulation_prevention_three_byte */
-    if (check_three_byte && byte == 0x03 && nr->first_byte == 0x00 &&
-        ((nr->cache & 0xff) == 0)) {
-      /* next byte goes unconditionally to the cache, even if it's 0x03 */
-      check_three_byte = FALSE;
-      nr->n_epb++;
-      goto next_byte;
+    pos = nr->byte++;
+    byte = nr->data[pos];
+
+    /* Bytes before the next one found by the scan can't be an EPB */
+    if (G_UNLIKELY (pos == nr->epb_check)) {
+      /* check if the byte is a emulation_prevention_three_byte */
+      if (check_three_byte && byte == 0x03 && nr->first_byte == 0x00 &&
+          ((nr->cache & 0xff) == 0)) {
+        /* next byte goes unconditionally to the cache, even if it's 0x03.
+         * As the EPB isn't cached, the one after that needs the check
+         * again even if the raw bytes before it aren't 00 00 */
+        check_three_byte = FALSE;
+        nr->n_epb++;
+        nr->epb_check = pos + 2;
+        goto next_byte;
+      }
+      nal_reader_find_next_epb (nr, pos + 1);
     }
     nr->cache = (nr->cache << 8) | nr->first_byte;
     nr->first_byte = byte;
@@ -300,10 +336,6 @@ nal_reader_has_more_data (NalReader * nr)
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  return scan_for_start_code_prefix (data, size);
 }
@@ -47,6 +47,7 @@ typedef struct
   guint size;
 
   guint n_epb;                  /* Number of emulation prevention bytes */
+  guint epb_check;              /* Next byte that may be an EPB */
   guint byte;                   /* Byte position */
   guint bits_in_cache;          /* bitpos in the cache of next bit */
   guint8 first_byte;
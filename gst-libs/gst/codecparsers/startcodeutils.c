@@ -0,0 +1,265 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * Start code prefix (00 00 01) scanning shared by the H.264, H.265,
+ * MPEG-1/2, MPEG-4 part 2 and VC-1 parsers, the emulation prevention
+ * (00 00 03) scan used by the NAL reader, and the JPEG marker (0xff 0xXX)
+ * scan.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "startcodeutils.h"
+
+#include <string.h>
+
+/* SSE2 is always available on x86-64 and NEON on AArch64, so the vector
+ * path is picked at build time and no CPU detection is needed. Everything
+ * else uses the word-at-a-time scan below. */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define HAVE_SSE2_SCAN 1
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  define HAVE_NEON_SCAN 1
+#  include <arm_neon.h>
+#endif
+
+#define IS_PATTERN(p, third) ((p)[0] == 0 && (p)[1] == 0 && (p)[2] == (third))
+
+/* Checks the candidate positions [start, end) one by one */
+static inline gint
+scan_block (const guint8 * data, guint start, guint end, guint8 third)
+{
+  guint i;
+
+  for (i = start; i < end; i++) {
+    if (IS_PATTERN (data + i, third))
+      return i;
+  }
+
+  return -1;
+}
+
+/* Returns the first position below @end at which 00 00 @third starts.
+ * @data must hold at least @end + 2 bytes. */
+static inline gint
+scan_for_pattern (const guint8 * data, guint end, guint8 third)
+{
+  guint i = 0;
+
+#if defined(HAVE_SSE2_SCAN)
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i last = _mm_set1_epi8 (third);
+
+    /* Compare 16 candidate positions at once; the shifted loads read at
+     * most up to i + 17, which is still inside @data */
+    while (i + 16 <= end) {
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i b2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+      __m128i m;
+      gint mask;
+
+      m = _mm_and_si128 (_mm_cmpeq_epi8 (b0, zero),
+          _mm_cmpeq_epi8 (b1, zero));
+      m = _mm_and_si128 (m, _mm_cmpeq_epi8 (b2, last));
+      mask = _mm_movemask_epi8 (m);
+      if (mask)
+        return i + g_bit_nth_lsf (mask, -1);
+
+      i += 16;
+    }
+  }
+#elif defined(HAVE_NEON_SCAN)
+  {
+    const uint8x16_t zero = vdupq_n_u8 (0);
+    const uint8x16_t last = vdupq_n_u8 (third);
+
+    while (i + 16 <= end) {
+      uint8x16_t b0 = vld1q_u8 (data + i);
+      uint8x16_t b1 = vld1q_u8 (data + i + 1);
+      uint8x16_t b2 = vld1q_u8 (data + i + 2);
+      uint8x16_t m;
+
+      m = vandq_u8 (vceqq_u8 (b0, zero), vceqq_u8 (b1, zero));
+      m = vandq_u8 (m, vceqq_u8 (b2, last));
+      /* NEON has no movemask, locate the match with the scalar loop */
+      if (vmaxvq_u8 (m))
+        return scan_block (data, i, i + 16, third);
+
+      i += 16;
+    }
+  }
+#else
+  /* A pattern can only start on a zero byte, so skip whole words that
+   * don't contain any */
+  while (i + 8 <= end) {
+    guint64 w;
+
+    memcpy (&w, data + i, sizeof (w));
+    if ((w - G_GUINT64_CONSTANT (0x0101010101010101)) & ~w &
+        G_GUINT64_CONSTANT (0x8080808080808080)) {
+      gint ret = scan_block (data, i, i + 8, third);
+
+      if (ret >= 0)
+        return ret;
+    }
+
+    i += 8;
+  }
+#endif
+
+  /* Remaining tail, skipping ahead as far as the bytes allow */
+  while (i < end) {
+    if (data[i + 2] != 0 && data[i + 2] != third) {
+      i += 3;
+    } else if (data[i + 1]) {
+      i += 2;
+    } else if (data[i] || data[i + 2] != third) {
+      i++;
+    } else {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/* Looks for the first 00 00 01 start code prefix in @data that is
+ * followed by at least one more byte, as the start code value byte
+ * always comes after the prefix. Returns the offset of the prefix in
+ * @data, or -1 if none was found. */
+gint
+scan_for_start_code_prefix (const guint8 * data, guint size)
+{
+  /* we can't find the pattern with less than 4 bytes */
+  if (G_UNLIKELY (size < 4))
+    return -1;
+
+  return scan_for_pattern (data, size - 3, 0x01);
+}
+
+/* Looks for the first 00 00 03 sequence in @data. Returns its offset in
+ * @data, or -1 if none was found. */
+gint
+scan_for_emulation_prevention (const guint8 * data, guint size)
+{
+  if (G_UNLIKELY (size < 3))
+    return -1;
+
+  return scan_for_pattern (data, size - 2, 0x03);
+}
+
+#define IS_JPEG_MARKER(p) ((p)[0] == 0xff && (p)[1] >= 0xc0 && (p)[1] != 0xff)
+
+static inline gint
+scan_jpeg_block (const guint8 * data, guint start, guint end)
+{
+  guint i;
+
+  for (i = start; i < end; i++) {
+    if (IS_JPEG_MARKER (data + i))
+      return i;
+  }
+
+  return -1;
+}
+
+/* Looks for the first JPEG marker code in @data, that is an 0xff byte
+ * followed by a value in the 0xc0 - 0xfe range. Stuffed zero bytes
+ * (0xff 0x00) and fill bytes (0xff 0xff) are skipped, so the 0xff that
+ * is returned is the one right in front of the marker value. Returns its
+ * offset in @data, or -1 if none was found. */
+gint
+scan_for_jpeg_marker (const guint8 * data, guint size)
+{
+  guint i = 0, end;
+
+  if (G_UNLIKELY (size < 2))
+    return -1;
+
+  end = size - 1;
+
+#if defined(HAVE_SSE2_SCAN)
+  {
+    const __m128i ff = _mm_set1_epi8 ((gchar) 0xff);
+    const __m128i c0 = _mm_set1_epi8 ((gchar) 0xc0);
+
+    /* The shifted load reads at most up to i + 16, still inside @data */
+    while (i + 16 <= end) {
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i m;
+      gint mask;
+
+      /* b1 >= 0xc0 is max (b1, 0xc0) == b1 with unsigned bytes */
+      m = _mm_and_si128 (_mm_cmpeq_epi8 (b0, ff),
+          _mm_cmpeq_epi8 (_mm_max_epu8 (b1, c0), b1));
+      m = _mm_andnot_si128 (_mm_cmpeq_epi8 (b1, ff), m);
+      mask = _mm_movemask_epi8 (m);
+      if (mask)
+        return i + g_bit_nth_lsf (mask, -1);
+
+      i += 16;
+    }
+  }
+#elif defined(HAVE_NEON_SCAN)
+  {
+    const uint8x16_t ff = vdupq_n_u8 (0xff);
+    const uint8x16_t c0 = vdupq_n_u8 (0xc0);
+
+    while (i + 16 <= end) {
+      uint8x16_t b0 = vld1q_u8 (data + i);
+      uint8x16_t b1 = vld1q_u8 (data + i + 1);
+      uint8x16_t m;
+
+      m = vandq_u8 (vceqq_u8 (b0, ff), vcgeq_u8 (b1, c0));
+      m = vbicq_u8 (m, vceqq_u8 (b1, ff));
+      if (vmaxvq_u8 (m))
+        return scan_jpeg_block (data, i, i + 16);
+
+      i += 16;
+    }
+  }
+#else
+  /* A marker can only start on an 0xff byte, so skip whole words that
+   * don't contain any */
+  while (i + 8 <= end) {
+    guint64 w;
+
+    memcpy (&w, data + i, sizeof (w));
+    w = ~w;
+    if ((w - G_GUINT64_CONSTANT (0x0101010101010101)) & ~w &
+        G_GUINT64_CONSTANT (0x8080808080808080)) {
+      gint ret = scan_jpeg_block (data, i, i + 8);
+
+      if (ret >= 0)
+        return ret;
+    }
+
+    i += 8;
+  }
+#endif
+
+  return scan_jpeg_block (data, i, end);
+}
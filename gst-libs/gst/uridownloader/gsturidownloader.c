@@ -27,6 +27,10 @@
 #define GST_CAT_DEFAULT uridownloader_debug
 GST_DEBUG_CATEGORY (uridownloader_debug);
 
+/* Maximum number of idle source elements kept around, each of them for a
+ * different protocol */
+#define MAX_IDLE_SRCS 4
+
 #define GST_URI_DOWNLOADER_GET_PRIVATE(obj)  \
    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), \
     GST_TYPE_URI_DOWNLOADER, GstUriDownloaderPrivate))
@@ -48,6 +52,10 @@ struct _GstUriDownloaderPrivate
 
   GCond cond;
   gboolean cancelled;
+
+  /* source elements not used by the current download, most recently used
+   * first */
+  GQueue idle_srcs;
 };
 
 static void gst_uri_downloader_finalize (GObject * object);
@@ -63,6 +71,7 @@ static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
 static gboolean gst_uri_downloader_ensure_src (GstUriDownloader * downloader,
     const gchar * uri);
 static void gst_uri_downloader_destroy_src (GstUriDownloader * downloader);
+static void gst_uri_downloader_free_src (GstElement * urisrc);
 
 static GstStaticPadTemplate sinkpadtemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -111,6 +120,7 @@ gst_uri_downloader_init (GstUriDownloader * downloader)
 
   g_mutex_init (&downloader->priv->download_lock);
   g_cond_init (&downloader->priv->cond);
+  g_queue_init (&downloader->priv->idle_srcs);
 }
 
 static void
@@ -119,6 +129,9 @@ gst_uri_downloader_dispose (GObject * object)
   GstUriDownloader *downloader = GST_URI_DOWNLOADER (object);
 
   gst_uri_downloader_destroy_src (downloader);
+  while (!g_queue_is_empty (&downloader->priv->idle_srcs))
+    gst_uri_downloader_free_src (g_queue_pop_head
+        (&downloader->priv->idle_srcs));
 
   if (downloader->priv->bus != NULL) {
     gst_object_unref (downloader->priv->bus);
@@ -400,36 +413,102 @@ gst_uri_downloader_set_range (GstUriDownloader * downloader,
   return TRUE;
 }
 
+/* Returns the protocol of @uri. A source element handles any URI with the
+ * same protocol and keeps its connections open across hosts, so that is all
+ * that decides whether it can be re-used */
+static gchar *
+gst_uri_downloader_get_src_key (const gchar * uri)
+{
+  return gst_uri_get_protocol (uri);
+}
+
+static gboolean
+gst_uri_downloader_src_has_key (GstElement * urisrc, const gchar * key)
+{
+  gchar *src_uri, *src_key;
+  gboolean ret;
+
+  src_uri = gst_uri_handler_get_uri (GST_URI_HANDLER (urisrc));
+  src_key = src_uri ? gst_uri_downloader_get_src_key (src_uri) : NULL;
+  ret = g_strcmp0 (src_key, key) == 0;
+  g_free (src_key);
+  g_free (src_uri);
+
+  return ret;
+}
+
+static void
+gst_uri_downloader_free_src (GstElement * urisrc)
+{
+  gst_element_set_state (urisrc, GST_STATE_NULL);
+  gst_object_unref (urisrc);
+}
+
+/* Moves the current source element to the idle ones so that it, and the
+ * connections it holds, can be re-used when the protocol switches back */
+static void
+gst_uri_downloader_release_src (GstUriDownloader * downloader)
+{
+  GstUriDownloaderPrivate *priv = downloader->priv;
+
+  if (!priv->urisrc)
+    return;
+
+  GST_DEBUG_OBJECT (downloader, "Keeping source element %s for later",
+      GST_ELEMENT_NAME (priv->urisrc));
+  g_queue_push_head (&priv->idle_srcs, priv->urisrc);
+  priv->urisrc = NULL;
+
+  while (g_queue_get_length (&priv->idle_srcs) > MAX_IDLE_SRCS)
+    gst_uri_downloader_free_src (g_queue_pop_tail (&priv->idle_srcs));
+}
+
+static GstElement *
+gst_uri_downloader_take_idle_src (GstUriDownloader * downloader,
+    const gchar * key)
+{
+  GList *l;
+
+  for (l = downloader->priv->idle_srcs.head; l; l = l->next) {
+    GstElement *urisrc = l->data;
+
+    if (gst_uri_downloader_src_has_key (urisrc, key)) {
+      g_queue_delete_link (&downloader->priv->idle_srcs, l);
+      return urisrc;
+    }
+  }
+
+  return NULL;
+}
+
 static gboolean
 gst_uri_downloader_ensure_src (GstUriDownloader * downloader, const gchar * uri)
 {
-  if (downloader->priv->urisrc) {
-    gchar *old_protocol, *new_protocol;
-    gchar *old_uri;
+  gchar *key = gst_uri_downloader_get_src_key (uri);
 
-    old_uri =
-        gst_uri_handler_get_uri (GST_URI_HANDLER (downloader->priv->urisrc));
-    old_protocol = gst_uri_get_protocol (old_uri);
-    new_protocol = gst_uri_get_protocol (uri);
+  /* a different protocol needs a different source element, keep the current
+   * one around and look for an idle one handling the new protocol */
+  if (downloader->priv->urisrc &&
+      !gst_uri_downloader_src_has_key (downloader->priv->urisrc, key))
+    gst_uri_downloader_release_src (downloader);
 
-    if (!g_str_equal (old_protocol, new_protocol)) {
+  if (!downloader->priv->urisrc)
+    downloader->priv->urisrc =
+        gst_uri_downloader_take_idle_src (downloader, key);
+
+  g_free (key);
+
+  if (downloader->priv->urisrc) {
+    GError *err = NULL;
+
+    GST_DEBUG_OBJECT (downloader, "Re-using old source element");
+    if (!gst_uri_handler_set_uri
+        (GST_URI_HANDLER (downloader->priv->urisrc), uri, &err)) {
+      GST_DEBUG_OBJECT (downloader,
+          "Failed to re-use old source element: %s", err->message);
+      g_clear_error (&err);
       gst_uri_downloader_destroy_src (downloader);
-      GST_DEBUG_OBJECT (downloader, "Can't re-use old source element");
-    } else {
-      GError *err = NULL;
-
-      GST_DEBUG_OBJECT (downloader, "Re-using old source element");
-      if (!gst_uri_handler_set_uri
-          (GST_URI_HANDLER (downloader->priv->urisrc), uri, &err)) {
-        GST_DEBUG_OBJECT (downloader,
-            "Failed to re-use old source element: %s", err->message);
-        g_clear_error (&err);
-        gst_uri_downloader_destroy_src (downloader);
-      }
     }
-    g_free (old_uri);
-    g_free (old_protocol);
-    g_free (new_protocol);
   }
 
   if (!downloader->priv->urisrc) {
@@ -455,8 +534,7 @@ gst_uri_downloader_destroy_src (GstUriDownloader * downloader)
   if (!downloader->priv->urisrc)
     return;
 
-  gst_element_set_state (downloader->priv->urisrc, GST_STATE_NULL);
-  gst_object_unref (downloader->priv->urisrc);
+  gst_uri_downloader_free_src (downloader->priv->urisrc);
   downloader->priv->urisrc = NULL;
 }
 
@@ -691,6 +769,11 @@ quit:
               &download->redirect_permanent);
         }
         gst_query_unref (query);
+        /* The source can't stay in PLAYING or PAUSED until the next fetch:
+         * it stopped its task at EOS, and sources only take a new URI in
+         * READY or below. READY is enough to keep the connections, as
+         * souphttpsrc only closes its session in NULL when keep-alive is
+         * set. */
         gst_element_set_state (urisrc, GST_STATE_READY);
       }
       GST_OBJECT_LOCK (downloader);
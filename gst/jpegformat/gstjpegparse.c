@@ -38,6 +38,10 @@
  * The above pipeline fetches a motion JPEG stream from an IP camera over
  * HTTP and stores it in a matroska file.
  *
+ * When #GstJpegParse:restart-meta is enabled, every image gets a
+ * #GstJpegRestartMeta listing where its restart intervals start, so that
+ * decoders can process them in parallel.
+ *
  */
 /* FIXME: output plain JFIF APP marker only. This provides best code reuse.
  * JPEG decoders would not need to handle this part anymore. Also when remuxing
@@ -51,9 +55,19 @@
 #include <string.h>
 #include <gst/base/gstbytereader.h>
 #include <gst/tag/tag.h>
+#include <gst/codecparsers/gstjpegparser.h>
+#include <gst/codecparsers/gstjpegrestartmeta.h>
 
 #include "gstjpegparse.h"
 
+#define DEFAULT_RESTART_META FALSE
+
+enum
+{
+  PROP_0,
+  PROP_RESTART_META
+};
+
 static GstStaticPadTemplate gst_jpeg_parse_src_pad_template =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -107,8 +121,15 @@ struct _GstJpegParsePrivate
 
   /* tags */
   GstTagList *tags;
+
+  /* attach a GstJpegRestartMeta to the output */
+  gboolean restart_meta;
 };
 
+static void gst_jpeg_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_jpeg_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static GstFlowReturn
 gst_jpeg_parse_handle_frame (GstBaseParse * bparse, GstBaseParseFrame * frame,
     gint * skipsize);
@@ -137,6 +158,22 @@ gst_jpeg_parse_class_init (GstJpegParseClass * klass)
 
   g_type_class_add_private (gobject_class, sizeof (GstJpegParsePrivate));
 
+  gobject_class->set_property = gst_jpeg_parse_set_property;
+  gobject_class->get_property = gst_jpeg_parse_get_property;
+
+  /**
+   * GstJpegParse:restart-meta:
+   *
+   * Attach a #GstJpegRestartMeta to each image, listing the offsets of the
+   * restart markers of its scan.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_RESTART_META,
+      g_param_spec_boolean ("restart-meta", "Restart meta",
+          "Attach the offsets of the restart markers to each image",
+          DEFAULT_RESTART_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstbaseparse_class->start = gst_jpeg_parse_start;
   gstbaseparse_class->stop = gst_jpeg_parse_stop;
   gstbaseparse_class->set_sink_caps = gst_jpeg_parse_set_sink_caps;
@@ -165,6 +202,39 @@ gst_jpeg_parse_init (GstJpegParse * parse)
       GstJpegParsePrivate);
 
   parse->priv->next_ts = GST_CLOCK_TIME_NONE;
+  parse->priv->restart_meta = DEFAULT_RESTART_META;
+}
+
+static void
+gst_jpeg_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstJpegParse *parse = GST_JPEG_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_RESTART_META:
+      parse->priv->restart_meta = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_jpeg_parse_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstJpegParse *parse = GST_JPEG_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_RESTART_META:
+      g_value_set_boolean (value, parse->priv->restart_meta);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -755,6 +825,57 @@ gst_jpeg_parse_set_new_caps (GstJpegParse * parse, gboolean header_ok)
 
 }
 
+/* Locates the restart markers of the first scan of the image in @buffer and
+ * attaches them as a GstJpegRestartMeta */
+static void
+gst_jpeg_parse_add_restart_meta (GstJpegParse * parse, GstBuffer * buffer)
+{
+  GstJpegSegment seg;
+  GstMapInfo map;
+  GArray *restarts;
+  guint offset = 0, interval = 0, scan_offset = 0;
+  gboolean in_scan = FALSE;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+
+  restarts = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  while (gst_jpeg_parse (&seg, map.data, map.size, offset)) {
+    if (seg.marker >= GST_JPEG_MARKER_RST_MIN &&
+        seg.marker <= GST_JPEG_MARKER_RST_MAX) {
+      guint marker_offset = seg.offset - 2;
+
+      if (in_scan)
+        g_array_append_val (restarts, marker_offset);
+    } else if (in_scan) {
+      /* anything else ends the scan */
+      break;
+    } else if (seg.marker == GST_JPEG_MARKER_DRI) {
+      if (!gst_jpeg_segment_parse_restart_interval (&seg, &interval))
+        break;
+    } else if (seg.marker == GST_JPEG_MARKER_SOS) {
+      scan_offset = seg.offset + seg.size;
+      in_scan = TRUE;
+    } else if (seg.marker == GST_JPEG_MARKER_EOI) {
+      break;
+    }
+
+    offset = seg.offset + seg.size;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  if (in_scan) {
+    GST_LOG_OBJECT (parse, "scan at %u, %u restart markers every %u MCUs",
+        scan_offset, restarts->len, interval);
+    gst_buffer_add_jpeg_restart_meta (buffer, interval, scan_offset,
+        (const guint *) restarts->data, restarts->len);
+  }
+
+  g_array_free (restarts, TRUE);
+}
+
 static GstFlowReturn
 gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse, GstBaseParseFrame * frame)
 {
@@ -773,6 +894,9 @@ gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse, GstBaseParseFrame * frame)
 
   GST_BUFFER_DURATION (outbuf) = parse->priv->duration;
 
+  if (parse->priv->restart_meta)
+    gst_jpeg_parse_add_restart_meta (parse, outbuf);
+
   return GST_FLOW_OK;
 }
 
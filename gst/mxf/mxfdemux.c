@@ -56,6 +56,15 @@
 
 #include <string.h>
 
+/* Size and alignment of the pulls done for the read-ahead window.
+ * Reads that are at least this large bypass the window */
+#define READ_AHEAD_SIZE (1024 * 1024)
+#define READ_AHEAD_ALIGN 4096
+
+/* Interval in which the size of a growing file is checked again */
+#define GROWING_FILE_POLL_INTERVAL (100 * GST_MSECOND)
+#define DEFAULT_GROWING_FILE_TIMEOUT (10 * GST_SECOND)
+
 static GstStaticPadTemplate mxf_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -79,6 +88,10 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, guint64 offset);
 
 static void collect_index_table_segments (GstMXFDemux * demux);
+static GstFlowReturn
+gst_mxf_demux_add_descriptive_metadata (GstMXFDemux * demux,
+    const MXFUL * key, MXFPrimerPack * primer, guint64 offset,
+    GstBuffer * buffer);
 
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
@@ -116,9 +129,20 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_LAZY_DESCRIPTIVE_METADATA,
+  PROP_GROWING_FILE,
+  PROP_GROWING_FILE_TIMEOUT
+};
+
+enum
+{
+  SIGNAL_PARSE_DESCRIPTIVE_METADATA,
+  LAST_SIGNAL
 };
 
+static guint gst_mxf_demux_signals[LAST_SIGNAL] = { 0 };
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstObject * parent,
@@ -167,6 +191,9 @@ gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 
   demux->current_partition = NULL;
 
+  /* References the partitions */
+  g_hash_table_remove_all (demux->pending_descriptive_metadata);
+
   for (i = 0; i < demux->essence_tracks->len; i++) {
     GstMXFDemuxEssenceTrack *t =
         &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
@@ -245,6 +272,10 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   demux->footer_partition_pack_offset = 0;
   demux->offset = 0;
+  demux->growing_file_size = 0;
+  demux->growing_file_last_growth = 0;
+  demux->growing_file_partition = NULL;
+  demux->growing_file_body_offset = 0;
 
   demux->pull_footer_metadata = TRUE;
 
@@ -261,6 +292,9 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   gst_adapter_clear (demux->adapter);
 
+  gst_buffer_replace (&demux->read_ahead, NULL);
+  demux->read_ahead_offset = 0;
+
   gst_mxf_demux_remove_pads (demux);
 
   if (demux->random_index_pack) {
@@ -286,6 +320,8 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
     for (l = demux->index_tables; l; l = l->next) {
       GstMXFDemuxIndexTable *t = l->data;
       g_array_free (t->offsets, TRUE);
+      if (t->keyframes)
+        g_array_free (t->keyframes, TRUE);
       g_free (t);
     }
     g_list_free (demux->index_tables);
@@ -301,12 +337,73 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->group_id = G_MAXUINT;
 }
 
+/* Tries to serve a pull from the read-ahead window, refilling it with
+ * one large aligned pull if needed. Returns FALSE if the range has to
+ * be pulled directly. The range is copied out of the window, buffers
+ * pushed downstream must not keep the whole window alive */
+static gboolean
+gst_mxf_demux_pull_read_ahead (GstMXFDemux * demux, guint64 offset,
+    guint size, GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  GstBuffer *window = NULL;
+  guint64 window_offset;
+  gsize window_size;
+
+  if (size >= READ_AHEAD_SIZE)
+    return FALSE;
+
+  if (demux->read_ahead) {
+    window_size = gst_buffer_get_size (demux->read_ahead);
+
+    if (offset >= demux->read_ahead_offset
+        && offset + size <= demux->read_ahead_offset + window_size) {
+      *buffer =
+          gst_buffer_copy_region (demux->read_ahead,
+          GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP,
+          offset - demux->read_ahead_offset, size);
+      GST_BUFFER_OFFSET (*buffer) = offset;
+      return TRUE;
+    }
+  }
+
+  window_offset = offset - (offset % READ_AHEAD_ALIGN);
+
+  ret =
+      gst_pad_pull_range (demux->sinkpad, window_offset, READ_AHEAD_SIZE,
+      &window);
+  if (ret != GST_FLOW_OK)
+    return FALSE;
+
+  gst_buffer_replace (&demux->read_ahead, window);
+  gst_buffer_unref (window);
+  demux->read_ahead_offset = window_offset;
+  window_size = gst_buffer_get_size (window);
+
+  GST_LOG_OBJECT (demux, "Read ahead %" G_GSIZE_FORMAT " bytes at offset %"
+      G_GUINT64_FORMAT, window_size, window_offset);
+
+  /* Short read near the end of the file */
+  if (offset + size > window_offset + window_size)
+    return FALSE;
+
+  *buffer =
+      gst_buffer_copy_region (window,
+      GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, offset - window_offset, size);
+  GST_BUFFER_OFFSET (*buffer) = offset;
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
 
+  if (gst_mxf_demux_pull_read_ahead (demux, offset, size, buffer))
+    return GST_FLOW_OK;
+
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_WARNING_OBJECT (demux,
@@ -460,6 +557,20 @@ gst_mxf_demux_handle_partition_pack (GstMXFDemux * demux, const MXFUL * key,
 out:
   demux->current_partition = p;
 
+  /* In a growing file, the partition before a new one is complete */
+  if (demux->growing_file) {
+    l = g_list_find (demux->partitions, p);
+    if (l && l->prev && l->prev->data != demux->growing_file_partition) {
+      demux->growing_file_partition = l->prev->data;
+      if (p->partition.body_sid != 0)
+        demux->growing_file_body_offset = p->partition.body_offset;
+      GST_DEBUG_OBJECT (demux, "Partition at offset %" G_GUINT64_FORMAT
+          " is complete, essence up to body offset %" G_GUINT64_FORMAT,
+          demux->growing_file_partition->partition.this_partition,
+          demux->growing_file_body_offset);
+    }
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -522,6 +633,18 @@ gst_mxf_demux_resolve_references (GstMXFDemux * demux)
     m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_NONE;
   }
 
+  /* DM segments whose framework was not parsed yet are resolved once it
+   * is, until then they must not make their tracks fail */
+  if (g_hash_table_size (demux->pending_descriptive_metadata) > 0) {
+    g_hash_table_iter_init (&iter, demux->metadata);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
+      if (MXF_IS_METADATA_DM_SEGMENT (m)
+          && g_hash_table_contains (demux->pending_descriptive_metadata,
+              &MXF_METADATA_DM_SEGMENT (m)->dm_framework_uid))
+        m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_SUCCESS;
+    }
+  }
+
   g_hash_table_iter_init (&iter, demux->metadata);
   while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
     gboolean resolved;
@@ -1432,15 +1555,42 @@ gst_mxf_demux_handle_metadata (GstMXFDemux * demux, const MXFUL * key,
   return ret;
 }
 
+/* Reads the instance UID of a metadata set without parsing the set */
+static gboolean
+gst_mxf_demux_peek_instance_uid (GstBuffer * buffer, MXFUUID * instance_uid)
+{
+  GstMapInfo map;
+  const guint8 *data, *tag_data;
+  guint size;
+  guint16 tag, tag_size;
+  gboolean ret = FALSE;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  data = map.data;
+  size = map.size;
+
+  while (mxf_local_tag_parse (data, size, &tag, &tag_size, &tag_data)) {
+    if (tag == 0x3c0a && tag_size == 16) {
+      memcpy (instance_uid, tag_data, 16);
+      ret = TRUE;
+      break;
+    }
+
+    data += 4 + tag_size;
+    size -= 4 + tag_size;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer)
 {
   guint32 type;
   guint8 scheme;
-  GstMapInfo map;
-  GstFlowReturn ret = GST_FLOW_OK;
-  MXFDescriptiveMetadata *m = NULL, *old = NULL;
 
   scheme = GST_READ_UINT8 (key->u + 12);
   type = GST_READ_UINT24_BE (key->u + 13);
@@ -1465,9 +1615,52 @@ gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
     return GST_FLOW_OK;
   }
 
+  /* Only remember where it is and which instance UID it has, it can be
+   * pulled again later */
+  if (demux->lazy_descriptive_metadata && demux->random_access) {
+    GstMXFDemuxPendingMetadata *pending;
+    MXFUUID instance_uid;
+
+    if (gst_mxf_demux_peek_instance_uid (buffer, &instance_uid)) {
+      pending =
+          g_hash_table_lookup (demux->pending_descriptive_metadata,
+          &instance_uid);
+      if (pending && pending->offset >= demux->offset)
+        return GST_FLOW_OK;
+
+      pending = g_new0 (GstMXFDemuxPendingMetadata, 1);
+      memcpy (&pending->instance_uid, &instance_uid, sizeof (MXFUUID));
+      pending->partition = demux->current_partition;
+      pending->offset = demux->offset;
+      g_hash_table_replace (demux->pending_descriptive_metadata,
+          &pending->instance_uid, pending);
+
+      GST_DEBUG_OBJECT (demux, "Postponing parsing of descriptive metadata");
+      return GST_FLOW_OK;
+    }
+  }
+
+  return gst_mxf_demux_add_descriptive_metadata (demux, key,
+      &demux->current_partition->primer, demux->offset, buffer);
+}
+
+static GstFlowReturn
+gst_mxf_demux_add_descriptive_metadata (GstMXFDemux * demux,
+    const MXFUL * key, MXFPrimerPack * primer, guint64 offset,
+    GstBuffer * buffer)
+{
+  guint32 type;
+  guint8 scheme;
+  GstMapInfo map;
+  GstFlowReturn ret = GST_FLOW_OK;
+  MXFDescriptiveMetadata *m = NULL, *old = NULL;
+
+  scheme = GST_READ_UINT8 (key->u + 12);
+  type = GST_READ_UINT24_BE (key->u + 13);
+
   gst_buffer_map (buffer, &map, GST_MAP_READ);
-  m = mxf_descriptive_metadata_new (scheme, type,
-      &demux->current_partition->primer, demux->offset, map.data, map.size);
+  m = mxf_descriptive_metadata_new (scheme, type, primer, offset, map.data,
+      map.size);
   gst_buffer_unmap (buffer, &map);
 
   if (!m) {
@@ -1681,6 +1874,83 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   return ret;
 }
 
+static GstMXFDemuxIndexTable *
+gst_mxf_demux_find_index_table (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack)
+{
+  GList *l;
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *tmp = l->data;
+
+    if (tmp->body_sid == etrack->body_sid
+        && tmp->index_sid == etrack->index_sid)
+      return tmp;
+  }
+
+  return NULL;
+}
+
+static gint
+gst_mxf_demux_keyframe_position_search (GstMXFDemuxKeyframe * keyframe,
+    guint64 * position, gpointer user_data)
+{
+  if (keyframe->position < *position)
+    return -1;
+  else if (keyframe->position > *position)
+    return 1;
+  else
+    return 0;
+}
+
+static gint
+gst_mxf_demux_keyframe_offset_search (GstMXFDemuxKeyframe * keyframe,
+    guint64 * offset, gpointer user_data)
+{
+  if (keyframe->offset < *offset)
+    return -1;
+  else if (keyframe->offset > *offset)
+    return 1;
+  else
+    return 0;
+}
+
+/* Returns the DTS edit unit number of the index entry at @offset
+ * or -1 if there is none. Starts at the closest keyframe before
+ * @offset, so at most one GOP has to be looked at */
+static gint64
+find_index_table_position (GstMXFDemuxIndexTable * index_table,
+    guint64 offset)
+{
+  GstMXFDemuxKeyframe *keyframe;
+  guint64 position = 0;
+
+  if (!index_table->keyframes || index_table->keyframes->len == 0)
+    return -1;
+
+  keyframe =
+      gst_util_array_binary_search (index_table->keyframes->data,
+      index_table->keyframes->len, sizeof (GstMXFDemuxKeyframe),
+      (GCompareDataFunc) gst_mxf_demux_keyframe_offset_search,
+      GST_SEARCH_MODE_BEFORE, &offset, NULL);
+  if (keyframe)
+    position = keyframe->position;
+
+  for (; position < index_table->offsets->len; position++) {
+    GstMXFDemuxIndex *idx =
+        &g_array_index (index_table->offsets, GstMXFDemuxIndex, position);
+
+    if (!idx->initialized || idx->offset == 0)
+      continue;
+    if (idx->offset == offset)
+      return position;
+    if (idx->offset > offset)
+      break;
+  }
+
+  return -1;
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, gboolean peek)
@@ -1691,6 +1961,7 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   GstBuffer *inbuf = NULL;
   GstBuffer *outbuf = NULL;
   GstMXFDemuxEssenceTrack *etrack = NULL;
+  GstMXFDemuxIndexTable *index_table = NULL;
   gboolean keyframe = TRUE;
   /* As in GstMXFDemuxIndex */
   guint64 pts = G_MAXUINT64, dts = G_MAXUINT64;
@@ -1747,7 +2018,13 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   if (etrack->position == -1) {
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
+    index_table = gst_mxf_demux_find_index_table (demux, etrack);
+    if (index_table)
+      etrack->position =
+          find_index_table_position (index_table,
+          demux->offset - demux->run_in);
+
+    if (etrack->position == -1 && etrack->offsets) {
       for (i = 0; i < etrack->offsets->len; i++) {
         GstMXFDemuxIndex *idx =
             &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
@@ -1811,18 +2088,8 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
   /* Prefer keyframe information from index tables over everything else */
   if (demux->index_tables) {
-    GList *l;
-    GstMXFDemuxIndexTable *index_table = NULL;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
+    if (!index_table)
+      index_table = gst_mxf_demux_find_index_table (demux, etrack);
 
     if (index_table && index_table->offsets->len > etrack->position) {
       GstMXFDemuxIndex *index =
@@ -2267,6 +2534,13 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
   demux->pending_index_table_segments =
       g_list_prepend (demux->pending_index_table_segments, segment);
 
+  /* Until the RIP is there, extend the index of a growing file while
+   * playing so that seeks can use it */
+  if (demux->growing_file && !demux->random_index_pack) {
+    collect_index_table_segments (demux);
+    demux->index_table_segments_collected = TRUE;
+  }
+
   return GST_FLOW_OK;
 }
 
@@ -2808,6 +3082,34 @@ find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
   return -1;
 }
 
+/* Like find_closest_offset() but uses the sorted keyframe list
+ * of the index table for keyframe lookups */
+static guint64
+find_closest_index_table_offset (GstMXFDemuxIndexTable * index_table,
+    gint64 * position, gboolean keyframe)
+{
+  GstMXFDemuxKeyframe *entry;
+  guint64 search_position;
+
+  if (!keyframe || !index_table->keyframes)
+    return find_closest_offset (index_table->offsets, position, keyframe);
+
+  if (index_table->keyframes->len == 0 || *position < 0)
+    return -1;
+
+  search_position = *position;
+  entry =
+      gst_util_array_binary_search (index_table->keyframes->data,
+      index_table->keyframes->len, sizeof (GstMXFDemuxKeyframe),
+      (GCompareDataFunc) gst_mxf_demux_keyframe_position_search,
+      GST_SEARCH_MODE_BEFORE, &search_position, NULL);
+  if (!entry)
+    return -1;
+
+  *position = entry->position;
+  return entry->offset;
+}
+
 static guint64
 gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
     GstMXFDemuxEssenceTrack * etrack, gint64 * position, gboolean keyframe)
@@ -2824,19 +3126,8 @@ gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
       " of track %u with body_sid %u (keyframe %d)", *position,
       etrack->track_number, etrack->body_sid, keyframe);
 
-  if (demux->index_tables) {
-    GList *l;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-  }
+  if (demux->index_tables)
+    index_table = gst_mxf_demux_find_index_table (demux, etrack);
 
 from_index:
 
@@ -2867,7 +3158,8 @@ from_index:
     }
 
     if (index_table) {
-      offset = find_closest_offset (index_table->offsets, position, keyframe);
+      offset =
+          find_closest_index_table_offset (index_table, position, keyframe);
       if (offset != -1) {
         GST_DEBUG_OBJECT (demux,
             "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2877,27 +3169,19 @@ from_index:
       }
     }
   } else if (demux->random_access) {
-    gint64 index_start_position = *position;
+    gint64 index_start_position = -1;
+    gint64 tmp_position;
 
     demux->offset = demux->run_in;
 
-    offset =
-        find_closest_offset (etrack->offsets, &index_start_position, FALSE);
-    if (offset != -1) {
-      demux->offset = offset + demux->run_in;
-      GST_DEBUG_OBJECT (demux,
-          "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
-          " in generated index at offset %" G_GUINT64_FORMAT,
-          index_start_position, requested_position, offset);
-    } else {
-      index_start_position = -1;
-    }
-
+    /* Look into the index table first, its keyframes can be binary
+     * searched and give a lower bound for the generated index */
     if (index_table) {
-      gint64 tmp_position = *position;
+      tmp_position = *position;
 
-      offset = find_closest_offset (index_table->offsets, &tmp_position, TRUE);
-      if (offset != -1 && tmp_position > index_start_position) {
+      offset =
+          find_closest_index_table_offset (index_table, &tmp_position, TRUE);
+      if (offset != -1) {
         demux->offset = offset + demux->run_in;
         index_start_position = tmp_position;
         GST_DEBUG_OBJECT (demux,
@@ -2907,6 +3191,29 @@ from_index:
       }
     }
 
+    if (etrack->offsets && etrack->offsets->len > index_start_position + 1) {
+      GArray *offsets = etrack->offsets;
+      guint64 last = MIN (*position, offsets->len - 1);
+
+      /* Only entries after the index table keyframe are better */
+      for (tmp_position = last; tmp_position > index_start_position;
+          tmp_position--) {
+        GstMXFDemuxIndex *idx =
+            &g_array_index (offsets, GstMXFDemuxIndex, tmp_position);
+
+        if (idx->offset != 0) {
+          demux->offset = idx->offset + demux->run_in;
+          index_start_position = tmp_position;
+          GST_DEBUG_OBJECT (demux,
+              "Starting with edit unit %" G_GINT64_FORMAT " for %"
+              G_GINT64_FORMAT " in generated index at offset %"
+              G_GUINT64_FORMAT, index_start_position, requested_position,
+              idx->offset);
+          break;
+        }
+      }
+    }
+
     gst_mxf_demux_set_partition_for_offset (demux, demux->offset);
 
     for (i = 0; i < demux->essence_tracks->len; i++) {
@@ -2931,7 +3238,8 @@ from_index:
           gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
           &read);
 
-      if (ret == GST_FLOW_EOS) {
+      /* The end of a growing file is not the end of the essence */
+      if (ret == GST_FLOW_EOS && !demux->growing_file) {
         for (i = 0; i < demux->essence_tracks->len; i++) {
           GstMXFDemuxEssenceTrack *t =
               &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack,
@@ -2991,6 +3299,101 @@ from_index:
   return -1;
 }
 
+/* Waits until a growing file got larger, for at most
+ * GROWING_FILE_POLL_INTERVAL or until interrupted by a seek or
+ * state change. Returns FALSE if the file did not grow for longer
+ * than the growing-file-timeout */
+static gboolean
+gst_mxf_demux_wait_for_growing_file (GstMXFDemux * demux)
+{
+  gint64 size = -1;
+  gint64 now, end_time;
+
+  now = g_get_monotonic_time ();
+
+  if (gst_pad_peer_query_duration (demux->sinkpad, GST_FORMAT_BYTES, &size)
+      && size > demux->growing_file_size) {
+    GST_DEBUG_OBJECT (demux, "File grew to %" G_GINT64_FORMAT " bytes", size);
+    demux->growing_file_size = size;
+    demux->growing_file_last_growth = now;
+    return TRUE;
+  }
+
+  if (demux->growing_file_last_growth == 0)
+    demux->growing_file_last_growth = now;
+
+  if (GST_CLOCK_TIME_IS_VALID (demux->growing_file_timeout)
+      && now - demux->growing_file_last_growth >=
+      demux->growing_file_timeout / GST_USECOND) {
+    GST_INFO_OBJECT (demux, "File did not grow for %" GST_TIME_FORMAT
+        ", taking it as finished", GST_TIME_ARGS (demux->growing_file_timeout));
+    return FALSE;
+  }
+
+  GST_LOG_OBJECT (demux, "Waiting for file to grow at offset %"
+      G_GUINT64_FORMAT ", complete up to body offset %" G_GUINT64_FORMAT,
+      demux->offset, demux->growing_file_body_offset);
+
+  end_time = now + GROWING_FILE_POLL_INTERVAL / GST_USECOND;
+
+  g_mutex_lock (&demux->growing_file_lock);
+  while (!demux->growing_file_unblock) {
+    if (!g_cond_wait_until (&demux->growing_file_cond,
+            &demux->growing_file_lock, end_time))
+      break;
+  }
+  g_mutex_unlock (&demux->growing_file_lock);
+
+  return TRUE;
+}
+
+/* Parses all descriptive metadata that was skipped in lazy mode and
+ * resolves the metadata again */
+static GstFlowReturn
+gst_mxf_demux_parse_pending_descriptive_metadata (GstMXFDemux * demux)
+{
+  GHashTableIter iter;
+  GstMXFDemuxPendingMetadata *pending;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (g_hash_table_size (demux->pending_descriptive_metadata) == 0)
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (demux, "Parsing %u postponed descriptive metadata sets",
+      g_hash_table_size (demux->pending_descriptive_metadata));
+
+  g_hash_table_iter_init (&iter, demux->pending_descriptive_metadata);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) & pending)) {
+    GstBuffer *buffer = NULL;
+    MXFUL key;
+
+    if (gst_mxf_demux_pull_klv_packet (demux, pending->offset, &key, &buffer,
+            NULL) != GST_FLOW_OK) {
+      GST_WARNING_OBJECT (demux, "Failed to pull descriptive metadata at "
+          "offset %" G_GUINT64_FORMAT, pending->offset);
+      continue;
+    }
+
+    gst_mxf_demux_add_descriptive_metadata (demux, &key,
+        &pending->partition->primer, pending->offset, buffer);
+    gst_buffer_unref (buffer);
+  }
+
+  g_hash_table_remove_all (demux->pending_descriptive_metadata);
+
+  /* Resolve again even if nothing could be parsed, DM segments are not
+   * pending anymore */
+  if (demux->preface) {
+    if ((ret = gst_mxf_demux_resolve_references (demux)) != GST_FLOW_OK ||
+        (ret = gst_mxf_demux_update_tracks (demux)) != GST_FLOW_OK)
+      return ret;
+
+    g_object_notify (G_OBJECT (demux), "structure");
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
 {
@@ -2999,6 +3402,13 @@ gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
   GstFlowReturn ret = GST_FLOW_OK;
   guint read = 0;
 
+  if (g_atomic_int_compare_and_exchange (&demux->parse_descriptive_metadata,
+          TRUE, FALSE)) {
+    ret = gst_mxf_demux_parse_pending_descriptive_metadata (demux);
+    if (ret != GST_FLOW_OK)
+      goto beach;
+  }
+
   if (demux->src->len > 0) {
     if (!gst_mxf_demux_get_earliest_pad (demux)) {
       ret = GST_FLOW_EOS;
@@ -3011,6 +3421,18 @@ gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
       gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
       &read);
 
+  /* A growing file is only finished once the footer partition or
+   * the RIP is there, or once it stopped growing. Until then try
+   * again at the same offset */
+  if (ret == GST_FLOW_EOS && demux->growing_file && !demux->random_index_pack
+      && (!demux->current_partition
+          || demux->current_partition->partition.type !=
+          MXF_PARTITION_PACK_FOOTER)
+      && gst_mxf_demux_wait_for_growing_file (demux)) {
+    ret = GST_FLOW_OK;
+    goto beach;
+  }
+
   if (ret == GST_FLOW_EOS && demux->src->len > 0) {
     guint i;
     GstMXFDemuxPad *p = NULL;
@@ -3216,6 +3638,10 @@ pause:
     gst_pad_pause_task (pad);
 
     if (flow == GST_FLOW_EOS) {
+      /* Descriptive metadata that was postponed is needed at the latest
+       * for the final structure */
+      gst_mxf_demux_parse_pending_descriptive_metadata (demux);
+
       /* perform EOS logic */
       if (demux->src->len == 0) {
         GST_ELEMENT_ERROR (demux, STREAM, WRONG_TYPE,
@@ -3665,6 +4091,101 @@ no_new_offset:
   }
 }
 
+/* Essence byte range of a partition, used to map index table
+ * stream offsets to file offsets */
+typedef struct
+{
+  guint64 body_offset;
+  guint64 essence_offset;
+  /* Offset of the following partition, or G_MAXUINT64 */
+  guint64 next_partition;
+} GstMXFDemuxPartitionRange;
+
+static gint
+gst_mxf_demux_partition_range_search (GstMXFDemuxPartitionRange * range,
+    guint64 * offset, gpointer user_data)
+{
+  if (range->body_offset < *offset)
+    return -1;
+  else if (range->body_offset > *offset)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+gst_mxf_demux_fill_partition_ranges (GstMXFDemux * demux, guint32 body_sid,
+    GArray * ranges)
+{
+  GList *m;
+
+  g_array_set_size (ranges, 0);
+
+  for (m = demux->partitions; m; m = m->next) {
+    GstMXFDemuxPartition *partition = m->data;
+    GstMXFDemuxPartitionRange range;
+
+    if (partition->partition.body_sid != body_sid)
+      continue;
+
+    /* Body offsets must be increasing for the same BodySID */
+    if (ranges->len > 0
+        && g_array_index (ranges, GstMXFDemuxPartitionRange,
+            ranges->len - 1).body_offset > partition->partition.body_offset) {
+      GST_WARNING_OBJECT (demux, "Partition body offsets not increasing");
+      continue;
+    }
+
+    range.body_offset = partition->partition.body_offset;
+    range.essence_offset =
+        partition->partition.this_partition +
+        partition->essence_container_offset;
+    range.next_partition = G_MAXUINT64;
+    if (m->next) {
+      GstMXFDemuxPartition *next = m->next->data;
+      range.next_partition = next->partition.this_partition;
+    }
+
+    g_array_append_val (ranges, range);
+  }
+}
+
+/* Updates the keyframes from the first position that changed since
+ * the last update on */
+static void
+gst_mxf_demux_index_table_update_keyframes (GstMXFDemuxIndexTable * t)
+{
+  guint64 i;
+
+  if (!t->keyframes)
+    t->keyframes = g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxKeyframe));
+  while (t->keyframes->len > 0
+      && g_array_index (t->keyframes, GstMXFDemuxKeyframe,
+          t->keyframes->len - 1).position >= t->keyframes_dirty)
+    g_array_set_size (t->keyframes, t->keyframes->len - 1);
+
+  for (i = t->keyframes_dirty; i < t->offsets->len; i++) {
+    GstMXFDemuxIndex *index = &g_array_index (t->offsets, GstMXFDemuxIndex, i);
+    GstMXFDemuxKeyframe keyframe;
+
+    if (!index->initialized || index->offset == 0 || !index->keyframe)
+      continue;
+
+    /* Keep the list sorted by offset too, broken entries are
+     * still available in the offsets array */
+    if (t->keyframes->len > 0
+        && g_array_index (t->keyframes, GstMXFDemuxKeyframe,
+            t->keyframes->len - 1).offset >= index->offset)
+      continue;
+
+    keyframe.position = i;
+    keyframe.offset = index->offset;
+    g_array_append_val (t->keyframes, keyframe);
+  }
+
+  t->keyframes_dirty = G_MAXUINT64;
+}
+
 static void
 collect_index_table_segments (GstMXFDemux * demux)
 {
@@ -3672,11 +4193,17 @@ collect_index_table_segments (GstMXFDemux * demux)
   guint i;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
+  GArray *ranges;
+  guint32 ranges_body_sid = 0;
+  gboolean have_ranges = FALSE;
 
-  if (!demux->random_index_pack)
+  /* Without a RIP not all partitions are known. Growing files are
+   * expected to only index essence that was already written */
+  if (!demux->random_index_pack && !demux->growing_file)
     return;
 
-  for (i = 0; i < demux->random_index_pack->len; i++) {
+  for (i = 0; demux->random_index_pack && i < demux->random_index_pack->len;
+      i++) {
     MXFRandomIndexPackEntry *e =
         &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
 
@@ -3692,11 +4219,13 @@ collect_index_table_segments (GstMXFDemux * demux)
   demux->offset = old_offset;
   demux->current_partition = old_partition;
 
+  ranges = g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxPartitionRange));
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
     GstMXFDemuxIndexTable *t = NULL;
     GList *k;
-    guint64 start, end;
+    guint64 start, end, n_entries;
 
     for (k = demux->index_tables; k; k = k->next) {
       GstMXFDemuxIndexTable *tmp = k->data;
@@ -3721,47 +4250,67 @@ collect_index_table_segments (GstMXFDemux * demux)
     if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
       demux->index_tables = g_list_remove (demux->index_tables, t);
       g_array_free (t->offsets, TRUE);
+      if (t->keyframes)
+        g_array_free (t->keyframes, TRUE);
       g_free (t);
       continue;
     }
 
     if (t->offsets->len < end)
       g_array_set_size (t->offsets, end);
+    t->keyframes_dirty = MIN (t->keyframes_dirty, start);
 
-    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
-        i++) {
-      guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
-      GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+    /* Segments usually all belong to the same BodySID */
+    if (!have_ranges || ranges_body_sid != t->body_sid) {
+      gst_mxf_demux_fill_partition_ranges (demux, t->body_sid, ranges);
+      ranges_body_sid = t->body_sid;
+      have_ranges = TRUE;
+    }
 
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
+    /* CBE segments have no entries, all edit units have the same size */
+    n_entries = segment->n_index_entries;
+    if (n_entries == 0 && segment->edit_unit_byte_count != 0)
+      n_entries = segment->index_duration;
 
-        if (!next_partition && offset_partition)
-          next_partition = partition;
+    for (i = 0; i < n_entries && start + i < t->offsets->len; i++) {
+      guint64 offset;
+      gint8 temporal_offset = 0;
+      gboolean keyframe = TRUE;
+      GstMXFDemuxPartitionRange *range = NULL;
+
+      if (segment->n_index_entries > 0) {
+        offset = segment->index_entries[i].stream_offset;
+        temporal_offset = segment->index_entries[i].temporal_offset;
+        keyframe = ! !(segment->index_entries[i].flags & 0x80)
+            || (segment->index_entries[i].key_frame_offset == 0);
+      } else {
+        offset = (start + i) * segment->edit_unit_byte_count;
+      }
 
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
-          break;
+      if (ranges->len > 0)
+        range =
+            gst_util_array_binary_search (ranges->data, ranges->len,
+            sizeof (GstMXFDemuxPartitionRange),
+            (GCompareDataFunc) gst_mxf_demux_partition_range_search,
+            GST_SEARCH_MODE_BEFORE, &offset, NULL);
 
-        offset_partition = partition;
-        next_partition = NULL;
-      }
+      if (range) {
+        guint r = range - (GstMXFDemuxPartitionRange *) ranges->data;
 
-      if (offset_partition && offset >= offset_partition->partition.body_offset) {
-        offset =
-            offset_partition->partition.this_partition +
-            offset_partition->essence_container_offset + (offset -
-            offset_partition->partition.body_offset);
+        /* With multiple partitions at the same body offset take the last */
+        while (r + 1 < ranges->len
+            && g_array_index (ranges, GstMXFDemuxPartitionRange,
+                r + 1).body_offset == range->body_offset)
+          r++;
+        range = &g_array_index (ranges, GstMXFDemuxPartitionRange, r);
 
-        if (next_partition
-            && offset >= next_partition->partition.this_partition) {
+        offset = range->essence_offset + (offset - range->body_offset);
+
+        if (offset >= range->next_partition) {
           GST_ERROR_OBJECT (demux,
               "Invalid index table segment going into next unrelated partition");
         } else {
           GstMXFDemuxIndex *index;
-          gint8 temporal_offset = segment->index_entries[i].temporal_offset;
           guint64 pts_i = G_MAXUINT64;
 
           if (temporal_offset > 0 ||
@@ -3793,14 +4342,18 @@ collect_index_table_segments (GstMXFDemux * demux)
           }
 
           index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
+          index->keyframe = keyframe;
           index->dts = pts_i;
         }
       }
     }
   }
 
+  g_array_free (ranges, TRUE);
+
+  for (l = demux->index_tables; l; l = l->next)
+    gst_mxf_demux_index_table_update_keyframes (l->data);
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *s = l->data;
     mxf_index_table_segment_reset (s);
@@ -3840,10 +4393,11 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
 
   keyunit_ts = start;
 
-  if (!demux->index_table_segments_collected) {
-    collect_index_table_segments (demux);
-    demux->index_table_segments_collected = TRUE;
-  }
+  /* Wake up the streaming thread if it waits for a growing file */
+  g_mutex_lock (&demux->growing_file_lock);
+  demux->growing_file_unblock = TRUE;
+  g_cond_signal (&demux->growing_file_cond);
+  g_mutex_unlock (&demux->growing_file_lock);
 
   if (flush) {
     GstEvent *e;
@@ -3862,6 +4416,10 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
   /* Take the stream lock */
   GST_PAD_STREAM_LOCK (demux->sinkpad);
 
+  g_mutex_lock (&demux->growing_file_lock);
+  demux->growing_file_unblock = FALSE;
+  g_mutex_unlock (&demux->growing_file_lock);
+
   if (flush) {
     GstEvent *e;
 
@@ -3871,6 +4429,12 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
     gst_pad_push_event (demux->sinkpad, e);
   }
 
+  /* Growing files can have new index table segments since the last seek */
+  if (!demux->index_table_segments_collected || demux->growing_file) {
+    collect_index_table_segments (demux);
+    demux->index_table_segments_collected = TRUE;
+  }
+
   /* Work on a copy until we are sure the seek succeeded. */
   memcpy (&seeksegment, &demux->segment, sizeof (GstSegment));
 
@@ -4517,6 +5081,15 @@ gst_mxf_demux_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       demux->seqnum = gst_util_seqnum_next ();
+      g_mutex_lock (&demux->growing_file_lock);
+      demux->growing_file_unblock = FALSE;
+      g_mutex_unlock (&demux->growing_file_lock);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      g_mutex_lock (&demux->growing_file_lock);
+      demux->growing_file_unblock = TRUE;
+      g_cond_signal (&demux->growing_file_cond);
+      g_mutex_unlock (&demux->growing_file_lock);
       break;
     default:
       break;
@@ -4551,12 +5124,31 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_LAZY_DESCRIPTIVE_METADATA:
+      demux->lazy_descriptive_metadata = g_value_get_boolean (value);
+      break;
+    case PROP_GROWING_FILE:
+      demux->growing_file = g_value_get_boolean (value);
+      break;
+    case PROP_GROWING_FILE_TIMEOUT:
+      demux->growing_file_timeout = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_mxf_demux_request_descriptive_metadata (GstMXFDemux * demux)
+{
+  if (!demux->lazy_descriptive_metadata)
+    return;
+
+  GST_DEBUG_OBJECT (demux, "Postponed descriptive metadata requested");
+  g_atomic_int_set (&demux->parse_descriptive_metadata, TRUE);
+}
+
 static void
 gst_mxf_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -4589,6 +5181,15 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
       g_rw_lock_reader_unlock (&demux->metadata_lock);
       break;
     }
+    case PROP_LAZY_DESCRIPTIVE_METADATA:
+      g_value_set_boolean (value, demux->lazy_descriptive_metadata);
+      break;
+    case PROP_GROWING_FILE:
+      g_value_set_boolean (value, demux->growing_file);
+      break;
+    case PROP_GROWING_FILE_TIMEOUT:
+      g_value_set_uint64 (value, demux->growing_file_timeout);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4628,8 +5229,11 @@ gst_mxf_demux_finalize (GObject * object)
   demux->essence_tracks = NULL;
 
   g_hash_table_destroy (demux->metadata);
+  g_hash_table_destroy (demux->pending_descriptive_metadata);
 
   g_rw_lock_clear (&demux->metadata_lock);
+  g_mutex_clear (&demux->growing_file_lock);
+  g_cond_clear (&demux->growing_file_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -4664,6 +5268,45 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class,
+      PROP_LAZY_DESCRIPTIVE_METADATA,
+      g_param_spec_boolean ("lazy-descriptive-metadata",
+          "Lazy descriptive metadata",
+          "In pull mode only parse descriptive metadata (e.g. DMS-1) once "
+          "the parse-descriptive-metadata signal is emitted or at EOS, "
+          "notify::structure is emitted when it is available", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROWING_FILE,
+      g_param_spec_boolean ("growing-file", "Growing file",
+          "In pull mode wait for more data at the end of files that are "
+          "still being written, until the footer partition is written",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROWING_FILE_TIMEOUT,
+      g_param_spec_uint64 ("growing-file-timeout", "Growing file timeout",
+          "Time in nanoseconds after which a growing file that has no footer "
+          "partition yet is taken as finished if it does not grow anymore "
+          "(-1 = wait forever)", 0, G_MAXUINT64, DEFAULT_GROWING_FILE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMXFDemux::parse-descriptive-metadata:
+   * @mxfdemux: the element on which the signal is emitted
+   *
+   * Requests the descriptive metadata that was postponed by
+   * #GstMXFDemux:lazy-descriptive-metadata to be parsed by the streaming
+   * thread. notify::structure is emitted once that is done.
+   */
+  gst_mxf_demux_signals[SIGNAL_PARSE_DESCRIPTIVE_METADATA] =
+      g_signal_new ("parse-descriptive-metadata", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstMXFDemuxClass, parse_descriptive_metadata), NULL,
+      NULL, NULL, G_TYPE_NONE, 0, G_TYPE_NONE);
+
+  klass->parse_descriptive_metadata =
+      GST_DEBUG_FUNCPTR (gst_mxf_demux_request_descriptive_metadata);
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -4695,14 +5338,20 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = 500 * GST_MSECOND;
+  demux->growing_file_timeout = DEFAULT_GROWING_FILE_TIMEOUT;
 
   demux->adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
   g_rw_lock_init (&demux->metadata_lock);
+  g_mutex_init (&demux->growing_file_lock);
+  g_cond_init (&demux->growing_file_cond);
 
   demux->src = g_ptr_array_new ();
   demux->essence_tracks =
       g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxEssenceTrack));
+  demux->pending_descriptive_metadata =
+      g_hash_table_new_full ((GHashFunc) mxf_uuid_hash,
+      (GEqualFunc) mxf_uuid_is_equal, NULL, (GDestroyNotify) g_free);
 
   gst_segment_init (&demux->segment, GST_FORMAT_TIME);
 
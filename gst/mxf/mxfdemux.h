@@ -57,6 +57,14 @@ typedef struct
   guint64 essence_container_offset;
 } GstMXFDemuxPartition;
 
+/* Descriptive metadata KLV packet that was not parsed yet */
+typedef struct
+{
+  MXFUUID instance_uid;
+  GstMXFDemuxPartition *partition;
+  guint64 offset;
+} GstMXFDemuxPendingMetadata;
+
 typedef struct
 {
   guint32 body_sid;
@@ -99,6 +107,13 @@ typedef struct
   gboolean initialized;
 } GstMXFDemuxIndex;
 
+typedef struct
+{
+  /* DTS edit unit number */
+  guint64 position;
+  guint64 offset;
+} GstMXFDemuxKeyframe;
+
 typedef struct
 {
   guint32 body_sid;
@@ -106,6 +121,12 @@ typedef struct
 
   /* offsets indexed by DTS */
   GArray *offsets;
+
+  /* GstMXFDemuxKeyframe for all keyframes in offsets, sorted by
+   * position and offset for binary searching */
+  GArray *keyframes;
+  /* first position in offsets changed since keyframes was updated */
+  guint64 keyframes_dirty;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -170,9 +191,27 @@ struct _GstMXFDemux
 
   guint64 offset;
 
+  /* Read-ahead window for pull mode, small KLV reads are
+   * served as sub-buffers of it */
+  GstBuffer *read_ahead;
+  guint64 read_ahead_offset;
+
   gboolean random_access;
   gboolean flushing;
 
+  /* Growing file mode, waiting for more data is interrupted
+   * by setting growing_file_unblock */
+  GMutex growing_file_lock;
+  GCond growing_file_cond;
+  gboolean growing_file_unblock;
+  gint64 growing_file_size;
+  /* monotonic time of the last growth, 0 if not waited yet */
+  gint64 growing_file_last_growth;
+  /* last partition followed by another one, and the body offset
+   * up to which its essence is complete */
+  GstMXFDemuxPartition *growing_file_partition;
+  guint64 growing_file_body_offset;
+
   guint64 run_in;
 
   guint64 header_partition_pack_offset;
@@ -199,6 +238,11 @@ struct _GstMXFDemux
   MXFMetadataPreface *preface;
   GHashTable *metadata;
 
+  /* GstMXFDemuxPendingMetadata by instance UID, only used
+   * with lazy-descriptive-metadata in pull mode */
+  GHashTable *pending_descriptive_metadata;
+  gint parse_descriptive_metadata;
+
   MXFUMID current_package_uid;
   MXFMetadataGenericPackage *current_package;
   gchar *current_package_string;
@@ -208,11 +252,17 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gboolean lazy_descriptive_metadata;
+  gboolean growing_file;
+  GstClockTime growing_file_timeout;
 };
 
 struct _GstMXFDemuxClass
 {
   GstElementClass parent_class;
+
+  /* action signals */
+  void (*parse_descriptive_metadata) (GstMXFDemux * demux);
 };
 
 GType gst_mxf_demux_get_type (void);
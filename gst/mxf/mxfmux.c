@@ -46,6 +46,14 @@
 GST_DEBUG_CATEGORY_STATIC (mxfmux_debug);
 #define GST_CAT_DEFAULT mxfmux_debug
 
+/* Maximum number of entries per index table segment, 11 bytes
+ * per entry have to fit into a 16 bit local tag length */
+#define MAX_INDEX_SEGMENT_SIZE (G_MAXUINT16 / 11)
+
+/* Entries of an index table segment can still be updated with the
+ * temporal offset of a frame up to this many edit units later */
+#define MAX_TEMPORAL_OFFSET 127
+
 #define GST_TYPE_MXF_MUX_PAD            (gst_mxf_mux_pad_get_type())
 #define GST_MXF_MUX_PAD(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MXF_MUX_PAD, GstMXFMuxPad))
 #define GST_MXF_MUX_PAD_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_MXF_MUX_PAD, GstMXFMuxPadClass))
@@ -190,6 +198,8 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->body_partitions =
+      g_array_new (FALSE, FALSE, sizeof (GstMXFMuxBodyPartition));
   gst_mxf_mux_reset (mux);
 }
 
@@ -216,6 +226,11 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  if (mux->body_partitions) {
+    g_array_free (mux->body_partitions, TRUE);
+    mux->body_partitions = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -267,6 +282,10 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   g_array_set_size (mux->index_table, 0);
   mux->current_index_pos = 0;
   mux->last_keyframe_pos = 0;
+  mux->n_written_index_segments = 0;
+
+  if (mux->body_partitions)
+    g_array_set_size (mux->body_partitions, 0);
 }
 
 static gboolean
@@ -1200,6 +1219,158 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
   return ret;
 }
 
+static void
+gst_mxf_mux_append_index_table_segment (GstMXFMux * mux, GstMXFMuxPad * pad)
+{
+  MXFIndexTableSegment s;
+
+  memset (&s, 0, sizeof (s));
+
+  mxf_uuid_init (&s.instance_id, mux->metadata);
+  memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
+      sizeof (s.index_edit_rate));
+  /* All but the last segment are complete */
+  s.index_start_position = mux->index_table->len * MAX_INDEX_SEGMENT_SIZE;
+  s.index_duration = 0;
+  s.edit_unit_byte_count = 0;
+  s.index_sid =
+      mux->preface->content_storage->essence_container_data[0]->index_sid;
+  s.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+  s.slice_count = 0;
+  s.pos_table_count = 0;
+  s.n_delta_entries = 0;
+  s.delta_entries = NULL;
+  s.n_index_entries = 0;
+  s.index_entries = g_new0 (MXFIndexEntry, MAX_INDEX_SEGMENT_SIZE);
+  g_array_append_val (mux->index_table, s);
+}
+
+/* Writes the segment as a CBE segment if all edit units from the start
+ * of the essence stream up to @end_offset have the same size and are
+ * keyframes, otherwise as a VBE segment */
+static GstBuffer *
+gst_mxf_mux_index_table_segment_to_buffer (const MXFIndexTableSegment *
+    segment, guint64 end_offset)
+{
+  MXFIndexTableSegment cbe;
+  guint64 edit_unit_byte_count;
+  guint i;
+
+  if (segment->n_index_entries == 0
+      || end_offset <= segment->index_entries[0].stream_offset)
+    goto vbe;
+
+  edit_unit_byte_count =
+      (end_offset -
+      segment->index_entries[0].stream_offset) / segment->n_index_entries;
+  if (edit_unit_byte_count == 0 || edit_unit_byte_count > G_MAXUINT32)
+    goto vbe;
+
+  if (end_offset !=
+      (segment->index_start_position +
+          segment->n_index_entries) * edit_unit_byte_count)
+    goto vbe;
+
+  for (i = 0; i < segment->n_index_entries; i++) {
+    const MXFIndexEntry *e = &segment->index_entries[i];
+
+    if (e->stream_offset !=
+        (segment->index_start_position + i) * edit_unit_byte_count
+        || e->flags != 0x80 || e->temporal_offset != 0
+        || e->key_frame_offset != 0)
+      goto vbe;
+  }
+
+  memcpy (&cbe, segment, sizeof (cbe));
+  cbe.edit_unit_byte_count = edit_unit_byte_count;
+  cbe.n_index_entries = 0;
+
+  return mxf_index_table_segment_to_buffer (&cbe);
+
+vbe:
+  return mxf_index_table_segment_to_buffer (segment);
+}
+
+/* Writes a new body partition, preceded by the next @n_index_segments
+ * index table segments that were not written yet. The footer partition
+ * is not known yet, so the partition is written as open and incomplete
+ * and rewritten at EOS */
+static GstFlowReturn
+gst_mxf_mux_write_body_partition (GstMXFMux * mux, guint n_index_segments)
+{
+  GstBuffer *buf;
+  GList *index_buffers = NULL, *l;
+  guint64 index_byte_count = 0;
+  GstMXFMuxBodyPartition body_partition;
+  GstFlowReturn ret;
+  guint i;
+
+  g_assert (mux->n_written_index_segments + n_index_segments <
+      mux->index_table->len || n_index_segments == 0);
+
+  for (i = 0; i < n_index_segments; i++) {
+    guint n = mux->n_written_index_segments + i;
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, n);
+    /* The following segment has at least MAX_TEMPORAL_OFFSET entries */
+    guint64 end_offset = g_array_index (mux->index_table, MXFIndexTableSegment,
+        n + 1).index_entries[0].stream_offset;
+
+    buf = gst_mxf_mux_index_table_segment_to_buffer (segment, end_offset);
+    index_byte_count += gst_buffer_get_size (buf);
+    index_buffers = g_list_prepend (index_buffers, buf);
+  }
+  index_buffers = g_list_reverse (index_buffers);
+  mux->n_written_index_segments += n_index_segments;
+
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.closed = FALSE;
+  mux->partition.complete = FALSE;
+  mux->partition.prev_partition = mux->partition.this_partition;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.header_byte_count = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count > 0 ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
+  /* body_offset stays at the essence stream offset written so far */
+  mux->partition.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+
+  body_partition.this_partition = mux->partition.this_partition;
+  body_partition.prev_partition = mux->partition.prev_partition;
+  body_partition.index_byte_count = mux->partition.index_byte_count;
+  body_partition.index_sid = mux->partition.index_sid;
+  body_partition.body_offset = mux->partition.body_offset;
+  g_array_append_val (mux->body_partitions, body_partition);
+
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (mux, "Failed pushing body partition: %s",
+        gst_flow_get_name (ret));
+    g_list_foreach (index_buffers, (GFunc) gst_mini_object_unref, NULL);
+    g_list_free (index_buffers);
+    return ret;
+  }
+
+  for (l = index_buffers; l; l = l->next) {
+    buf = l->data;
+    l->data = NULL;
+    if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (mux, "Failed pushing index table segment: %s",
+          gst_flow_get_name (ret));
+      g_list_foreach (l, (GFunc) gst_mini_object_unref, NULL);
+      g_list_free (index_buffers);
+      return ret;
+    }
+  }
+
+  g_list_free (index_buffers);
+
+  return ret;
+}
+
 static const guint8 _gc_essence_element_ul[] = {
   0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
@@ -1268,7 +1439,28 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
     MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
+    const gint max_segment_size = MAX_INDEX_SEGMENT_SIZE;
+    guint n_final = 0;
+
+    /* Start a new body partition with all index table segments whose
+     * entries can't be changed anymore by later temporal offsets */
+    while (mux->n_written_index_segments + n_final < mux->current_index_pos) {
+      segment =
+          &g_array_index (mux->index_table, MXFIndexTableSegment,
+          mux->n_written_index_segments + n_final);
+      if (pad->pos <
+          segment->index_start_position + segment->index_duration +
+          MAX_TEMPORAL_OFFSET)
+        break;
+      n_final++;
+    }
+
+    if (n_final > 0
+        && (ret = gst_mxf_mux_write_body_partition (mux,
+                n_final)) != GST_FLOW_OK) {
+      gst_buffer_unref (buf);
+      return ret;
+    }
 
     if (mux->index_table->len == 0 ||
         g_array_index (mux->index_table, MXFIndexTableSegment,
@@ -1277,34 +1469,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
       if (mux->index_table->len > 0)
         mux->current_index_pos++;
 
-      if (mux->index_table->len <= mux->current_index_pos) {
-        MXFIndexTableSegment s;
-
-        memset (&segment, 0, sizeof (segment));
-
-        mxf_uuid_init (&s.instance_id, mux->metadata);
-        memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-            sizeof (s.index_edit_rate));
-        if (mux->index_table->len > 0)
-          s.index_start_position =
-              g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
-        else
-          s.index_start_position = 0;
-        s.index_duration = 0;
-        s.edit_unit_byte_count = 0;
-        s.index_sid =
-            mux->preface->content_storage->essence_container_data[0]->index_sid;
-        s.body_sid =
-            mux->preface->content_storage->essence_container_data[0]->body_sid;
-        s.slice_count = 0;
-        s.pos_table_count = 0;
-        s.n_delta_entries = 0;
-        s.delta_entries = NULL;
-        s.n_index_entries = 0;
-        s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-        g_array_append_val (mux->index_table, s);
-      }
+      if (mux->index_table->len <= mux->current_index_pos)
+        gst_mxf_mux_append_index_table_segment (mux, pad);
     }
     segment =
         &g_array_index (mux->index_table, MXFIndexTableSegment,
@@ -1333,34 +1499,11 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
           pts_index_pos++;
 
           if (pts_index_pos >= mux->index_table->len) {
-            MXFIndexTableSegment s;
-
-            memset (&segment, 0, sizeof (segment));
-
-            mxf_uuid_init (&s.instance_id, mux->metadata);
-            memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-                sizeof (s.index_edit_rate));
-            if (mux->index_table->len > 0)
-              s.index_start_position =
-                  g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
-            else
-              s.index_start_position = 0;
-            s.index_duration = 0;
-            s.edit_unit_byte_count = 0;
-            s.index_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->index_sid;
-            s.body_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->body_sid;
-            s.slice_count = 0;
-            s.pos_table_count = 0;
-            s.n_delta_entries = 0;
-            s.delta_entries = NULL;
-            s.n_index_entries = 0;
-            s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-            g_array_append_val (mux->index_table, s);
+            gst_mxf_mux_append_index_table_segment (mux, pad);
+            /* May have been reallocated */
+            segment =
+                &g_array_index (mux->index_table, MXFIndexTableSegment,
+                mux->current_index_pos);
           }
         }
       } else {
@@ -1428,28 +1571,6 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
-static GstFlowReturn
-gst_mxf_mux_write_body_partition (GstMXFMux * mux)
-{
-  GstBuffer *buf;
-
-  mux->partition.type = MXF_PARTITION_PACK_BODY;
-  mux->partition.closed = TRUE;
-  mux->partition.complete = TRUE;
-  mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
-  mux->partition.footer_partition = 0;
-  mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
-  mux->partition.body_sid =
-      mux->preface->content_storage->essence_container_data[0]->body_sid;
-
-  buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
-}
-
 static GstFlowReturn
 gst_mxf_mux_handle_eos (GstMXFMux * mux)
 {
@@ -1565,7 +1686,12 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
   {
     guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 first_body_partition =
+        g_array_index (mux->body_partitions, GstMXFMuxBodyPartition,
+        0).this_partition;
+    guint32 body_sid =
+        mux->preface->content_storage->essence_container_data[0]->body_sid;
+    guint64 body_end_offset = mux->partition.body_offset;
     guint64 footer_partition = mux->offset;
     GArray *rip;
     GstFlowReturn ret;
@@ -1576,10 +1702,22 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     guint i;
     GstBuffer *buf;
 
-    for (i = 0; i < mux->index_table->len; i++) {
+    /* All remaining index table segments go into the footer */
+    for (i = mux->n_written_index_segments; i < mux->index_table->len; i++) {
       MXFIndexTableSegment *segment =
           &g_array_index (mux->index_table, MXFIndexTableSegment, i);
-      GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
+      guint64 end_offset = body_end_offset;
+      GstBuffer *segment_buffer;
+
+      if (i + 1 < mux->index_table->len
+          && g_array_index (mux->index_table, MXFIndexTableSegment,
+              i + 1).n_index_entries > 0)
+        end_offset =
+            g_array_index (mux->index_table, MXFIndexTableSegment,
+            i + 1).index_entries[0].stream_offset;
+
+      segment_buffer =
+          gst_mxf_mux_index_table_segment_to_buffer (segment, end_offset);
 
       index_byte_count += gst_buffer_get_size (segment_buffer);
       index_entries = g_list_prepend (index_entries, segment_buffer);
@@ -1608,13 +1746,19 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
+    rip =
+        g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry),
+        mux->body_partitions->len + 2);
     entry.offset = 0;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
+    for (i = 0; i < mux->body_partitions->len; i++) {
+      entry.offset =
+          g_array_index (mux->body_partitions, GstMXFMuxBodyPartition,
+          i).this_partition;
+      entry.body_sid = body_sid;
+      g_array_append_val (rip, entry);
+    }
     entry.offset = footer_partition;
     entry.body_sid = 0;
     g_array_append_val (rip, entry);
@@ -1648,26 +1792,43 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
         return ret;
       }
 
-      g_assert (mux->offset == body_partition);
+      g_assert (mux->offset == first_body_partition);
 
-      mux->partition.type = MXF_PARTITION_PACK_BODY;
-      mux->partition.closed = TRUE;
-      mux->partition.complete = TRUE;
-      mux->partition.this_partition = mux->offset;
-      mux->partition.prev_partition = 0;
-      mux->partition.footer_partition = footer_partition;
-      mux->partition.header_byte_count = 0;
-      mux->partition.index_byte_count = 0;
-      mux->partition.index_sid = 0;
-      mux->partition.body_offset = 0;
-      mux->partition.body_sid =
-          mux->preface->content_storage->essence_container_data[0]->body_sid;
+      /* Rewrite all body partitions as closed and complete, now that the
+       * footer partition is known */
+      for (i = 0; i < mux->body_partitions->len; i++) {
+        GstMXFMuxBodyPartition *p =
+            &g_array_index (mux->body_partitions, GstMXFMuxBodyPartition, i);
 
-      buf = mxf_partition_pack_to_buffer (&mux->partition);
-      ret = gst_mxf_mux_push (mux, buf);
-      if (ret != GST_FLOW_OK) {
-        GST_ERROR_OBJECT (mux, "Rewriting body partition failed");
-        return ret;
+        if (i > 0) {
+          gst_segment_init (&segment, GST_FORMAT_BYTES);
+          segment.start = segment.time = p->this_partition;
+          if (!gst_pad_push_event (GST_AGGREGATOR_SRC_PAD (mux),
+                  gst_event_new_segment (&segment))) {
+            GST_WARNING_OBJECT (mux, "Can't rewrite body partition");
+            break;
+          }
+          mux->offset = p->this_partition;
+        }
+
+        mux->partition.type = MXF_PARTITION_PACK_BODY;
+        mux->partition.closed = TRUE;
+        mux->partition.complete = TRUE;
+        mux->partition.this_partition = p->this_partition;
+        mux->partition.prev_partition = p->prev_partition;
+        mux->partition.footer_partition = footer_partition;
+        mux->partition.header_byte_count = 0;
+        mux->partition.index_byte_count = p->index_byte_count;
+        mux->partition.index_sid = p->index_sid;
+        mux->partition.body_offset = p->body_offset;
+        mux->partition.body_sid = body_sid;
+
+        buf = mxf_partition_pack_to_buffer (&mux->partition);
+        ret = gst_mxf_mux_push (mux, buf);
+        if (ret != GST_FLOW_OK) {
+          GST_ERROR_OBJECT (mux, "Rewriting body partition failed");
+          return ret;
+        }
       }
     } else {
       GST_WARNING_OBJECT (mux, "Can't rewrite header partition");
@@ -1758,7 +1919,7 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     GST_OBJECT_UNLOCK (mux);
 
     /* Write body partition */
-    ret = gst_mxf_mux_write_body_partition (mux);
+    ret = gst_mxf_mux_write_body_partition (mux, 0);
     if (ret != GST_FLOW_OK)
       goto error;
     mux->state = GST_MXF_MUX_STATE_DATA;
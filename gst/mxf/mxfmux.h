@@ -47,6 +47,16 @@ typedef enum
   GST_MXF_MUX_STATE_ERROR
 } GstMXFMuxState;
 
+/* Fields of a body partition pack that differ between partitions */
+typedef struct
+{
+  guint64 this_partition;
+  guint64 prev_partition;
+  guint64 index_byte_count;
+  guint32 index_sid;
+  guint64 body_offset;
+} GstMXFMuxBodyPartition;
+
 typedef struct _GstMXFMux {
   GstAggregator parent;
 
@@ -72,6 +82,11 @@ typedef struct _GstMXFMux {
   GArray *index_table;
   guint current_index_pos;
   guint64 last_keyframe_pos;
+  /* Segments that were already written into body partitions */
+  guint n_written_index_segments;
+
+  /* GstMXFMuxBodyPartition for every body partition */
+  GArray *body_partitions;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
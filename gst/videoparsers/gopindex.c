@@ -0,0 +1,126 @@
+/* GStreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GOP index messages shared by mpegvideoparse and mpeg4videoparse.
+ *
+ * Once a GOP is complete, an element message is posted with a "gop-index"
+ * structure holding:
+ *   "offset"           G_TYPE_UINT64   byte offset of the GOP in the stream
+ *   "timestamp"        G_TYPE_UINT64   PTS of the first picture, if known
+ *   "closed"           G_TYPE_BOOLEAN  whether the GOP is closed
+ *   "picture-types"    G_TYPE_STRING   one letter (I, P, B, ...) per picture
+ *   "picture-offsets"  GST_TYPE_ARRAY  G_TYPE_UINT64 byte offset per picture
+ * with the pictures in bitstream order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gopindex.h"
+
+void
+gst_gop_index_init (GopIndex * index)
+{
+  index->active = FALSE;
+  index->picture_types = g_string_new (NULL);
+  index->picture_offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+}
+
+void
+gst_gop_index_clear (GopIndex * index)
+{
+  if (index->picture_types) {
+    g_string_free (index->picture_types, TRUE);
+    index->picture_types = NULL;
+  }
+  if (index->picture_offsets) {
+    g_array_free (index->picture_offsets, TRUE);
+    index->picture_offsets = NULL;
+  }
+  index->active = FALSE;
+}
+
+/* drops the GOP collected so far, e.g. when flushing */
+void
+gst_gop_index_reset (GopIndex * index)
+{
+  g_string_truncate (index->picture_types, 0);
+  g_array_set_size (index->picture_offsets, 0);
+  index->active = FALSE;
+}
+
+/* posts the GOP collected so far, if any, and starts a new one */
+void
+gst_gop_index_start (GopIndex * index, GstElement * element, guint64 offset,
+    GstClockTime timestamp, gboolean closed)
+{
+  gst_gop_index_finish (index, element);
+
+  index->active = TRUE;
+  index->offset = offset;
+  index->timestamp = timestamp;
+  index->closed = closed;
+}
+
+void
+gst_gop_index_add_picture (GopIndex * index, guint64 offset,
+    gchar picture_type)
+{
+  /* pictures ahead of the first GOP can't be used as entry points */
+  if (!index->active)
+    return;
+
+  g_string_append_c (index->picture_types, picture_type);
+  g_array_append_val (index->picture_offsets, offset);
+}
+
+/* posts the GOP collected so far, if any */
+void
+gst_gop_index_finish (GopIndex * index, GstElement * element)
+{
+  GstStructure *s;
+  GValue offsets = G_VALUE_INIT;
+  GValue v = G_VALUE_INIT;
+  guint i;
+
+  if (!index->active)
+    return;
+
+  g_value_init (&offsets, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT64);
+  for (i = 0; i < index->picture_offsets->len; i++) {
+    g_value_set_uint64 (&v, g_array_index (index->picture_offsets, guint64,
+            i));
+    gst_value_array_append_value (&offsets, &v);
+  }
+  g_value_unset (&v);
+
+  s = gst_structure_new ("gop-index",
+      "offset", G_TYPE_UINT64, index->offset,
+      "timestamp", G_TYPE_UINT64, index->timestamp,
+      "closed", G_TYPE_BOOLEAN, index->closed,
+      "picture-types", G_TYPE_STRING, index->picture_types->str, NULL);
+  gst_structure_take_value (s, "picture-offsets", &offsets);
+
+  gst_element_post_message (element,
+      gst_message_new_element (GST_OBJECT_CAST (element), s));
+
+  gst_gop_index_reset (index);
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GOP_INDEX_H__
+#define __GST_GOP_INDEX_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GopIndex GopIndex;
+
+/* Pictures of the GOP currently being collected */
+struct _GopIndex
+{
+  gboolean active;
+
+  guint64 offset;
+  GstClockTime timestamp;
+  gboolean closed;
+
+  /* one letter per picture, in bitstream order */
+  GString *picture_types;
+  /* guint64 byte offset of each picture */
+  GArray *picture_offsets;
+};
+
+void gst_gop_index_init        (GopIndex * index);
+
+void gst_gop_index_clear       (GopIndex * index);
+
+void gst_gop_index_reset       (GopIndex * index);
+
+void gst_gop_index_start       (GopIndex   * index,
+                                GstElement * element,
+                                guint64      offset,
+                                GstClockTime timestamp,
+                                gboolean     closed);
+
+void gst_gop_index_add_picture (GopIndex * index,
+                                guint64    offset,
+                                gchar      picture_type);
+
+void gst_gop_index_finish      (GopIndex   * index,
+                                GstElement * element);
+
+G_END_DECLS
+#endif
@@ -199,6 +199,15 @@ gst_h264_parse_reset_frame (GstH264Parse * h264parse)
   gst_adapter_clear (h264parse->frame_out);
 }
 
+static void
+gst_h264_parse_clear_config_nals (GstH264Parse * h264parse)
+{
+  if (h264parse->config_nals) {
+    gst_memory_unref (h264parse->config_nals);
+    h264parse->config_nals = NULL;
+  }
+}
+
 static void
 gst_h264_parse_reset_stream_info (GstH264Parse * h264parse)
 {
@@ -236,6 +245,7 @@ gst_h264_parse_reset_stream_info (GstH264Parse * h264parse)
     gst_buffer_replace (&h264parse->sps_nals[i], NULL);
   for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++)
     gst_buffer_replace (&h264parse->pps_nals[i], NULL);
+  gst_h264_parse_clear_config_nals (h264parse);
 }
 
 static void
@@ -446,6 +456,38 @@ gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Like gst_h264_parse_wrap_nal(), but for a NAL that lives in @buffer at
+ * @offset. The NAL payload is shared with @buffer rather than copied, and
+ * only the start code or length prefix gets a memory of its own */
+static GstBuffer *
+gst_h264_parse_wrap_nal_region (GstH264Parse * h264parse, guint format,
+    GstBuffer * buffer, guint offset, guint size)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  GstBuffer *buf;
+  guint nl = h264parse->nal_length_size;
+  guint32 tmp;
+
+  GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
+
+  buf = gst_buffer_new ();
+  if (format == GST_H264_PARSE_FORMAT_AVC
+      || format == GST_H264_PARSE_FORMAT_AVC3) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, nl, NULL));
+    gst_buffer_fill (buf, 0, &tmp, nl);
+  } else {
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) start_code, sizeof (start_code), 0,
+            sizeof (start_code), NULL, NULL));
+  }
+
+  gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return buf;
+}
+
 static void
 gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     GstH264NalUnitType naltype, GstH264NalUnit * nalu)
@@ -469,6 +511,15 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     return;
   }
 
+  /* parameter sets are usually repeated verbatim, keep what we have then */
+  if (store[id] && gst_buffer_get_size (store[id]) == size &&
+      gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset, size) == 0) {
+    GST_LOG_OBJECT (h264parse, "nal unchanged");
+    return;
+  }
+
+  gst_h264_parse_clear_config_nals (h264parse);
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -698,9 +749,11 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   g_array_free (messages, TRUE);
 }
 
-/* caller guarantees 2 bytes of nal payload */
+/* caller guarantees 2 bytes of nal payload; @buffer is the buffer
+ * nalu->data was mapped from */
 static gboolean
-gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
+gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu,
+    GstBuffer * buffer)
 {
   guint nal_type;
   GstH264PPS pps = { 0, };
@@ -833,8 +886,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       {
         GstH264SliceHdr slice;
 
-        pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
-            FALSE, FALSE);
+        pres =
+            gst_h264_parser_parse_slice_hdr_light (nalparser, nalu, &slice);
         GST_DEBUG_OBJECT (h264parse,
             "parse result %d, first MB: %u, slice type: %u",
             pres, slice.first_mb_in_slice, slice.type);
@@ -893,8 +946,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    buf = gst_h264_parse_wrap_nal_region (h264parse, h264parse->format, buffer,
+        nalu->offset, nalu->size);
     gst_adapter_push (h264parse->frame_out, buf);
   }
   return TRUE;
@@ -992,7 +1045,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h264_parse_process_nal (h264parse, &nalu);
+    gst_h264_parse_process_nal (h264parse, &nalu, buffer);
 
     /* dispatch per NALU if needed */
     if (h264parse->split_packetized) {
@@ -1230,7 +1283,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h264_parse_process_nal (h264parse, &nalu)) {
+    if (!gst_h264_parse_process_nal (h264parse, &nalu, buffer)) {
       GST_WARNING_OBJECT (h264parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2145,7 +2198,7 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2268,6 +2321,78 @@ gst_h264_parse_prepare_key_unit (GstH264Parse * parse, GstEvent * event)
   parse->push_codec = TRUE;
 }
 
+static gboolean
+gst_h264_parse_put_config_nal (GstH264Parse * h264parse, GstByteWriter * bw,
+    GstBuffer * codec_nal)
+{
+  gsize nal_size = gst_buffer_get_size (codec_nal);
+  const gint nls = 4 - h264parse->nal_length_size;
+  gboolean ok;
+
+  if (h264parse->format == GST_H264_PARSE_FORMAT_BYTE) {
+    ok = gst_byte_writer_put_uint32_be (bw, 1);
+  } else {
+    ok = gst_byte_writer_put_uint32_be (bw, (nal_size << (nls * 8)));
+    ok &= gst_byte_writer_set_pos (bw, gst_byte_writer_get_pos (bw) - nls);
+  }
+  ok &= gst_byte_writer_put_buffer (bw, codec_nal, 0, nal_size);
+
+  return ok;
+}
+
+/* Returns the stored SPS/PPS, each with a start code or length prefix, as a
+ * single read-only memory, or NULL if there are none. It is only rebuilt
+ * when a parameter set or the output format changes, so every inserted
+ * access unit can share it. */
+static GstMemory *
+gst_h264_parse_get_config_nals (GstH264Parse * h264parse)
+{
+  GstByteWriter bw;
+  GstBuffer *codec_nal;
+  gboolean ok = TRUE;
+  guint8 *data;
+  guint size;
+  gint i;
+
+  if (h264parse->config_nals &&
+      h264parse->config_nals_format == h264parse->format &&
+      h264parse->config_nals_nl == h264parse->nal_length_size)
+    return h264parse->config_nals;
+
+  gst_h264_parse_clear_config_nals (h264parse);
+
+  gst_byte_writer_init (&bw);
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
+    if ((codec_nal = h264parse->sps_nals[i]))
+      ok &= gst_h264_parse_put_config_nal (h264parse, &bw, codec_nal);
+  }
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
+    if ((codec_nal = h264parse->pps_nals[i]))
+      ok &= gst_h264_parse_put_config_nal (h264parse, &bw, codec_nal);
+  }
+
+  size = gst_byte_writer_get_size (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+  /* some result checking seems to make some compilers happy */
+  if (G_UNLIKELY (!ok)) {
+    GST_ERROR_OBJECT (h264parse, "failed to build SPS/PPS");
+    g_free (data);
+    return NULL;
+  }
+  if (size == 0) {
+    g_free (data);
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (h264parse, "built %u bytes of SPS/PPS", size);
+  h264parse->config_nals = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      data, size, 0, size, data, g_free);
+  h264parse->config_nals_format = h264parse->format;
+  h264parse->config_nals_nl = h264parse->nal_length_size;
+
+  return h264parse->config_nals;
+}
+
 static gboolean
 gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
     GstBuffer * buffer, GstBaseParseFrame * frame)
@@ -2295,59 +2420,26 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
+    /* insert config NALs into AU, sharing the prefixed parameter sets */
+    GstMemory *config_nals = gst_h264_parse_get_config_nals (h264parse);
     GstBuffer *new_buf;
-    const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h264parse->nal_length_size;
-    gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
-    GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
-    for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
-      if ((codec_nal = h264parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h264parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
-      if ((codec_nal = h264parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h264parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
-    /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
-    gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
-    /* should already be keyframe/IDR, but it may not have been,
-     * so mark it as such to avoid being discarded by picky decoder */
-    GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
-    gst_buffer_replace (&frame->out_buffer, new_buf);
-    gst_buffer_unref (new_buf);
-    /* some result checking seems to make some compilers happy */
-    if (G_UNLIKELY (!ok)) {
-      GST_ERROR_OBJECT (h264parse, "failed to insert SPS/PPS");
+    if (config_nals) {
+      GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
+      new_buf = gst_buffer_new ();
+      if (h264parse->idr_pos > 0)
+        gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+            h264parse->idr_pos);
+      gst_buffer_append_memory (new_buf, gst_memory_ref (config_nals));
+      gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+          h264parse->idr_pos, -1);
+      gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+      /* should already be keyframe/IDR, but it may not have been,
+       * so mark it as such to avoid being discarded by picky decoder */
+      GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
+      gst_buffer_replace (&frame->out_buffer, new_buf);
+      gst_buffer_unref (new_buf);
+      send_done = TRUE;
     }
   }
 
@@ -2641,7 +2733,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, &nalu, codec_data);
       off = nalu.offset + nalu.size;
     }
 
@@ -2660,7 +2752,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, &nalu, codec_data);
       off = nalu.offset + nalu.size;
     }
 
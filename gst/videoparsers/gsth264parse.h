@@ -90,6 +90,11 @@ struct _GstH264Parse
   /* collected SPS and PPS NALUs */
   GstBuffer *sps_nals[GST_H264_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H264_MAX_PPS_COUNT];
+  /* all of the above, prefixed for the output format, ready for
+   * insertion into access units */
+  GstMemory *config_nals;
+  guint config_nals_format;
+  guint config_nals_nl;
 
   /* Infos we need to keep track of */
   guint32 sei_cpb_removal_delay;
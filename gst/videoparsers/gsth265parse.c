@@ -33,11 +33,13 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_SCAN_THREADS         (1)
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_SCAN_THREADS
 };
 
 enum
@@ -113,6 +115,27 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "will be multiplexed in the data stream when detected.) (0 = disabled)",
           0, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH265Parse:scan-threads:
+   *
+   * Number of threads used to locate NAL boundaries in byte-stream input.
+   * When not 1, start codes are collected in a table that grows with the
+   * incoming data instead of rescanning the pending access unit on every
+   * new buffer, and large chunks of data are scanned in parallel. This
+   * mostly helps high bitrate intra-only streams with very large slices.
+   * NAL units are still parsed and output in order.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_SCAN_THREADS,
+      g_param_spec_uint ("scan-threads", "Scan threads",
+          "Number of threads used to find NAL boundaries "
+          "(0 = number of processors, 1 = no table, scan on streaming thread)",
+          0, G_MAXUINT, DEFAULT_SCAN_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -137,6 +160,7 @@ static void
 gst_h265_parse_init (GstH265Parse * h265parse)
 {
   h265parse->frame_out = gst_adapter_new ();
+  h265parse->scan_threads = DEFAULT_SCAN_THREADS;
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h265parse));
@@ -168,6 +192,17 @@ gst_h265_parse_reset_frame (GstH265Parse * h265parse)
   h265parse->keyframe = FALSE;
   h265parse->header = FALSE;
   gst_adapter_clear (h265parse->frame_out);
+  if (h265parse->use_scan)
+    gst_nal_scan_reset (&h265parse->scan);
+}
+
+static void
+gst_h265_parse_clear_config_nals (GstH265Parse * h265parse)
+{
+  if (h265parse->config_nals) {
+    gst_memory_unref (h265parse->config_nals);
+    h265parse->config_nals = NULL;
+  }
 }
 
 static void
@@ -214,6 +249,16 @@ gst_h265_parse_start (GstBaseParse * parse)
 
   h265parse->nalparser = gst_h265_parser_new ();
 
+  if (h265parse->scan_threads != 1) {
+    guint n_threads = h265parse->scan_threads;
+
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+    GST_DEBUG_OBJECT (parse, "scanning with %u threads", n_threads);
+    gst_nal_scan_init (&h265parse->scan, n_threads);
+    h265parse->use_scan = TRUE;
+  }
+
   gst_base_parse_set_min_frame_size (parse, 7);
 
   return TRUE;
@@ -234,9 +279,15 @@ gst_h265_parse_stop (GstBaseParse * parse)
     gst_buffer_replace (&h265parse->sps_nals[i], NULL);
   for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
     gst_buffer_replace (&h265parse->pps_nals[i], NULL);
+  gst_h265_parse_clear_config_nals (h265parse);
 
   gst_h265_parser_free (h265parse->nalparser);
 
+  if (h265parse->use_scan) {
+    gst_nal_scan_clear (&h265parse->scan);
+    h265parse->use_scan = FALSE;
+  }
+
   return TRUE;
 }
 
@@ -391,6 +442,38 @@ gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Like gst_h265_parse_wrap_nal(), but for a NAL that lives in @buffer at
+ * @offset. The NAL payload is shared with @buffer rather than copied, and
+ * only the start code or length prefix gets a memory of its own */
+static GstBuffer *
+gst_h265_parse_wrap_nal_region (GstH265Parse * h265parse, guint format,
+    GstBuffer * buffer, guint offset, guint size)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+  GstBuffer *buf;
+  guint nl = h265parse->nal_length_size;
+  guint32 tmp;
+
+  GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
+
+  buf = gst_buffer_new ();
+  if (format == GST_H265_PARSE_FORMAT_HVC1
+      || format == GST_H265_PARSE_FORMAT_HEV1) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    gst_buffer_append_memory (buf, gst_allocator_alloc (NULL, nl, NULL));
+    gst_buffer_fill (buf, 0, &tmp, nl);
+  } else {
+    gst_buffer_append_memory (buf,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+            (gpointer) start_code, sizeof (start_code), 0,
+            sizeof (start_code), NULL, NULL));
+  }
+
+  gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return buf;
+}
+
 static void
 gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     GstH265NalUnitType naltype, GstH265NalUnit * nalu)
@@ -418,6 +501,15 @@ gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     return;
   }
 
+  /* parameter sets are usually repeated verbatim, keep what we have then */
+  if (store[id] && gst_buffer_get_size (store[id]) == size &&
+      gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset, size) == 0) {
+    GST_LOG_OBJECT (h265parse, "nal unchanged");
+    return;
+  }
+
+  gst_h265_parse_clear_config_nals (h265parse);
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -485,9 +577,11 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
-/* caller guarantees 2 bytes of nal payload */
+/* caller guarantees 2 bytes of nal payload; @buffer is the buffer
+ * nalu->data was mapped from */
 static void
-gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
+gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu,
+    GstBuffer * buffer)
 {
   GstH265PPS pps = { 0, };
   GstH265SPS sps = { 0, };
@@ -614,7 +708,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     {
       GstH265SliceHdr slice;
 
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+      pres =
+          gst_h265_parser_parse_slice_hdr_light (nalparser, nalu, &slice);
 
       if (pres == GST_H265_PARSER_OK) {
         if (GST_H265_IS_I_SLICE (&slice))
@@ -627,8 +722,6 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       GST_DEBUG_OBJECT (h265parse,
           "parse result %d, first slice_segment: %u, slice type: %u",
           pres, slice.first_slice_segment_in_pic_flag, slice.type);
-
-      gst_h265_slice_hdr_free (&slice);
     }
 
       is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
@@ -666,8 +759,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    buf = gst_h265_parse_wrap_nal_region (h265parse, h265parse->format, buffer,
+        nalu->offset, nalu->size);
     gst_adapter_push (h265parse->frame_out, buf);
   }
 }
@@ -758,7 +851,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h265_parse_process_nal (h265parse, &nalu);
+    gst_h265_parse_process_nal (h265parse, &nalu, buffer);
 
     /* dispatch per NALU if needed */
     if (h265parse->split_packetized) {
@@ -817,6 +910,41 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
   return ret;
 }
 
+/* same as gst_h265_parser_identify_nalu(), but looks up the end of the NAL
+ * in the start code table if there is one */
+static GstH265ParserResult
+gst_h265_parse_identify_nalu (GstH265Parse * h265parse, const guint8 * data,
+    guint offset, gsize size, GstH265NalUnit * nalu)
+{
+  GstH265ParserResult res;
+  gint off2;
+
+  if (!h265parse->use_scan)
+    return gst_h265_parser_identify_nalu (h265parse->nalparser, data, offset,
+        size, nalu);
+
+  gst_nal_scan_update (&h265parse->scan, data, size);
+
+  res = gst_h265_parser_identify_nalu_unchecked (h265parse->nalparser, data,
+      offset, size, nalu);
+  if (res != GST_H265_PARSER_OK || nalu->size == 2)
+    return res;
+
+  off2 = gst_nal_scan_next (&h265parse->scan, nalu->offset);
+  if (off2 < 0)
+    return GST_H265_PARSER_NO_NAL_END;
+
+  /* mind the trailing zeros, as the parser does */
+  while ((guint) off2 > nalu->offset && data[off2 - 1] == 0)
+    off2--;
+
+  nalu->size = off2 - nalu->offset;
+  if (nalu->size < 3)
+    return GST_H265_PARSER_BROKEN_DATA;
+
+  return GST_H265_PARSER_OK;
+}
+
 static GstFlowReturn
 gst_h265_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize)
@@ -894,7 +1022,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
 
   while (TRUE) {
     pres =
-        gst_h265_parser_identify_nalu (nalparser, data, current_off, size,
+        gst_h265_parse_identify_nalu (h265parse, data, current_off, size,
         &nalu);
 
     switch (pres) {
@@ -976,7 +1104,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
         nalu.type == GST_H265_NAL_SPS ||
         nalu.type == GST_H265_NAL_PPS ||
         (h265parse->have_sps && h265parse->have_pps)) {
-      gst_h265_parse_process_nal (h265parse, &nalu);
+      gst_h265_parse_process_nal (h265parse, &nalu, buffer);
     } else {
       GST_WARNING_OBJECT (h265parse,
           "no SPS/PPS yet, nal Type: %d %s, Size: %u will be dropped",
@@ -1654,7 +1782,7 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -1783,6 +1911,82 @@ gst_h265_parse_prepare_key_unit (GstH265Parse * parse, GstEvent * event)
   parse->push_codec = TRUE;
 }
 
+static gboolean
+gst_h265_parse_put_config_nal (GstH265Parse * h265parse, GstByteWriter * bw,
+    GstBuffer * codec_nal)
+{
+  gsize nal_size = gst_buffer_get_size (codec_nal);
+  const gint nls = 4 - h265parse->nal_length_size;
+  gboolean ok;
+
+  if (h265parse->format == GST_H265_PARSE_FORMAT_BYTE) {
+    ok = gst_byte_writer_put_uint32_be (bw, 1);
+  } else {
+    ok = gst_byte_writer_put_uint32_be (bw, (nal_size << (nls * 8)));
+    ok &= gst_byte_writer_set_pos (bw, gst_byte_writer_get_pos (bw) - nls);
+  }
+  ok &= gst_byte_writer_put_buffer (bw, codec_nal, 0, nal_size);
+
+  return ok;
+}
+
+/* Returns the stored VPS/SPS/PPS, each with a start code or length prefix,
+ * as a single read-only memory, or NULL if there are none. It is only
+ * rebuilt when a parameter set or the output format changes, so every
+ * inserted access unit can share it. */
+static GstMemory *
+gst_h265_parse_get_config_nals (GstH265Parse * h265parse)
+{
+  GstByteWriter bw;
+  GstBuffer *codec_nal;
+  gboolean ok = TRUE;
+  guint8 *data;
+  guint size;
+  gint i;
+
+  if (h265parse->config_nals &&
+      h265parse->config_nals_format == h265parse->format &&
+      h265parse->config_nals_nl == h265parse->nal_length_size)
+    return h265parse->config_nals;
+
+  gst_h265_parse_clear_config_nals (h265parse);
+
+  gst_byte_writer_init (&bw);
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
+    if ((codec_nal = h265parse->vps_nals[i]))
+      ok &= gst_h265_parse_put_config_nal (h265parse, &bw, codec_nal);
+  }
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
+    if ((codec_nal = h265parse->sps_nals[i]))
+      ok &= gst_h265_parse_put_config_nal (h265parse, &bw, codec_nal);
+  }
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
+    if ((codec_nal = h265parse->pps_nals[i]))
+      ok &= gst_h265_parse_put_config_nal (h265parse, &bw, codec_nal);
+  }
+
+  size = gst_byte_writer_get_size (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+  /* some result checking seems to make some compilers happy */
+  if (G_UNLIKELY (!ok)) {
+    GST_ERROR_OBJECT (h265parse, "failed to build VPS/SPS/PPS");
+    g_free (data);
+    return NULL;
+  }
+  if (size == 0) {
+    g_free (data);
+    return NULL;
+  }
+
+  GST_DEBUG_OBJECT (h265parse, "built %u bytes of VPS/SPS/PPS", size);
+  h265parse->config_nals = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      data, size, 0, size, data, g_free);
+  h265parse->config_nals_format = h265parse->format;
+  h265parse->config_nals_nl = h265parse->nal_length_size;
+
+  return h265parse->config_nals;
+}
+
 static GstFlowReturn
 gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -1892,81 +2096,28 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
             }
           }
         } else {
-          /* insert config NALs into AU */
-          GstByteWriter bw;
+          /* insert config NALs into AU, sharing the prefixed parameter
+           * sets */
+          GstMemory *config_nals = gst_h265_parse_get_config_nals (h265parse);
           GstBuffer *new_buf;
-          const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
-          const gint nls = 4 - h265parse->nal_length_size;
-          gboolean ok;
-
-          gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer),
-              FALSE);
-          ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
-          GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
-          for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
-            if ((codec_nal = h265parse->vps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting VPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
-            }
-          }
-          for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
-            if ((codec_nal = h265parse->sps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting SPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
-            }
-          }
-          for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
-            if ((codec_nal = h265parse->pps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
-              GST_DEBUG_OBJECT (h265parse, "inserting PPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-              h265parse->last_report = new_ts;
-            }
-          }
-          ok &=
-              gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
-          /* collect result and push */
-          new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
-          gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0,
-              -1);
-          /* should already be keyframe/IDR, but it may not have been,
-           * so mark it as such to avoid being discarded by picky decoder */
-          GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
-          gst_buffer_replace (&frame->out_buffer, new_buf);
-          gst_buffer_unref (new_buf);
-          /* some result checking seems to make some compilers happy */
-          if (G_UNLIKELY (!ok)) {
-            GST_ERROR_OBJECT (h265parse, "failed to insert SPS/PPS");
+
+          if (config_nals) {
+            GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
+            new_buf = gst_buffer_new ();
+            if (h265parse->idr_pos > 0)
+              gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+                  h265parse->idr_pos);
+            gst_buffer_append_memory (new_buf, gst_memory_ref (config_nals));
+            gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+                h265parse->idr_pos, -1);
+            gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0,
+                -1);
+            /* should already be keyframe/IDR, but it may not have been,
+             * so mark it as such to avoid being discarded by picky decoder */
+            GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
+            gst_buffer_replace (&frame->out_buffer, new_buf);
+            gst_buffer_unref (new_buf);
+            h265parse->last_report = new_ts;
           }
         }
       }
@@ -2068,7 +2219,7 @@ gst_h265_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
           goto hvcc_too_small;
         }
 
-        gst_h265_parse_process_nal (h265parse, &nalu);
+        gst_h265_parse_process_nal (h265parse, &nalu, codec_data);
         off = nalu.offset + nalu.size;
       }
     }
@@ -2301,6 +2452,9 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_uint (value);
       break;
+    case PROP_SCAN_THREADS:
+      parse->scan_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2318,6 +2472,9 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, parse->interval);
       break;
+    case PROP_SCAN_THREADS:
+      g_value_set_uint (value, parse->scan_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
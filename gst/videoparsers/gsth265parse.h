@@ -25,6 +25,8 @@
 #include <gst/base/gstbaseparse.h>
 #include <gst/codecparsers/gsth265parser.h>
 
+#include "nalscan.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_H265_PARSE \
@@ -66,6 +68,9 @@ struct _GstH265Parse
   guint align;
   guint format;
   gint current_off;
+  /* start codes of the current frame, if scan-threads != 1 */
+  gboolean use_scan;
+  NalScan scan;
 
   GstClockTime last_report;
   gboolean push_codec;
@@ -77,6 +82,11 @@ struct _GstH265Parse
   GstBuffer *vps_nals[GST_H265_MAX_VPS_COUNT];
   GstBuffer *sps_nals[GST_H265_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H265_MAX_PPS_COUNT];
+  /* all of the above, prefixed for the output format, ready for
+   * insertion into access units */
+  GstMemory *config_nals;
+  guint config_nals_format;
+  guint config_nals_nl;
 
   /* frame parsing */
   gint idr_pos, sei_pos;
@@ -89,6 +99,7 @@ struct _GstH265Parse
 
   /* props */
   guint interval;
+  guint scan_threads;
 
   gboolean sent_codec_tag;
 
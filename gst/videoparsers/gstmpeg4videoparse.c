@@ -61,12 +61,16 @@ static GstStaticPadTemplate sink_template =
 /* Properties */
 #define DEFAULT_PROP_DROP TRUE
 #define DEFAULT_CONFIG_INTERVAL (0)
+#define DEFAULT_PROP_GOP_INDEX FALSE
+#define DEFAULT_PROP_KEY_UNITS_ONLY FALSE
 
 enum
 {
   PROP_0,
   PROP_DROP,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_GOP_INDEX,
+  PROP_KEY_UNITS_ONLY
 };
 
 #define gst_mpeg4vparse_parent_class parent_class
@@ -105,6 +109,12 @@ gst_mpeg4vparse_set_property (GObject * object, guint property_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_uint (value);
       break;
+    case PROP_GOP_INDEX:
+      parse->send_gop_index = g_value_get_boolean (value);
+      break;
+    case PROP_KEY_UNITS_ONLY:
+      parse->key_units_only = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -123,6 +133,12 @@ gst_mpeg4vparse_get_property (GObject * object, guint property_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, parse->interval);
       break;
+    case PROP_GOP_INDEX:
+      g_value_set_boolean (value, parse->send_gop_index);
+      break;
+    case PROP_KEY_UNITS_ONLY:
+      g_value_set_boolean (value, parse->key_units_only);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -154,6 +170,33 @@ gst_mpeg4vparse_class_init (GstMpeg4VParseClass * klass)
           0, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpeg4VParse:gop-index:
+   *
+   * Post a "gop-index" element message for every group of VOPs, listing
+   * the byte offset and coding type of each of its VOPs.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_INDEX,
+      g_param_spec_boolean ("gop-index", "GOP index",
+          "Post an element message with the VOP offsets and types of "
+          "each group of VOPs", DEFAULT_PROP_GOP_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMpeg4VParse:key-units-only:
+   *
+   * Only output I-VOPs. This is also done when the segment has the
+   * %GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS flag.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_UNITS_ONLY,
+      g_param_spec_boolean ("key-units-only", "Key units only",
+          "Drop all but the I-VOPs", DEFAULT_PROP_KEY_UNITS_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &sink_template);
 
@@ -194,6 +237,7 @@ gst_mpeg4vparse_reset_frame (GstMpeg4VParse * mp4vparse)
   /* done parsing; reset state */
   mp4vparse->last_sc = -1;
   mp4vparse->vop_offset = -1;
+  mp4vparse->gov_offset = -1;
   mp4vparse->vo_found = FALSE;
   mp4vparse->config_found = FALSE;
   mp4vparse->vol_offset = -1;
@@ -210,6 +254,7 @@ gst_mpeg4vparse_reset (GstMpeg4VParse * mp4vparse)
   mp4vparse->pending_key_unit_ts = GST_CLOCK_TIME_NONE;
   mp4vparse->force_key_unit_event = NULL;
   mp4vparse->discont = FALSE;
+  mp4vparse->seen_gov = FALSE;
 
   gst_buffer_replace (&mp4vparse->config, NULL);
   memset (&mp4vparse->vol, 0, sizeof (mp4vparse->vol));
@@ -223,6 +268,7 @@ gst_mpeg4vparse_start (GstBaseParse * parse)
   GST_DEBUG_OBJECT (parse, "start");
 
   gst_mpeg4vparse_reset (mp4vparse);
+  gst_gop_index_init (&mp4vparse->gop_index);
   /* at least this much for a valid frame */
   gst_base_parse_set_min_frame_size (parse, 6);
 
@@ -237,6 +283,7 @@ gst_mpeg4vparse_stop (GstBaseParse * parse)
   GST_DEBUG_OBJECT (parse, "stop");
 
   gst_mpeg4vparse_reset (mp4vparse);
+  gst_gop_index_clear (&mp4vparse->gop_index);
 
   return TRUE;
 }
@@ -340,6 +387,7 @@ gst_mpeg4vparse_process_sc (GstMpeg4VParse * mp4vparse, GstMpeg4Packet * packet,
         mp4vparse->vop_offset = packet->offset;
       } else if (packet->type == GST_MPEG4_GROUP_OF_VOP) {
         GST_LOG_OBJECT (mp4vparse, "startcode is GOP");
+        mp4vparse->gov_offset = packet->offset;
       } else {
         GST_LOG_OBJECT (mp4vparse, "startcode is User Data");
       }
@@ -527,7 +575,13 @@ out:
       GST_BUFFER_FLAG_SET (frame->buffer, GST_BUFFER_FLAG_DISCONT);
       mp4vparse->discont = FALSE;
     }
-    return gst_base_parse_finish_frame (parse, frame, framesize);
+    res = gst_base_parse_finish_frame (parse, frame, framesize);
+    /* the rest of the data was drained, so the final group of VOPs is
+     * complete. Post it here, as EOS is forwarded as soon as draining is
+     * done */
+    if (GST_BASE_PARSE_DRAINING (parse) && framesize == size)
+      gst_gop_index_finish (&mp4vparse->gop_index, GST_ELEMENT_CAST (parse));
+    return res;
   }
 
   return GST_FLOW_OK;
@@ -621,6 +675,8 @@ gst_mpeg4vparse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   GstBuffer *buffer = frame->buffer;
   GstMapInfo map;
   gboolean intra = FALSE;
+  guint8 vop_type = GST_MPEG4_I_VOP;
+  GstMpeg4GroupOfVOP gov = { 0, };
 
   gst_mpeg4vparse_update_src_caps (mp4vparse);
 
@@ -629,11 +685,19 @@ gst_mpeg4vparse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
    * determine intra frame */
   gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
   if (G_LIKELY (map.size > mp4vparse->vop_offset + 1)) {
-    intra = ((map.data[mp4vparse->vop_offset + 1] >> 6 & 0x3) == 0);
+    vop_type = map.data[mp4vparse->vop_offset + 1] >> 6 & 0x3;
+    intra = (vop_type == GST_MPEG4_I_VOP);
     GST_DEBUG_OBJECT (mp4vparse, "frame intra = %d", intra);
   } else {
     GST_WARNING_OBJECT (mp4vparse, "no data following VOP startcode");
   }
+  if (mp4vparse->send_gop_index && mp4vparse->gov_offset >= 0) {
+    if (gst_mpeg4_parse_group_of_vop (&gov,
+            map.data + mp4vparse->gov_offset,
+            map.size - mp4vparse->gov_offset) != GST_MPEG4_PARSER_OK)
+      GST_LOG_OBJECT (mp4vparse, "couldn't parse GOV at offset %d",
+          mp4vparse->gov_offset);
+  }
   gst_buffer_unmap (frame->buffer, &map);
 
   if (intra)
@@ -641,9 +705,32 @@ gst_mpeg4vparse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   else
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
 
+  if (mp4vparse->send_gop_index) {
+    if (mp4vparse->gov_offset >= 0) {
+      mp4vparse->seen_gov = TRUE;
+      gst_gop_index_start (&mp4vparse->gop_index,
+          GST_ELEMENT_CAST (mp4vparse),
+          frame->offset + mp4vparse->gov_offset - 3,
+          GST_BUFFER_PTS (buffer), gov.closed);
+    } else if (!mp4vparse->seen_gov && intra) {
+      /* GOV headers are optional, start one at every I-VOP without */
+      gst_gop_index_start (&mp4vparse->gop_index,
+          GST_ELEMENT_CAST (mp4vparse), frame->offset,
+          GST_BUFFER_PTS (buffer), FALSE);
+    }
+    if (mp4vparse->vop_offset >= 0)
+      gst_gop_index_add_picture (&mp4vparse->gop_index,
+          frame->offset + mp4vparse->vop_offset - 3, "IPBS"[vop_type]);
+  }
+
   if (G_UNLIKELY (mp4vparse->drop && !mp4vparse->config)) {
     GST_LOG_OBJECT (mp4vparse, "dropping frame as no config yet");
     return GST_BASE_PARSE_FLOW_DROPPED;
+  } else if ((mp4vparse->key_units_only ||
+          (parse->segment.flags & GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS)) &&
+      mp4vparse->vop_offset >= 0 && !intra) {
+    GST_LOG_OBJECT (mp4vparse, "dropping non-I VOP");
+    return GST_BASE_PARSE_FLOW_DROPPED;
   } else
     return GST_FLOW_OK;
 }
@@ -961,6 +1048,10 @@ gst_mpeg4vparse_event (GstBaseParse * parse, GstEvent * event)
       }
       break;
     }
+    case GST_EVENT_FLUSH_STOP:
+      gst_gop_index_reset (&mp4vparse->gop_index);
+      res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
+      break;
     default:
       res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
       break;
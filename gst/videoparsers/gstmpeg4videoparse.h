@@ -25,6 +25,8 @@
 
 #include <gst/codecparsers/gstmpeg4parser.h>
 
+#include "gopindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEG4VIDEO_PARSE            (gst_mpeg4vparse_get_type())
@@ -50,6 +52,7 @@ struct _GstMpeg4VParse {
   /* parse state */
   gint last_sc;
   gint vop_offset;
+  gint gov_offset;
   gboolean vo_found;
   gboolean config_found;
   gboolean update_caps;
@@ -66,9 +69,15 @@ struct _GstMpeg4VParse {
   const gchar *profile;
   const gchar *level;
 
+  /* GOP index */
+  GopIndex gop_index;
+  gboolean seen_gov;
+
   /* properties */
   gboolean drop;
   guint interval;
+  gboolean send_gop_index;
+  gboolean key_units_only;
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
 };
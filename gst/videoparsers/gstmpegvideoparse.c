@@ -54,12 +54,16 @@ GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
 /* Properties */
 #define DEFAULT_PROP_DROP       TRUE
 #define DEFAULT_PROP_GOP_SPLIT  FALSE
+#define DEFAULT_PROP_GOP_INDEX  FALSE
+#define DEFAULT_PROP_KEY_UNITS_ONLY FALSE
 
 enum
 {
   PROP_0,
   PROP_DROP,
-  PROP_GOP_SPLIT
+  PROP_GOP_SPLIT,
+  PROP_GOP_INDEX,
+  PROP_KEY_UNITS_ONLY
 };
 
 #define parent_class gst_mpegv_parse_parent_class
@@ -78,6 +82,8 @@ static GstFlowReturn gst_mpegv_parse_pre_push_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame);
 static gboolean gst_mpegv_parse_sink_query (GstBaseParse * parse,
     GstQuery * query);
+static gboolean gst_mpegv_parse_sink_event (GstBaseParse * parse,
+    GstEvent * event);
 
 static void gst_mpegv_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -97,6 +103,12 @@ gst_mpegv_parse_set_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       parse->gop_split = g_value_get_boolean (value);
       break;
+    case PROP_GOP_INDEX:
+      parse->send_gop_index = g_value_get_boolean (value);
+      break;
+    case PROP_KEY_UNITS_ONLY:
+      parse->key_units_only = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -115,6 +127,12 @@ gst_mpegv_parse_get_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       g_value_set_boolean (value, parse->gop_split);
       break;
+    case PROP_GOP_INDEX:
+      g_value_set_boolean (value, parse->send_gop_index);
+      break;
+    case PROP_KEY_UNITS_ONLY:
+      g_value_set_boolean (value, parse->key_units_only);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -146,6 +164,33 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
           "Split frame when encountering GOP", DEFAULT_PROP_GOP_SPLIT,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegvParse:gop-index:
+   *
+   * Post a "gop-index" element message for every GOP, listing the byte
+   * offset and coding type of each of its pictures.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_INDEX,
+      g_param_spec_boolean ("gop-index", "GOP index",
+          "Post an element message with the picture offsets and types of "
+          "each GOP", DEFAULT_PROP_GOP_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMpegvParse:key-units-only:
+   *
+   * Only output I pictures. This is also done when the segment has the
+   * %GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS flag.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_UNITS_ONLY,
+      g_param_spec_boolean ("key-units-only", "Key units only",
+          "Drop all but the I pictures", DEFAULT_PROP_KEY_UNITS_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &sink_template);
 
@@ -166,6 +211,7 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
   parse_class->pre_push_frame =
       GST_DEBUG_FUNCPTR (gst_mpegv_parse_pre_push_frame);
   parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_query);
+  parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_event);
 }
 
 static void
@@ -191,6 +237,7 @@ gst_mpegv_parse_reset_frame (GstMpegvParse * mpvparse)
   mpvparse->ext_count = 0;
   mpvparse->slice_count = 0;
   mpvparse->slice_offset = 0;
+  mpvparse->gop_offset = -1;
 }
 
 static void
@@ -201,6 +248,7 @@ gst_mpegv_parse_reset (GstMpegvParse * mpvparse)
   mpvparse->update_caps = TRUE;
   mpvparse->send_codec_tag = TRUE;
   mpvparse->send_mpeg_meta = TRUE;
+  mpvparse->seen_gop = FALSE;
 
   gst_buffer_replace (&mpvparse->config, NULL);
   memset (&mpvparse->sequencehdr, 0, sizeof (mpvparse->sequencehdr));
@@ -236,6 +284,26 @@ gst_mpegv_parse_sink_query (GstBaseParse * parse, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_mpegv_parse_sink_event (GstBaseParse * parse, GstEvent * event)
+{
+  GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+  GstEventType type = GST_EVENT_TYPE (event);
+  gboolean res;
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->sink_event (parse, event);
+
+  switch (type) {
+    case GST_EVENT_FLUSH_STOP:
+      gst_gop_index_reset (&mpvparse->gop_index);
+      break;
+    default:
+      break;
+  }
+
+  return res;
+}
+
 static gboolean
 gst_mpegv_parse_start (GstBaseParse * parse)
 {
@@ -244,6 +312,7 @@ gst_mpegv_parse_start (GstBaseParse * parse)
   GST_DEBUG_OBJECT (parse, "start");
 
   gst_mpegv_parse_reset (mpvparse);
+  gst_gop_index_init (&mpvparse->gop_index);
   /* at least this much for a valid frame */
   gst_base_parse_set_min_frame_size (parse, 6);
 
@@ -258,6 +327,7 @@ gst_mpegv_parse_stop (GstBaseParse * parse)
   GST_DEBUG_OBJECT (parse, "stop");
 
   gst_mpegv_parse_reset (mpvparse);
+  gst_gop_index_clear (&mpvparse->gop_index);
 
   return TRUE;
 }
@@ -461,6 +531,25 @@ parse_packet_extension (GstMpegvParse * mpvparse, GstMapInfo * info, guint off)
   }
 }
 
+static void
+gst_mpegv_parse_picture_header (GstMpegvParse * mpvparse, GstMapInfo * info,
+    gint frame_size)
+{
+  GstMpegVideoPacket header;
+
+  header.data = info->data;
+  header.type = GST_MPEG_VIDEO_PACKET_PICTURE;
+  header.offset = mpvparse->pic_offset;
+  header.size = info->size - mpvparse->pic_offset;
+  if (gst_mpeg_video_packet_parse_picture_header (&header, &mpvparse->pichdr))
+    GST_LOG_OBJECT (mpvparse, "picture_coding_type %d (%s), ending"
+        "frame of size %d", mpvparse->pichdr.pic_type,
+        picture_type_name (mpvparse->pichdr.pic_type), frame_size);
+  else
+    GST_LOG_OBJECT (mpvparse, "Couldn't parse picture at offset %d",
+        mpvparse->pic_offset);
+}
+
 /* caller guarantees at least start code in @buf at @off ( - 4)*/
 /* for off == 4 initial code; returns TRUE if code starts a frame
  * otherwise returns TRUE if code terminates preceding frame */
@@ -501,6 +590,9 @@ gst_mpegv_parse_process_sc (GstMpegvParse * mpvparse,
         ret = mpvparse->gop_split;
       else
         ret = TRUE;
+      /* unless it ends the frame, the GOP header belongs to it */
+      if (!ret || off == 4)
+        mpvparse->gop_offset = off;
       break;
     case GST_MPEG_VIDEO_PACKET_EXTENSION:
       mpvparse->config_flags |= FLAG_MPEG2;
@@ -536,19 +628,7 @@ gst_mpegv_parse_process_sc (GstMpegvParse * mpvparse,
 
   /* extract some picture info if there is any in the frame being terminated */
   if (ret && mpvparse->pic_offset >= 0 && mpvparse->pic_offset < off) {
-    GstMpegVideoPacket header;
-
-    header.data = info->data;
-    header.type = GST_MPEG_VIDEO_PACKET_PICTURE;
-    header.offset = mpvparse->pic_offset;
-    header.size = info->size - mpvparse->pic_offset;
-    if (gst_mpeg_video_packet_parse_picture_header (&header, &mpvparse->pichdr))
-      GST_LOG_OBJECT (mpvparse, "picture_coding_type %d (%s), ending"
-          "frame of size %d", mpvparse->pichdr.pic_type,
-          picture_type_name (mpvparse->pichdr.pic_type), off - 4);
-    else
-      GST_LOG_OBJECT (mpvparse, "Couldn't parse picture at offset %d",
-          mpvparse->pic_offset);
+    gst_mpegv_parse_picture_header (mpvparse, info, off - 4);
 
     /* if terminating packet is a picture, we need to check if it has same TSN as the picture that is being
        terminated. If it does, we need to keep those together, as these packets are two fields of the same
@@ -700,6 +780,10 @@ exit:
     if (res == GST_BASE_PARSE_FLOW_DROPPED)
       frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
     flowret = gst_base_parse_finish_frame (parse, frame, off);
+    /* the rest of the data was drained, so the final GOP is complete. Post
+     * it here, as EOS is forwarded as soon as draining is done */
+    if (GST_BASE_PARSE_DRAINING (parse) && off == size)
+      gst_gop_index_finish (&mpvparse->gop_index, GST_ELEMENT_CAST (parse));
     /* Reset local information */
     mpvparse->seqhdr_updated = FALSE;
     mpvparse->seqext_updated = FALSE;
@@ -716,6 +800,9 @@ need_more:
     GST_LOG_OBJECT (mpvparse, "draining, accepting all data");
     off = size;
     ret = TRUE;
+    /* no start code terminates the last picture, parse it here */
+    if (mpvparse->pic_offset >= 0)
+      gst_mpegv_parse_picture_header (mpvparse, &map, off);
   } else {
     GST_LOG_OBJECT (mpvparse, "need more data");
     /* resume scan where we left it */
@@ -888,6 +975,47 @@ gst_mpegv_parse_update_src_caps (GstMpegvParse * mpvparse)
   mpvparse->update_caps = FALSE;
 }
 
+static void
+gst_mpegv_parse_update_gop_index (GstMpegvParse * mpvparse,
+    GstBaseParseFrame * frame)
+{
+  static const gchar pic_type_names[] = "?IPBD";
+  GstMpegVideoPictureType pic_type = mpvparse->pichdr.pic_type;
+
+  if (mpvparse->gop_offset >= 0) {
+    GstMpegVideoPacket header;
+    GstMpegVideoGop gop = { 0, };
+    GstMapInfo map;
+
+    gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
+    header.data = map.data;
+    header.type = GST_MPEG_VIDEO_PACKET_GOP;
+    header.offset = mpvparse->gop_offset;
+    header.size = map.size - mpvparse->gop_offset;
+    if (!gst_mpeg_video_packet_parse_gop (&header, &gop))
+      GST_LOG_OBJECT (mpvparse, "Couldn't parse GOP at offset %d",
+          mpvparse->gop_offset);
+    gst_buffer_unmap (frame->buffer, &map);
+
+    mpvparse->seen_gop = TRUE;
+    gst_gop_index_start (&mpvparse->gop_index, GST_ELEMENT_CAST (mpvparse),
+        frame->offset + mpvparse->gop_offset - 4,
+        GST_BUFFER_PTS (frame->buffer), gop.closed_gop);
+  } else if (!mpvparse->seen_gop && mpvparse->pic_offset >= 0 &&
+      pic_type == GST_MPEG_VIDEO_PICTURE_TYPE_I) {
+    /* GOP headers are optional, start one at every I picture without */
+    gst_gop_index_start (&mpvparse->gop_index, GST_ELEMENT_CAST (mpvparse),
+        frame->offset, GST_BUFFER_PTS (frame->buffer), FALSE);
+  }
+
+  if (mpvparse->pic_offset >= 0) {
+    gst_gop_index_add_picture (&mpvparse->gop_index,
+        frame->offset + mpvparse->pic_offset - 4,
+        pic_type < G_N_ELEMENTS (pic_type_names) - 1 ?
+        pic_type_names[pic_type] : '?');
+  }
+}
+
 static GstFlowReturn
 gst_mpegv_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -917,11 +1045,22 @@ gst_mpegv_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
         (1 + mpvparse->frame_repeat_count) * GST_BUFFER_DURATION (buffer) / 2;
   }
 
+  if (mpvparse->send_gop_index)
+    gst_mpegv_parse_update_gop_index (mpvparse, frame);
+
   if (G_UNLIKELY (mpvparse->drop && !mpvparse->config)) {
     GST_DEBUG_OBJECT (mpvparse, "dropping frame as no config yet");
     return GST_BASE_PARSE_FLOW_DROPPED;
   }
 
+  if ((mpvparse->key_units_only ||
+          (parse->segment.flags & GST_SEGMENT_FLAG_TRICKMODE_KEY_UNITS)) &&
+      mpvparse->pic_offset >= 0 &&
+      mpvparse->pichdr.pic_type != GST_MPEG_VIDEO_PICTURE_TYPE_I) {
+    GST_LOG_OBJECT (mpvparse, "dropping non-I picture");
+    return GST_BASE_PARSE_FLOW_DROPPED;
+  }
+
   gst_mpegv_parse_update_src_caps (mpvparse);
   return GST_FLOW_OK;
 }
@@ -30,6 +30,8 @@
 
 #include <gst/codecparsers/gstmpegvideoparser.h>
 
+#include "gopindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGVIDEO_PARSE            (gst_mpegv_parse_get_type())
@@ -67,6 +69,7 @@ struct _GstMpegvParse {
   gint pic_offset;
   guint slice_count;
   guint slice_offset;
+  gint gop_offset;
   gboolean update_caps;
   gboolean send_codec_tag;
   gboolean send_mpeg_meta;
@@ -87,9 +90,15 @@ struct _GstMpegvParse {
   gboolean picext_updated;
   gboolean quantmatrext_updated;
 
+  /* GOP index */
+  GopIndex gop_index;
+  gboolean seen_gop;
+
   /* properties */
   gboolean drop;
   gboolean gop_split;
+  gboolean send_gop_index;
+  gboolean key_units_only;
 
   int fps_num;
   int fps_den;
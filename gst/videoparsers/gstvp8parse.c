@@ -0,0 +1,256 @@
+/* GStreamer VP8 Parser
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp8parse
+ * @title: vp8parse
+ *
+ * Parses VP8 frames as produced by container demuxers, marks key frames
+ * and fills in the stream caps (size and profile) without having to decode
+ * anything.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp8parse ! \
+ *     fakesink
+ * ]|
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvp8parse.h"
+
+#include <gst/base/base.h>
+#include <gst/pbutils/pbutils.h>
+
+GST_DEBUG_CATEGORY (vp8_parse_debug);
+#define GST_CAT_DEFAULT vp8_parse_debug
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp8, parsed = (boolean) true")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp8")
+    );
+
+#define parent_class gst_vp8_parse_parent_class
+G_DEFINE_TYPE (GstVp8Parse, gst_vp8_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp8_parse_start (GstBaseParse * parse);
+static gboolean gst_vp8_parse_set_sink_caps (GstBaseParse * parse,
+    GstCaps * caps);
+static GstFlowReturn gst_vp8_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+static GstFlowReturn gst_vp8_parse_pre_push_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame);
+
+static void
+gst_vp8_parse_class_init (GstVp8ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp8_parse_debug, "vp8parse", 0, "vp8 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "VP8 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP8 streams",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  /* Override BaseParse vfuncs */
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp8_parse_start);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_vp8_parse_set_sink_caps);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp8_parse_handle_frame);
+  parse_class->pre_push_frame =
+      GST_DEBUG_FUNCPTR (gst_vp8_parse_pre_push_frame);
+}
+
+static void
+gst_vp8_parse_init (GstVp8Parse * vp8parse)
+{
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (vp8parse));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (vp8parse));
+}
+
+static gboolean
+gst_vp8_parse_start (GstBaseParse * parse)
+{
+  GstVp8Parse *vp8parse = GST_VP8_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp8parse, "start");
+
+  gst_vp8_parser_init (&vp8parse->parser);
+
+  vp8parse->width = 0;
+  vp8parse->height = 0;
+  vp8parse->profile = -1;
+
+  vp8parse->update_caps = TRUE;
+  vp8parse->sent_codec_tag = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp8_parse_set_sink_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstVp8Parse *vp8parse = GST_VP8_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp8parse, "sink caps: %" GST_PTR_FORMAT, caps);
+
+  /* framerate and friends are passed on from upstream */
+  vp8parse->update_caps = TRUE;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_vp8_parse_update_src_caps (GstVp8Parse * vp8parse)
+{
+  GstCaps *caps, *sink_caps;
+  gboolean ret;
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (vp8parse));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp8");
+  }
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE, NULL);
+
+  if (vp8parse->width > 0 && vp8parse->height > 0) {
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, vp8parse->width,
+        "height", G_TYPE_INT, vp8parse->height, NULL);
+  }
+
+  if (vp8parse->profile >= 0) {
+    gchar *profile = g_strdup_printf ("%d", vp8parse->profile);
+
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING, profile, NULL);
+    g_free (profile);
+  }
+
+  GST_DEBUG_OBJECT (vp8parse, "setting caps %" GST_PTR_FORMAT, caps);
+  ret = gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (vp8parse), caps);
+  gst_caps_unref (caps);
+
+  vp8parse->update_caps = FALSE;
+
+  return ret ? GST_FLOW_OK : GST_FLOW_NOT_NEGOTIATED;
+}
+
+static GstFlowReturn
+gst_vp8_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstVp8Parse *vp8parse = GST_VP8_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstVp8FrameHdr frame_hdr;
+  GstVp8ParserResult pres;
+  GstFlowReturn ret;
+  GstMapInfo map;
+  gsize size;
+  gboolean key_frame;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  size = map.size;
+  /* the key frame bit of the frame tag is all that's needed for flagging */
+  key_frame = size > 0 && !(map.data[0] & 0x01);
+  pres = gst_vp8_parser_parse_frame_header (&vp8parse->parser, &frame_hdr,
+      map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+
+  if (pres != GST_VP8_PARSER_OK) {
+    GST_WARNING_OBJECT (vp8parse, "failed to parse frame header");
+  } else if (frame_hdr.key_frame) {
+    if (vp8parse->width != frame_hdr.width ||
+        vp8parse->height != frame_hdr.height ||
+        vp8parse->profile != frame_hdr.version) {
+      GST_INFO_OBJECT (vp8parse, "%ux%u, profile %u", frame_hdr.width,
+          frame_hdr.height, frame_hdr.version);
+
+      vp8parse->width = frame_hdr.width;
+      vp8parse->height = frame_hdr.height;
+      vp8parse->profile = frame_hdr.version;
+      vp8parse->update_caps = TRUE;
+    }
+  }
+
+  if (vp8parse->update_caps) {
+    ret = gst_vp8_parse_update_src_caps (vp8parse);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  if (key_frame)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return gst_base_parse_finish_frame (parse, frame, size);
+}
+
+static GstFlowReturn
+gst_vp8_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
+{
+  GstVp8Parse *vp8parse = GST_VP8_PARSE (parse);
+
+  if (!vp8parse->sent_codec_tag) {
+    GstTagList *taglist;
+    GstCaps *caps;
+
+    /* codec tag */
+    caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (parse));
+    if (G_UNLIKELY (caps == NULL)) {
+      if (GST_PAD_IS_FLUSHING (GST_BASE_PARSE_SRC_PAD (parse))) {
+        GST_INFO_OBJECT (parse, "Src pad is flushing");
+        return GST_FLOW_FLUSHING;
+      } else {
+        GST_INFO_OBJECT (parse, "Src pad is not negotiated!");
+        return GST_FLOW_NOT_NEGOTIATED;
+      }
+    }
+
+    taglist = gst_tag_list_new_empty ();
+    gst_pb_utils_add_codec_description_to_tag_list (taglist,
+        GST_TAG_VIDEO_CODEC, caps);
+    gst_caps_unref (caps);
+
+    gst_base_parse_merge_tags (parse, taglist, GST_TAG_MERGE_REPLACE);
+    gst_tag_list_unref (taglist);
+
+    /* also signals the end of first-frame processing */
+    vp8parse->sent_codec_tag = TRUE;
+  }
+
+  return GST_FLOW_OK;
+}
@@ -0,0 +1,66 @@
+/* GStreamer VP8 Parser
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VP8_PARSE_H__
+#define __GST_VP8_PARSE_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+#include <gst/codecparsers/gstvp8parser.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VP8_PARSE \
+  (gst_vp8_parse_get_type())
+#define GST_VP8_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VP8_PARSE,GstVp8Parse))
+#define GST_VP8_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_VP8_PARSE,GstVp8ParseClass))
+#define GST_IS_VP8_PARSE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VP8_PARSE))
+#define GST_IS_VP8_PARSE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_VP8_PARSE))
+
+GType gst_vp8_parse_get_type (void);
+
+typedef struct _GstVp8Parse GstVp8Parse;
+typedef struct _GstVp8ParseClass GstVp8ParseClass;
+
+struct _GstVp8Parse
+{
+  GstBaseParse baseparse;
+
+  GstVp8Parser parser;
+
+  guint width;
+  guint height;
+  gint profile;
+
+  gboolean update_caps;
+  gboolean sent_codec_tag;
+};
+
+struct _GstVp8ParseClass
+{
+  GstBaseParseClass parent_class;
+};
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,485 @@
+/* GStreamer VP9 Parser
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vp9parse
+ * @title: vp9parse
+ *
+ * Parses VP9 frames as produced by container demuxers, marks key frames
+ * and fills in the stream caps (size, profile, bit depth and chroma format)
+ * without having to decode anything.
+ *
+ * By default superframes are pushed as they are. When downstream asks for
+ * alignment=frame, each frame of a superframe is pushed as its own buffer,
+ * sharing the memory of the input buffer. Frames that are not shown get
+ * the %GST_BUFFER_FLAG_DECODE_ONLY flag and no presentation timestamp.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 filesrc location=video.webm ! matroskademux ! vp9parse ! \
+ *     video/x-vp9,alignment=frame ! fakesink
+ * ]|
+ *
+ * Since: 1.14
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstvp9parse.h"
+
+#include <gst/base/base.h>
+#include <gst/pbutils/pbutils.h>
+
+/* superframe index marker, see Annex B of the VP9 bitstream specification */
+#define VP9_SUPERFRAME_MARKER_MASK 0xe0
+#define VP9_SUPERFRAME_MARKER      0xc0
+#define VP9_MAX_FRAMES_IN_SUPERFRAME 8
+
+GST_DEBUG_CATEGORY (vp9_parse_debug);
+#define GST_CAT_DEFAULT vp9_parse_debug
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9, parsed = (boolean) true, "
+        "alignment = (string) { super-frame, frame }")
+    );
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-vp9")
+    );
+
+#define parent_class gst_vp9_parse_parent_class
+G_DEFINE_TYPE (GstVp9Parse, gst_vp9_parse, GST_TYPE_BASE_PARSE);
+
+static gboolean gst_vp9_parse_start (GstBaseParse * parse);
+static gboolean gst_vp9_parse_stop (GstBaseParse * parse);
+static gboolean gst_vp9_parse_set_sink_caps (GstBaseParse * parse,
+    GstCaps * caps);
+static GstFlowReturn gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize);
+static GstFlowReturn gst_vp9_parse_pre_push_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame);
+
+static void
+gst_vp9_parse_class_init (GstVp9ParseClass * klass)
+{
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (vp9_parse_debug, "vp9parse", 0, "vp9 parser");
+
+  gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
+  gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
+  gst_element_class_set_static_metadata (gstelement_class, "VP9 parser",
+      "Codec/Parser/Converter/Video",
+      "Parses VP9 streams",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  /* Override BaseParse vfuncs */
+  parse_class->start = GST_DEBUG_FUNCPTR (gst_vp9_parse_start);
+  parse_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_parse_stop);
+  parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_vp9_parse_set_sink_caps);
+  parse_class->handle_frame = GST_DEBUG_FUNCPTR (gst_vp9_parse_handle_frame);
+  parse_class->pre_push_frame =
+      GST_DEBUG_FUNCPTR (gst_vp9_parse_pre_push_frame);
+}
+
+static void
+gst_vp9_parse_init (GstVp9Parse * vp9parse)
+{
+  /* hidden frames in superframes have no timestamp of their own */
+  gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (vp9parse), FALSE);
+
+  GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (vp9parse));
+}
+
+static gboolean
+gst_vp9_parse_start (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp9parse, "start");
+
+  vp9parse->parser = gst_vp9_parser_new ();
+
+  vp9parse->split = FALSE;
+  vp9parse->width = 0;
+  vp9parse->height = 0;
+  vp9parse->profile = GST_VP9_PROFILE_UNDEFINED;
+  vp9parse->bit_depth = 0;
+  vp9parse->subsampling_x = -1;
+  vp9parse->subsampling_y = -1;
+
+  vp9parse->update_caps = TRUE;
+  vp9parse->sent_codec_tag = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_stop (GstBaseParse * parse)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp9parse, "stop");
+
+  if (vp9parse->parser) {
+    gst_vp9_parser_free (vp9parse->parser);
+    vp9parse->parser = NULL;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_vp9_parse_set_sink_caps (GstBaseParse * parse, GstCaps * caps)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  GST_DEBUG_OBJECT (vp9parse, "sink caps: %" GST_PTR_FORMAT, caps);
+
+  /* framerate and friends are passed on from upstream */
+  vp9parse->update_caps = TRUE;
+
+  return TRUE;
+}
+
+/* Reads the superframe index at the end of @data, if any. On success the
+ * sizes of the frames it contains are stored in @frame_sizes, and
+ * @index_size is set to the size of the index itself */
+static gboolean
+gst_vp9_parse_superframe_index (const guint8 * data, gsize size,
+    guint * frame_sizes, guint * num_frames, guint * index_size)
+{
+  guint8 marker;
+  guint frames, mag, total, i, j;
+  const guint8 *index;
+
+  if (size < 1)
+    return FALSE;
+
+  marker = data[size - 1];
+  if ((marker & VP9_SUPERFRAME_MARKER_MASK) != VP9_SUPERFRAME_MARKER)
+    return FALSE;
+
+  frames = (marker & 0x7) + 1;
+  mag = ((marker >> 3) & 0x3) + 1;
+  *index_size = 2 + mag * frames;
+
+  /* the marker byte is repeated at the start of the index */
+  if (size < *index_size || data[size - *index_size] != marker)
+    return FALSE;
+
+  index = data + size - *index_size + 1;
+  total = 0;
+  for (i = 0; i < frames; i++) {
+    guint32 frame_size = 0;
+
+    for (j = 0; j < mag; j++)
+      frame_size |= index[j] << (j * 8);
+    index += mag;
+
+    if (frame_size == 0 || frame_size > size - *index_size - total)
+      return FALSE;
+
+    frame_sizes[i] = frame_size;
+    total += frame_size;
+  }
+
+  *num_frames = frames;
+
+  return TRUE;
+}
+
+static const gchar *
+gst_vp9_parse_get_chroma_format (gint subsampling_x, gint subsampling_y)
+{
+  if (subsampling_x == 1 && subsampling_y == 1)
+    return "4:2:0";
+  else if (subsampling_x == 1 && subsampling_y == 0)
+    return "4:2:2";
+  else if (subsampling_x == 0 && subsampling_y == 1)
+    return "4:4:0";
+  else if (subsampling_x == 0 && subsampling_y == 0)
+    return "4:4:4";
+
+  return NULL;
+}
+
+static void
+gst_vp9_parse_update_stream_info (GstVp9Parse * vp9parse,
+    const GstVp9FrameHdr * frame_hdr)
+{
+  GstVp9Parser *parser = vp9parse->parser;
+
+  if (vp9parse->width != frame_hdr->width ||
+      vp9parse->height != frame_hdr->height ||
+      vp9parse->profile != frame_hdr->profile ||
+      vp9parse->bit_depth != parser->bit_depth ||
+      vp9parse->subsampling_x != parser->subsampling_x ||
+      vp9parse->subsampling_y != parser->subsampling_y) {
+    GST_INFO_OBJECT (vp9parse, "%ux%u, profile %u, %u bits, "
+        "subsampling %d/%d", frame_hdr->width, frame_hdr->height,
+        frame_hdr->profile, parser->bit_depth, parser->subsampling_x,
+        parser->subsampling_y);
+
+    vp9parse->width = frame_hdr->width;
+    vp9parse->height = frame_hdr->height;
+    vp9parse->profile = frame_hdr->profile;
+    vp9parse->bit_depth = parser->bit_depth;
+    vp9parse->subsampling_x = parser->subsampling_x;
+    vp9parse->subsampling_y = parser->subsampling_y;
+    vp9parse->update_caps = TRUE;
+  }
+}
+
+static void
+gst_vp9_parse_negotiate (GstVp9Parse * vp9parse)
+{
+  GstCaps *caps;
+  const gchar *alignment = NULL;
+
+  caps = gst_pad_get_allowed_caps (GST_BASE_PARSE_SRC_PAD (vp9parse));
+  GST_DEBUG_OBJECT (vp9parse, "allowed caps: %" GST_PTR_FORMAT, caps);
+
+  /* concentrate on leading structure, since decodebin parser
+   * capsfilter always includes parser template caps */
+  if (caps && !gst_caps_is_empty (caps)) {
+    caps = gst_caps_truncate (caps);
+    caps = gst_caps_fixate (caps);
+    alignment = gst_structure_get_string (gst_caps_get_structure (caps, 0),
+        "alignment");
+  }
+
+  vp9parse->split = g_strcmp0 (alignment, "frame") == 0;
+  GST_DEBUG_OBJECT (vp9parse, "selected alignment %s",
+      vp9parse->split ? "frame" : "super-frame");
+
+  if (caps)
+    gst_caps_unref (caps);
+}
+
+static GstFlowReturn
+gst_vp9_parse_update_src_caps (GstVp9Parse * vp9parse)
+{
+  GstCaps *caps, *sink_caps;
+  const gchar *chroma_format;
+  gboolean ret;
+
+  gst_vp9_parse_negotiate (vp9parse);
+
+  sink_caps = gst_pad_get_current_caps (GST_BASE_PARSE_SINK_PAD (vp9parse));
+  if (sink_caps) {
+    caps = gst_caps_copy (sink_caps);
+    gst_caps_unref (sink_caps);
+  } else {
+    caps = gst_caps_new_empty_simple ("video/x-vp9");
+  }
+
+  gst_caps_set_simple (caps, "parsed", G_TYPE_BOOLEAN, TRUE,
+      "alignment", G_TYPE_STRING, vp9parse->split ? "frame" : "super-frame",
+      NULL);
+
+  if (vp9parse->width > 0 && vp9parse->height > 0) {
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, vp9parse->width,
+        "height", G_TYPE_INT, vp9parse->height, NULL);
+  }
+
+  if (vp9parse->profile < GST_VP9_PROFILE_UNDEFINED) {
+    gchar *profile = g_strdup_printf ("%u", vp9parse->profile);
+
+    gst_caps_set_simple (caps, "profile", G_TYPE_STRING, profile, NULL);
+    g_free (profile);
+  }
+
+  if (vp9parse->bit_depth > 0) {
+    gst_caps_set_simple (caps, "bit-depth-luma", G_TYPE_UINT,
+        vp9parse->bit_depth, "bit-depth-chroma", G_TYPE_UINT,
+        vp9parse->bit_depth, NULL);
+  }
+
+  chroma_format = gst_vp9_parse_get_chroma_format (vp9parse->subsampling_x,
+      vp9parse->subsampling_y);
+  if (chroma_format)
+    gst_caps_set_simple (caps, "chroma-format", G_TYPE_STRING, chroma_format,
+        NULL);
+
+  GST_DEBUG_OBJECT (vp9parse, "setting caps %" GST_PTR_FORMAT, caps);
+  ret = gst_pad_set_caps (GST_BASE_PARSE_SRC_PAD (vp9parse), caps);
+  gst_caps_unref (caps);
+
+  vp9parse->update_caps = FALSE;
+
+  return ret ? GST_FLOW_OK : GST_FLOW_NOT_NEGOTIATED;
+}
+
+static GstFlowReturn
+gst_vp9_parse_handle_frame (GstBaseParse * parse,
+    GstBaseParseFrame * frame, gint * skipsize)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+  GstBuffer *buffer = frame->buffer;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint frame_sizes[VP9_MAX_FRAMES_IN_SUPERFRAME];
+  gboolean key_frame[VP9_MAX_FRAMES_IN_SUPERFRAME];
+  gboolean show_frame[VP9_MAX_FRAMES_IN_SUPERFRAME];
+  guint num_frames, index_size, offset, i;
+  GstMapInfo map;
+  gsize size;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  size = map.size;
+
+  if (!gst_vp9_parse_superframe_index (map.data, map.size, frame_sizes,
+          &num_frames, &index_size)) {
+    frame_sizes[0] = map.size;
+    num_frames = 1;
+    index_size = 0;
+  }
+
+  GST_LOG_OBJECT (vp9parse, "buffer of size %" G_GSIZE_FORMAT " with %u "
+      "frame(s)", map.size, num_frames);
+
+  for (i = 0, offset = 0; i < num_frames; offset += frame_sizes[i], i++) {
+    GstVp9FrameHdr frame_hdr;
+    GstVp9ParserResult pres;
+
+    pres = gst_vp9_parser_parse_frame_header (vp9parse->parser, &frame_hdr,
+        map.data + offset, frame_sizes[i]);
+    if (pres != GST_VP9_PARSER_OK) {
+      GST_WARNING_OBJECT (vp9parse, "failed to parse frame header %u", i);
+      key_frame[i] = FALSE;
+      show_frame[i] = TRUE;
+      continue;
+    }
+
+    key_frame[i] = !frame_hdr.show_existing_frame &&
+        frame_hdr.frame_type == GST_VP9_KEY_FRAME;
+    show_frame[i] = frame_hdr.show_existing_frame || frame_hdr.show_frame;
+
+    if (key_frame[i] || frame_hdr.intra_only)
+      gst_vp9_parse_update_stream_info (vp9parse, &frame_hdr);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  if (gst_pad_check_reconfigure (GST_BASE_PARSE_SRC_PAD (parse)))
+    vp9parse->update_caps = TRUE;
+
+  if (vp9parse->update_caps) {
+    ret = gst_vp9_parse_update_src_caps (vp9parse);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  if (!vp9parse->split || num_frames == 1) {
+    if (key_frame[0])
+      GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    else
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    return gst_base_parse_finish_frame (parse, frame, size);
+  }
+
+  /* need to save buffer from invalidation upon _finish_frame */
+  buffer = gst_buffer_copy (frame->buffer);
+
+  for (i = 0, offset = 0; i < num_frames; offset += frame_sizes[i], i++) {
+    GstBaseParseFrame tmp_frame;
+
+    gst_base_parse_frame_init (&tmp_frame);
+    tmp_frame.flags |= frame->flags;
+    tmp_frame.offset = frame->offset;
+    tmp_frame.overhead = frame->overhead;
+    /* only the metadata of this is used, baseclass takes the actual data
+     * from its adapter, sharing the memory of the input buffer */
+    tmp_frame.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+        offset, frame_sizes[i]);
+
+    if (key_frame[i])
+      GST_BUFFER_FLAG_UNSET (tmp_frame.buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    else
+      GST_BUFFER_FLAG_SET (tmp_frame.buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    if (!show_frame[i]) {
+      GST_BUFFER_PTS (tmp_frame.buffer) = GST_CLOCK_TIME_NONE;
+      GST_BUFFER_DURATION (tmp_frame.buffer) = GST_CLOCK_TIME_NONE;
+      GST_BUFFER_FLAG_SET (tmp_frame.buffer, GST_BUFFER_FLAG_DECODE_ONLY);
+    }
+
+    ret = gst_base_parse_finish_frame (parse, &tmp_frame, frame_sizes[i]);
+    if (ret != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (vp9parse, "finishing frame %u of superframe failed: %s",
+          i, gst_flow_get_name (ret));
+      break;
+    }
+  }
+
+  gst_buffer_unref (buffer);
+
+  /* drop the superframe index and anything the frames didn't cover */
+  if (ret == GST_FLOW_OK && offset < size) {
+    frame->flags |= GST_BASE_PARSE_FRAME_FLAG_DROP;
+    ret = gst_base_parse_finish_frame (parse, frame, size - offset);
+  }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_vp9_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
+{
+  GstVp9Parse *vp9parse = GST_VP9_PARSE (parse);
+
+  if (!vp9parse->sent_codec_tag) {
+    GstTagList *taglist;
+    GstCaps *caps;
+
+    /* codec tag */
+    caps = gst_pad_get_current_caps (GST_BASE_PARSE_SRC_PAD (parse));
+    if (G_UNLIKELY (caps == NULL)) {
+      if (GST_PAD_IS_FLUSHING (GST_BASE_PARSE_SRC_PAD (parse))) {
+        GST_INFO_OBJECT (parse, "Src pad is flushing");
+        return GST_FLOW_FLUSHING;
+      } else {
+        GST_INFO_OBJECT (parse, "Src pad is not negotiated!");
+        return GST_FLOW_NOT_NEGOTIATED;
+      }
+    }
+
+    taglist = gst_tag_list_new_empty ();
+    gst_pb_utils_add_codec_description_to_tag_list (taglist,
+        GST_TAG_VIDEO_CODEC, caps);
+    gst_caps_unref (caps);
+
+    gst_base_parse_merge_tags (parse, taglist, GST_TAG_MERGE_REPLACE);
+    gst_tag_list_unref (taglist);
+
+    /* also signals the end of first-frame processing */
+    vp9parse->sent_codec_tag = TRUE;
+  }
+
+  return GST_FLOW_OK;
+}
@@ -0,0 +1,201 @@
+/* GStreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Start code table for byte-stream parsers.
+ *
+ * Locating the end of a NAL means scanning its whole payload for the next
+ * start code, which dominates parsing of high bitrate intra-only streams
+ * where a single slice can span megabytes. The table is extended with the
+ * newly arrived bytes only, so a partial access unit is not rescanned when
+ * more data comes in, and large ranges are split into chunks scanned on a
+ * thread pool. The caller still walks the NALs in order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "nalscan.h"
+
+/* smallest range handed to a helper thread */
+#define NAL_SCAN_CHUNK_SIZE (256 * 1024)
+
+typedef struct
+{
+  NalScan *scan;
+  const guint8 *data;
+  gsize size;
+  guint start;
+  guint end;
+  GArray *codes;
+} NalScanJob;
+
+/* collects the prefixes starting in [start, end); the last one may extend
+ * up to two bytes beyond end, which must be within size */
+static void
+nal_scan_range (const guint8 * data, gsize size, guint start, guint end,
+    GArray * codes)
+{
+  gsize i, limit;
+
+  limit = MIN ((gsize) end + 2, size);
+
+  i = start + 2;
+  while (i < limit) {
+    if (data[i] > 1) {
+      /* no prefix can end at i, i + 1 or i + 2 */
+      i += 3;
+    } else if (data[i] == 1 && data[i - 1] == 0 && data[i - 2] == 0) {
+      guint offset = i - 2;
+
+      g_array_append_val (codes, offset);
+      i += 3;
+    } else {
+      i++;
+    }
+  }
+}
+
+static void
+nal_scan_job_func (gpointer data, gpointer user_data)
+{
+  NalScanJob *job = data;
+  NalScan *scan = job->scan;
+
+  nal_scan_range (job->data, job->size, job->start, job->end, job->codes);
+
+  g_mutex_lock (&scan->lock);
+  if (--scan->pending == 0)
+    g_cond_signal (&scan->cond);
+  g_mutex_unlock (&scan->lock);
+}
+
+void
+gst_nal_scan_init (NalScan * scan, guint n_threads)
+{
+  scan->pool = NULL;
+  scan->n_threads = MAX (n_threads, 1);
+  if (scan->n_threads > 1) {
+    /* the calling thread scans a chunk as well */
+    scan->pool = g_thread_pool_new (nal_scan_job_func, scan,
+        scan->n_threads - 1, FALSE, NULL);
+  }
+
+  g_mutex_init (&scan->lock);
+  g_cond_init (&scan->cond);
+  scan->pending = 0;
+
+  scan->codes = g_array_new (FALSE, FALSE, sizeof (guint));
+  scan->scanned = 0;
+}
+
+void
+gst_nal_scan_clear (NalScan * scan)
+{
+  if (scan->pool) {
+    g_thread_pool_free (scan->pool, FALSE, TRUE);
+    scan->pool = NULL;
+  }
+  if (scan->codes) {
+    g_array_free (scan->codes, TRUE);
+    scan->codes = NULL;
+  }
+  g_mutex_clear (&scan->lock);
+  g_cond_clear (&scan->cond);
+}
+
+/* forgets the table, e.g. when the frame data starts anew */
+void
+gst_nal_scan_reset (NalScan * scan)
+{
+  g_array_set_size (scan->codes, 0);
+  scan->scanned = 0;
+}
+
+/* extends the table to cover @size bytes of @data, which must start with
+ * the bytes seen by the previous calls since the last reset */
+void
+gst_nal_scan_update (NalScan * scan, const guint8 * data, gsize size)
+{
+  NalScanJob *jobs;
+  guint start, end, n_jobs, chunk, i;
+
+  if (size < 3 || size - 2 <= scan->scanned)
+    return;
+
+  /* a prefix starting in the last two bytes is not complete yet */
+  start = scan->scanned;
+  end = size - 2;
+  scan->scanned = end;
+
+  n_jobs = MIN (scan->n_threads, (end - start) / NAL_SCAN_CHUNK_SIZE);
+  if (n_jobs < 2 || !scan->pool) {
+    nal_scan_range (data, size, start, end, scan->codes);
+    return;
+  }
+
+  jobs = g_newa (NalScanJob, n_jobs);
+  chunk = (end - start) / n_jobs;
+
+  scan->pending = n_jobs - 1;
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i].scan = scan;
+    jobs[i].data = data;
+    jobs[i].size = size;
+    jobs[i].start = start + i * chunk;
+    jobs[i].end = (i == n_jobs - 1) ? end : jobs[i].start + chunk;
+    jobs[i].codes = (i == 0) ? scan->codes :
+        g_array_new (FALSE, FALSE, sizeof (guint));
+    if (i > 0)
+      g_thread_pool_push (scan->pool, &jobs[i], NULL);
+  }
+
+  nal_scan_range (data, size, jobs[0].start, jobs[0].end, scan->codes);
+
+  g_mutex_lock (&scan->lock);
+  while (scan->pending > 0)
+    g_cond_wait (&scan->cond, &scan->lock);
+  g_mutex_unlock (&scan->lock);
+
+  /* chunks are consecutive, so appending keeps the table sorted */
+  for (i = 1; i < n_jobs; i++) {
+    g_array_append_vals (scan->codes, jobs[i].codes->data, jobs[i].codes->len);
+    g_array_free (jobs[i].codes, TRUE);
+  }
+}
+
+/* returns the offset of the first prefix at or after @offset, or -1 if
+ * there is none in the data scanned so far */
+gint
+gst_nal_scan_next (NalScan * scan, guint offset)
+{
+  const guint *codes = (const guint *) scan->codes->data;
+  guint lo = 0, hi = scan->codes->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (codes[mid] < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo < scan->codes->len ? (gint) codes[lo] : -1;
+}
@@ -0,0 +1,61 @@
+/* GStreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_NAL_SCAN_H__
+#define __GST_NAL_SCAN_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _NalScan NalScan;
+
+/* Start codes found so far in the data of the frame being parsed */
+struct _NalScan
+{
+  /* helper threads, NULL if scanning on the calling thread only */
+  GThreadPool *pool;
+  guint n_threads;
+
+  GMutex lock;
+  GCond cond;
+  guint pending;
+
+  /* guint offset of each 0x000001 prefix, in increasing order */
+  GArray *codes;
+  /* every prefix starting before this offset is in codes */
+  guint scanned;
+};
+
+void gst_nal_scan_init   (NalScan * scan,
+                          guint     n_threads);
+
+void gst_nal_scan_clear  (NalScan * scan);
+
+void gst_nal_scan_reset  (NalScan * scan);
+
+void gst_nal_scan_update (NalScan      * scan,
+                          const guint8 * data,
+                          gsize          size);
+
+gint gst_nal_scan_next   (NalScan * scan,
+                          guint     offset);
+
+G_END_DECLS
+#endif
@@ -20,6 +20,7 @@
 
 #include <gst/check/gstcheck.h>
 #include "adaptive_demux_common.h"
+#include "../../ext/dash/gstisoff.h"
 
 #define DEMUX_ELEMENT_NAME "dashdemux"
 
@@ -1516,6 +1517,766 @@ GST_START_TEST (testContentProtection)
 
 GST_END_TEST;
 
+/* the start of the last fragment pushed and the URIs requested, for
+ * testAbrBuffer */
+static GMutex abr_lock;
+static GstClockTime abr_last_pts;
+static GPtrArray *abr_requests;
+
+static gboolean
+testAbrBufferHttpSrcStart (GstTestHTTPSrc * src,
+    const gchar * uri, GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  g_mutex_lock (&abr_lock);
+  if (g_str_has_suffix (uri, ".webm"))
+    g_ptr_array_add (abr_requests, g_strdup (uri));
+  g_mutex_unlock (&abr_lock);
+
+  return gst_dashdemux_http_src_start (src, uri, input_data, user_data);
+}
+
+static GstPadProbeReturn
+testAbrBufferDemuxSendsBuffer (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (GST_BUFFER_PTS_IS_VALID (buffer)) {
+    g_mutex_lock (&abr_lock);
+    abr_last_pts = GST_BUFFER_PTS (buffer);
+    g_mutex_unlock (&abr_lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Answers the position queries of dashdemux so that the buffer level is
+ * 10s after the second fragment, 3s after the third one and 0 otherwise */
+static GstPadProbeReturn
+testAbrBufferDemuxQueriesPosition (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+  GstClockTime pts, level;
+  GstFormat format;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_POSITION)
+    return GST_PAD_PROBE_OK;
+
+  gst_query_parse_position (query, &format, NULL);
+  if (format != GST_FORMAT_TIME)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&abr_lock);
+  pts = abr_last_pts;
+  g_mutex_unlock (&abr_lock);
+
+  if (!GST_CLOCK_TIME_IS_VALID (pts))
+    return GST_PAD_PROBE_OK;
+
+  switch (pts / (10 * GST_SECOND)) {
+    case 1:
+      level = 10 * GST_SECOND;
+      break;
+    case 2:
+      level = 3 * GST_SECOND;
+      break;
+    default:
+      level = 0;
+      break;
+  }
+
+  gst_query_set_position (query, GST_FORMAT_TIME,
+      pts > level ? pts - level : 0);
+
+  return GST_PAD_PROBE_HANDLED;
+}
+
+static void
+testAbrBufferPreTest (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  gst_util_set_object_arg (G_OBJECT (engine->demux), "abr-algorithm",
+      "buffer");
+  g_object_set (engine->demux, "abr-buffer-target", 4 * GST_SECOND, NULL);
+}
+
+static void
+testAbrBufferDemuxPadAdded (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  gst_pad_add_probe (stream->pad, GST_PAD_PROBE_TYPE_BUFFER,
+      testAbrBufferDemuxSendsBuffer, NULL, NULL);
+  gst_pad_add_probe (stream->pad,
+      GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM | GST_PAD_PROBE_TYPE_PUSH,
+      testAbrBufferDemuxQueriesPosition, NULL, NULL);
+}
+
+static void
+testAbrBufferAppsinkEos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  g_main_loop_quit (engine->loop);
+}
+
+/*
+ * Test the buffer based bitrate selection
+ * The buffer level reported downstream goes from empty to above the buffer
+ * target, to between the mid and high bitrate thresholds and back to empty.
+ * With a 4s buffer target the lowest representation is used below ~2.4s,
+ * the highest one above ~3.4s and the middle one in between
+ */
+GST_START_TEST (testAbrBuffer)
+{
+  const gchar *mpd =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"static\""
+      "     minBufferTime=\"PT1.500S\""
+      "     mediaPresentationDuration=\"PT50S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/webm\">"
+      "      <SegmentTemplate media=\"$RepresentationID$/$Number$.webm\""
+      "                       duration=\"10\" startNumber=\"1\"/>"
+      "      <Representation id=\"low\" codecs=\"vp9\" width=\"426\""
+      "                      height=\"240\" bandwidth=\"250000\"/>"
+      "      <Representation id=\"mid\" codecs=\"vp9\" width=\"640\""
+      "                      height=\"360\" bandwidth=\"500000\"/>"
+      "      <Representation id=\"high\" codecs=\"vp9\" width=\"1280\""
+      "                      height=\"720\" bandwidth=\"1000000\"/>"
+      "    </AdaptationSet></Period></MPD>";
+
+  GstDashDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/test.mpd", (guint8 *) mpd, 0},
+    {"http://unit.test/low/1.webm", NULL, 10000},
+    {"http://unit.test/low/2.webm", NULL, 10000},
+    {"http://unit.test/low/3.webm", NULL, 10000},
+    {"http://unit.test/low/4.webm", NULL, 10000},
+    {"http://unit.test/low/5.webm", NULL, 10000},
+    {"http://unit.test/mid/1.webm", NULL, 10000},
+    {"http://unit.test/mid/2.webm", NULL, 10000},
+    {"http://unit.test/mid/3.webm", NULL, 10000},
+    {"http://unit.test/mid/4.webm", NULL, 10000},
+    {"http://unit.test/mid/5.webm", NULL, 10000},
+    {"http://unit.test/high/1.webm", NULL, 10000},
+    {"http://unit.test/high/2.webm", NULL, 10000},
+    {"http://unit.test/high/3.webm", NULL, 10000},
+    {"http://unit.test/high/4.webm", NULL, 10000},
+    {"http://unit.test/high/5.webm", NULL, 10000},
+    {NULL, NULL, 0},
+  };
+  const gchar *expected_requests[] = {
+    "http://unit.test/low/1.webm",
+    "http://unit.test/low/2.webm",
+    "http://unit.test/high/3.webm",
+    "http://unit.test/mid/4.webm",
+    "http://unit.test/low/5.webm",
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+  guint i;
+
+  abr_last_pts = GST_CLOCK_TIME_NONE;
+  abr_requests = g_ptr_array_new_with_free_func (g_free);
+
+  http_src_callbacks.src_start = testAbrBufferHttpSrcStart;
+  http_src_callbacks.src_create = gst_dashdemux_http_src_create;
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testAbrBufferPreTest;
+  test_callbacks.demux_pad_added = testAbrBufferDemuxPadAdded;
+  test_callbacks.appsink_eos = testAbrBufferAppsinkEos;
+
+  testData = gst_dash_demux_test_case_new ();
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  assert_equals_int (abr_requests->len, G_N_ELEMENTS (expected_requests));
+  for (i = 0; i < abr_requests->len; i++)
+    assert_equals_string (g_ptr_array_index (abr_requests, i),
+        expected_requests[i]);
+
+  g_ptr_array_unref (abr_requests);
+  abr_requests = NULL;
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+}
+
+GST_END_TEST;
+
+/* sample flags of the trun entries */
+#define TRICKMODE_SAMPLE_SYNC 0x02000000
+#define TRICKMODE_SAMPLE_NON_SYNC 0x01010000
+#define TRICKMODE_SAMPLE_SIZE 16384
+#define TRICKMODE_N_FRAGMENTS 3
+
+typedef struct
+{
+  guint32 duration;
+  guint32 flags;
+} TrickModeSample;
+
+/* the fragments and the bytes of each that were downloaded, for
+ * testTrickModeKeyUnits */
+static GMutex trickmode_lock;
+static const GstDashDemuxTestInputData *trickmode_inputs;
+static guint8 *trickmode_served[TRICKMODE_N_FRAGMENTS];
+static gint trickmode_seeked;
+static GThread *trickmode_seek_thread;
+
+static void
+append_uint32 (GByteArray * data, guint32 value)
+{
+  guint8 bytes[4];
+
+  GST_WRITE_UINT32_BE (bytes, value);
+  g_byte_array_append (data, bytes, 4);
+}
+
+static void
+append_box_header (GByteArray * data, guint32 size, guint32 fourcc)
+{
+  guint8 bytes[4];
+
+  append_uint32 (data, size);
+  GST_WRITE_UINT32_LE (bytes, fourcc);
+  g_byte_array_append (data, bytes, 4);
+}
+
+static guint
+trickmode_moof_size (guint n_samples)
+{
+  /* moof, mfhd, traf, tfhd and a trun with duration, size and flags */
+  return 8 + 16 + 8 + 16 + 20 + 12 * n_samples;
+}
+
+/* offset of a sample in a fragment made by make_trickmode_fragment() */
+static guint
+trickmode_sample_offset (guint n_samples, guint sample)
+{
+  return trickmode_moof_size (n_samples) + 8 + sample * TRICKMODE_SAMPLE_SIZE;
+}
+
+/* a moof with a single trun and the mdat with its samples */
+static GByteArray *
+make_trickmode_fragment (guint32 sequence_number,
+    const TrickModeSample * samples, guint n_samples)
+{
+  GByteArray *data = g_byte_array_new ();
+  guint moof_size = trickmode_moof_size (n_samples);
+  guint8 *payload;
+  guint i;
+
+  append_box_header (data, moof_size, GST_MAKE_FOURCC ('m', 'o', 'o', 'f'));
+  append_box_header (data, 16, GST_MAKE_FOURCC ('m', 'f', 'h', 'd'));
+  append_uint32 (data, 0);
+  append_uint32 (data, sequence_number);
+  append_box_header (data, moof_size - 24, GST_MAKE_FOURCC ('t', 'r', 'a',
+          'f'));
+  append_box_header (data, 16, GST_MAKE_FOURCC ('t', 'f', 'h', 'd'));
+  append_uint32 (data, GST_TFHD_FLAGS_DEFAULT_BASE_IS_MOOF);
+  append_uint32 (data, 1);
+  append_box_header (data, 20 + 12 * n_samples, GST_MAKE_FOURCC ('t', 'r',
+          'u', 'n'));
+  append_uint32 (data, GST_TRUN_FLAGS_DATA_OFFSET_PRESENT |
+      GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT |
+      GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT | GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT);
+  append_uint32 (data, n_samples);
+  append_uint32 (data, moof_size + 8);
+  for (i = 0; i < n_samples; i++) {
+    append_uint32 (data, samples[i].duration);
+    append_uint32 (data, TRICKMODE_SAMPLE_SIZE);
+    append_uint32 (data, samples[i].flags);
+  }
+  fail_unless_equals_int (data->len, moof_size);
+
+  append_box_header (data, 8 + n_samples * TRICKMODE_SAMPLE_SIZE,
+      GST_MAKE_FOURCC ('m', 'd', 'a', 't'));
+  payload = g_malloc (TRICKMODE_SAMPLE_SIZE);
+  for (i = 0; i < n_samples; i++) {
+    memset (payload, i, TRICKMODE_SAMPLE_SIZE);
+    g_byte_array_append (data, payload, TRICKMODE_SAMPLE_SIZE);
+  }
+  g_free (payload);
+
+  return data;
+}
+
+static GstFlowReturn
+testTrickModeHttpSrcCreate (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  const GstDashDemuxTestInputData *input =
+      (const GstDashDemuxTestInputData *) context;
+  guint i;
+
+  /* the manifest is the first input, the fragments follow it */
+  g_mutex_lock (&trickmode_lock);
+  for (i = 0; i < TRICKMODE_N_FRAGMENTS; i++) {
+    if (input == &trickmode_inputs[i + 1])
+      memset (trickmode_served[i] + offset, 1, length);
+  }
+  g_mutex_unlock (&trickmode_lock);
+
+  return gst_dashdemux_http_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+/* returns the number of bytes of the range that were downloaded */
+static guint
+trickmode_bytes_served (guint fragment, guint offset, guint size)
+{
+  guint i, served = 0;
+
+  g_mutex_lock (&trickmode_lock);
+  for (i = offset; i < offset + size; i++)
+    served += trickmode_served[fragment][i];
+  g_mutex_unlock (&trickmode_lock);
+
+  return served;
+}
+
+static gpointer
+testTrickModeSeek (gpointer user_data)
+{
+  GstElement *pipeline = user_data;
+
+  /* backwards from within the last fragment, keyframes only */
+  fail_unless (gst_element_send_event (pipeline,
+          gst_event_new_seek (-1.0, GST_FORMAT_TIME,
+              GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS,
+              GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, 11 * GST_SECOND)));
+
+  return NULL;
+}
+
+/* Holds back the first buffer until the seek flushes it, so that nothing
+ * but the start of the first fragment is downloaded before the seek */
+static GstPadProbeReturn
+testTrickModeDemuxBlocked (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  if (g_atomic_int_get (&trickmode_seeked))
+    return GST_PAD_PROBE_REMOVE;
+
+  g_atomic_int_set (&trickmode_seeked, TRUE);
+  trickmode_seek_thread =
+      g_thread_new ("seek", testTrickModeSeek, GST_ELEMENT (user_data));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+testTrickModePreTest (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  /* skip at least 2s between keyframes */
+  gst_util_set_object_arg (G_OBJECT (engine->demux), "max-video-framerate",
+      "1/2");
+}
+
+static void
+testTrickModeDemuxPadAdded (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  gst_pad_add_probe (stream->pad,
+      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER,
+      testTrickModeDemuxBlocked, engine->pipeline, NULL);
+}
+
+static void
+testTrickModeAppsinkEos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  g_main_loop_quit (engine->loop);
+}
+
+/*
+ * Test reverse key-unit trick mode
+ * The last and first fragments have no sync sample and are downloaded
+ * completely. The middle one has keyframes at 0s, 0.25s, 0.5s and 3.5s, as
+ * given by its trun sample durations. With at least 2s between keyframes,
+ * only the ones at 3.5s, 0.5s and 0.25s are downloaded and the samples
+ * between them are skipped.
+ */
+GST_START_TEST (testTrickModeKeyUnits)
+{
+  const gchar *mpd =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"static\""
+      "     minBufferTime=\"PT1.500S\""
+      "     mediaPresentationDuration=\"PT12S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <SegmentTemplate media=\"video-$Number$.mp4\""
+      "                       duration=\"4\" startNumber=\"1\"/>"
+      "      <Representation id=\"video\" codecs=\"avc1.4d401f\" width=\"640\""
+      "                      height=\"360\" bandwidth=\"250000\"/>"
+      "    </AdaptationSet></Period></MPD>";
+  const TrickModeSample no_sync_samples[] = {
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+  };
+  const TrickModeSample irregular_samples[] = {
+    {250, TRICKMODE_SAMPLE_SYNC},
+    {250, TRICKMODE_SAMPLE_SYNC},
+    {1000, TRICKMODE_SAMPLE_SYNC},
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+    {1000, TRICKMODE_SAMPLE_NON_SYNC},
+    {500, TRICKMODE_SAMPLE_SYNC},
+  };
+  const guint n_irregular = G_N_ELEMENTS (irregular_samples);
+  GByteArray *fragments[TRICKMODE_N_FRAGMENTS];
+  GstDashDemuxTestInputData inputTestData[TRICKMODE_N_FRAGMENTS + 2] = {
+    {"http://unit.test/test.mpd", (guint8 *) mpd, 0},
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+  guint i;
+
+  fragments[0] = make_trickmode_fragment (1, no_sync_samples,
+      G_N_ELEMENTS (no_sync_samples));
+  fragments[1] = make_trickmode_fragment (2, irregular_samples, n_irregular);
+  fragments[2] = make_trickmode_fragment (3, no_sync_samples,
+      G_N_ELEMENTS (no_sync_samples));
+  for (i = 0; i < TRICKMODE_N_FRAGMENTS; i++) {
+    inputTestData[i + 1].uri =
+        g_strdup_printf ("http://unit.test/video-%u.mp4", i + 1);
+    inputTestData[i + 1].payload = fragments[i]->data;
+    inputTestData[i + 1].size = fragments[i]->len;
+    trickmode_served[i] = g_malloc0 (fragments[i]->len);
+  }
+  trickmode_inputs = inputTestData;
+  trickmode_seeked = FALSE;
+  trickmode_seek_thread = NULL;
+
+  http_src_callbacks.src_start = gst_dashdemux_http_src_start;
+  http_src_callbacks.src_create = testTrickModeHttpSrcCreate;
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testTrickModePreTest;
+  test_callbacks.demux_pad_added = testTrickModeDemuxPadAdded;
+  test_callbacks.appsink_eos = testTrickModeAppsinkEos;
+
+  testData = gst_dash_demux_test_case_new ();
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  fail_unless (trickmode_seek_thread != NULL);
+  g_thread_join (trickmode_seek_thread);
+
+  /* no sync sample, downloaded completely */
+  assert_equals_int (trickmode_bytes_served (2, 0, fragments[2]->len),
+      fragments[2]->len);
+
+  /* key-unit mode is still used for the next fragment, only the keyframes
+   * picked by their trun timestamps are downloaded */
+  for (i = 1; i < n_irregular; i++) {
+    guint offset = trickmode_sample_offset (n_irregular, i);
+    guint served = trickmode_bytes_served (1, offset, TRICKMODE_SAMPLE_SIZE);
+
+    if (irregular_samples[i].flags == TRICKMODE_SAMPLE_SYNC)
+      fail_unless_equals_int (served, TRICKMODE_SAMPLE_SIZE);
+    else
+      fail_unless_equals_int (served, 0);
+  }
+
+  for (i = 0; i < TRICKMODE_N_FRAGMENTS; i++) {
+    g_free ((gchar *) inputTestData[i + 1].uri);
+    g_free (trickmode_served[i]);
+    trickmode_served[i] = NULL;
+    g_byte_array_unref (fragments[i]);
+  }
+  trickmode_inputs = NULL;
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+}
+
+GST_END_TEST;
+
+#define LOW_LATENCY_FRAGMENT_SIZE 100000
+
+/* the URIs of the fragments requested, the time of the first request and
+ * the fragment that stalls halfway, for the low-latency tests */
+static GMutex low_latency_lock;
+static GPtrArray *low_latency_requests;
+static gint64 low_latency_first_request;
+static const GstDashDemuxTestInputData *low_latency_stalled_input;
+static gboolean low_latency_enabled;
+
+static gboolean
+testLowLatencyHttpSrcStart (GstTestHTTPSrc * src,
+    const gchar * uri, GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  g_mutex_lock (&low_latency_lock);
+  if (g_str_has_suffix (uri, ".webm")) {
+    if (low_latency_requests->len == 0)
+      low_latency_first_request = g_get_real_time ();
+    g_ptr_array_add (low_latency_requests, g_strdup (uri));
+  }
+  g_mutex_unlock (&low_latency_lock);
+
+  return gst_dashdemux_http_src_start (src, uri, input_data, user_data);
+}
+
+/* Waits for 1s before sending the middle of the stalled fragment, as a
+ * server does while the encoder produces the next chunk */
+static GstFlowReturn
+testLowLatencyHttpSrcCreate (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  if (context == low_latency_stalled_input
+      && offset <= LOW_LATENCY_FRAGMENT_SIZE / 2
+      && offset + length > LOW_LATENCY_FRAGMENT_SIZE / 2)
+    g_usleep (G_USEC_PER_SEC);
+
+  return gst_dashdemux_http_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+static void
+testLowLatencyPreTest (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "low-latency", low_latency_enabled, NULL);
+}
+
+static void
+testLowLatencyAppsinkEos (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, gpointer user_data)
+{
+  g_main_loop_quit (engine->loop);
+}
+
+/* only the start of a live fragment matters */
+static gboolean
+testLowLatencyAppsinkReceivedData (GstAdaptiveDemuxTestEngine * engine,
+    GstAdaptiveDemuxTestOutputStream * stream, GstBuffer * buffer,
+    gpointer user_data)
+{
+  g_main_loop_quit (engine->loop);
+  return TRUE;
+}
+
+/* Plays the first two fragments of a stream with a low and a high
+ * representation, the first fragment stalling for 1s, and returns the URI
+ * of the second one */
+static gchar *
+run_low_latency_bitrate_test (gboolean low_latency)
+{
+  const gchar *mpd =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"static\""
+      "     minBufferTime=\"PT1.500S\""
+      "     mediaPresentationDuration=\"PT20S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/webm\">"
+      "      <SegmentTemplate media=\"$RepresentationID$/$Number$.webm\""
+      "                       duration=\"10\" startNumber=\"1\"/>"
+      "      <Representation id=\"low\" codecs=\"vp9\" width=\"426\""
+      "                      height=\"240\" bandwidth=\"250000\"/>"
+      "      <Representation id=\"high\" codecs=\"vp9\" width=\"1280\""
+      "                      height=\"720\" bandwidth=\"1000000\"/>"
+      "    </AdaptationSet></Period></MPD>";
+
+  GstDashDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/test.mpd", (guint8 *) mpd, 0},
+    {"http://unit.test/low/1.webm", NULL, LOW_LATENCY_FRAGMENT_SIZE},
+    {"http://unit.test/low/2.webm", NULL, LOW_LATENCY_FRAGMENT_SIZE},
+    {"http://unit.test/high/2.webm", NULL, LOW_LATENCY_FRAGMENT_SIZE},
+    {NULL, NULL, 0},
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+  gchar *second_request;
+
+  low_latency_requests = g_ptr_array_new_with_free_func (g_free);
+  low_latency_stalled_input = &inputTestData[1];
+  low_latency_enabled = low_latency;
+
+  http_src_callbacks.src_start = testLowLatencyHttpSrcStart;
+  http_src_callbacks.src_create = testLowLatencyHttpSrcCreate;
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testLowLatencyPreTest;
+  test_callbacks.appsink_eos = testLowLatencyAppsinkEos;
+
+  testData = gst_dash_demux_test_case_new ();
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  assert_equals_int (low_latency_requests->len, 2);
+  assert_equals_string (g_ptr_array_index (low_latency_requests, 0),
+      "http://unit.test/low/1.webm");
+  second_request = g_strdup (g_ptr_array_index (low_latency_requests, 1));
+
+  g_ptr_array_unref (low_latency_requests);
+  low_latency_requests = NULL;
+  low_latency_stalled_input = NULL;
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+
+  return second_request;
+}
+
+/*
+ * Test the download rate measured in low-latency mode
+ * The first fragment, 800kbit, stalls for 1s in the middle. Counting the
+ * stall, the rate is too low for the 1Mbps representation. In low-latency
+ * mode the stall is left out and that representation is used next.
+ */
+GST_START_TEST (testLowLatencyBitrate)
+{
+  gchar *uri;
+
+  uri = run_low_latency_bitrate_test (FALSE);
+  assert_equals_string (uri, "http://unit.test/low/2.webm");
+  g_free (uri);
+
+  uri = run_low_latency_bitrate_test (TRUE);
+  assert_equals_string (uri, "http://unit.test/high/2.webm");
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+/* Starts a live stream of 30s segments that became available one to two
+ * seconds ago, and returns when its first segment was requested, in
+ * microseconds after the availability start time */
+static gint64
+run_low_latency_availability_test (const gchar * availability_time_offset)
+{
+  GDateTime *now, *second_start, *availability_start;
+  gchar *availability_start_str, *mpd;
+  gint64 request_time;
+  GstDashDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/test.mpd", NULL, 0},
+    {"http://unit.test/video-1.webm", NULL, 1000},
+    {NULL, NULL, 0},
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstTestHTTPSrcTestData http_src_test_data = { 0 };
+  GstAdaptiveDemuxTestCallbacks test_callbacks = { 0 };
+  GstDashDemuxTestCase *testData;
+
+  now = g_date_time_new_now_utc ();
+  second_start = g_date_time_new_utc (g_date_time_get_year (now),
+      g_date_time_get_month (now), g_date_time_get_day_of_month (now),
+      g_date_time_get_hour (now), g_date_time_get_minute (now),
+      g_date_time_get_second (now));
+  availability_start = g_date_time_add_seconds (second_start, -1);
+  availability_start_str =
+      g_date_time_format (availability_start, "%Y-%m-%dT%H:%M:%S");
+  mpd = g_strdup_printf ("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      "     xmlns=\"urn:mpeg:DASH:schema:MPD:2011\""
+      "     xsi:schemaLocation=\"urn:mpeg:DASH:schema:MPD:2011 DASH-MPD.xsd\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"%s\""
+      "     minimumUpdatePeriod=\"PT1H\""
+      "     suggestedPresentationDelay=\"PT0S\""
+      "     minBufferTime=\"PT1.500S\">"
+      "  <Period id=\"1\" start=\"PT0S\">"
+      "    <AdaptationSet mimeType=\"video/webm\">"
+      "      <SegmentTemplate media=\"video-$Number$.webm\""
+      "                       duration=\"30\" startNumber=\"1\""
+      "                       availabilityTimeOffset=\"%s\"/>"
+      "      <Representation id=\"video\" codecs=\"vp9\" width=\"426\""
+      "                      height=\"240\" bandwidth=\"250000\"/>"
+      "    </AdaptationSet></Period></MPD>", availability_start_str,
+      availability_time_offset);
+  inputTestData[0].payload = (guint8 *) mpd;
+
+  low_latency_requests = g_ptr_array_new_with_free_func (g_free);
+  low_latency_enabled = TRUE;
+
+  http_src_callbacks.src_start = testLowLatencyHttpSrcStart;
+  http_src_callbacks.src_create = gst_dashdemux_http_src_create;
+  http_src_test_data.input = inputTestData;
+  gst_test_http_src_install_callbacks (&http_src_callbacks,
+      &http_src_test_data);
+
+  test_callbacks.pre_test = testLowLatencyPreTest;
+  test_callbacks.appsink_received_data = testLowLatencyAppsinkReceivedData;
+
+  testData = gst_dash_demux_test_case_new ();
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME, "http://unit.test/test.mpd",
+      &test_callbacks, testData);
+
+  assert_equals_int (low_latency_requests->len, 1);
+  request_time =
+      low_latency_first_request - g_date_time_to_unix (availability_start) *
+      G_USEC_PER_SEC;
+
+  g_ptr_array_unref (low_latency_requests);
+  low_latency_requests = NULL;
+  g_object_unref (testData);
+  if (http_src_test_data.data)
+    gst_structure_free (http_src_test_data.data);
+  g_free (mpd);
+  g_free (availability_start_str);
+  g_date_time_unref (availability_start);
+  g_date_time_unref (second_start);
+  g_date_time_unref (now);
+
+  return request_time;
+}
+
+/*
+ * Test the availabilityTimeOffset in low-latency mode
+ * The first segment is complete 30s after the availability start time. With
+ * an offset of 25s it is requested 5s after the availability start time,
+ * with an infinite one at once.
+ */
+GST_START_TEST (testLowLatencyAvailabilityTimeOffset)
+{
+  gint64 request_time;
+
+  request_time = run_low_latency_availability_test ("25");
+  fail_unless (request_time >= 5 * G_USEC_PER_SEC - 50 * 1000,
+      "requested %" G_GINT64_FORMAT "us after the availability start",
+      request_time);
+  fail_unless (request_time < 10 * G_USEC_PER_SEC,
+      "requested %" G_GINT64_FORMAT "us after the availability start",
+      request_time);
+
+  request_time = run_low_latency_availability_test ("INF");
+  fail_unless (request_time < 3 * G_USEC_PER_SEC,
+      "requested %" G_GINT64_FORMAT "us after the availability start",
+      request_time);
+}
+
+GST_END_TEST;
+
 static Suite *
 dash_demux_suite (void)
 {
@@ -1541,6 +2302,10 @@ dash_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaDownloadErrorMiddleFragment);
   tcase_add_test (tc_basicTest, testQuery);
   tcase_add_test (tc_basicTest, testContentProtection);
+  tcase_add_test (tc_basicTest, testAbrBuffer);
+  tcase_add_test (tc_basicTest, testTrickModeKeyUnits);
+  tcase_add_test (tc_basicTest, testLowLatencyBitrate);
+  tcase_add_test (tc_basicTest, testLowLatencyAvailabilityTimeOffset);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -2114,6 +2114,59 @@ GST_START_TEST (dash_mpdparser_adapt_repr_segmentTemplate_inherit)
   gst_mpd_client_free (mpdclient);
 }
 
+GST_END_TEST;
+
+/*
+ * Test parsing SegmentTemplate availabilityTimeOffset with inheritance
+ */
+GST_START_TEST (dash_mpdparser_segmentTemplate_availabilityTimeOffset)
+{
+  GstPeriodNode *periodNode;
+  GstAdaptationSetNode *adaptationSet;
+  GstSegmentTemplateNode *segmentTemplate;
+  GstRepresentationNode *representation;
+  GstSegmentBaseType *segBaseType;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">"
+      "  <Period duration=\"PT0H5M0.000S\">"
+      "    <AdaptationSet>"
+      "      <SegmentTemplate availabilityTimeOffset=\"1.5\"/>"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate timescale=\"1000\" media=\"$Number$.m4s\""
+      "                         duration=\"2000\"/>"
+      "      </Representation>"
+      "      <Representation id=\"2\" bandwidth=\"500000\">"
+      "        <SegmentTemplate availabilityTimeOffset=\"INF\"/>"
+      "  </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  periodNode = (GstPeriodNode *) mpdclient->mpd_node->Periods->data;
+  adaptationSet = (GstAdaptationSetNode *) periodNode->AdaptationSets->data;
+
+  representation = (GstRepresentationNode *)
+      adaptationSet->Representations->data;
+  segmentTemplate = representation->SegmentTemplate;
+  fail_if (segmentTemplate == NULL);
+  segBaseType = segmentTemplate->MultSegBaseType->SegBaseType;
+  assert_equals_float (segBaseType->availabilityTimeOffset, 1.5);
+
+  representation = (GstRepresentationNode *)
+      adaptationSet->Representations->next->data;
+  segmentTemplate = representation->SegmentTemplate;
+  fail_if (segmentTemplate == NULL);
+  segBaseType = segmentTemplate->MultSegBaseType->SegBaseType;
+  fail_unless (segBaseType->availabilityTimeOffset > G_MAXUINT64 / GST_SECOND);
+
+  gst_mpd_client_free (mpdclient);
+}
+
 GST_END_TEST;
 /*
  * Test parsing Period AdaptationSet SegmentTemplate attributes with
@@ -4843,6 +4896,432 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Test merging the SegmentTimeline of a live manifest update into the
+ * segments of the active stream
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_update)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstClockTime ts;
+  GstFlowReturn flow;
+  gboolean ret;
+  guint i;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\" r=\"4\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  /* the first two segments left the window and three were added */
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"3\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"4\" d=\"2\" r=\"3\"/>"
+      "            <S d=\"3\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+  GstMpdClient *update = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  /* move to segment 4, starting at 6s */
+  for (i = 0; i < 3; i++) {
+    flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+    assert_equals_int (flow, GST_FLOW_OK);
+  }
+
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_update_timelines (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  fail_unless (update->mpd_node == NULL);
+  gst_mpd_client_free (update);
+
+  /* the stream and its position are kept */
+  fail_unless (activeStream ==
+      gst_mpdparser_get_active_stream_by_index (mpdclient, 0));
+  ret = gst_mpd_client_get_next_fragment_timestamp (mpdclient, 0, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 6 * GST_SECOND);
+
+  /* segments 3 to 6 of 2s, then segment 7 of 3s */
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 3);
+  assert_equals_int (segment->repeat, 3);
+  assert_equals_uint64 (segment->start, 4 * GST_SECOND);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 7);
+  assert_equals_int (segment->repeat, 0);
+  assert_equals_uint64 (segment->start, 12 * GST_SECOND);
+  assert_equals_uint64 (segment->duration, 3 * GST_SECOND);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test merging a live manifest update that gives the start time of every S
+ * element, and that an update with numbering that doesn't match the current
+ * segments is refused
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_update_numbers)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstClockTime ts;
+  GstFlowReturn flow;
+  gboolean ret;
+  guint i;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\" r=\"4\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  /* segment 3 would have to start at 4s */
+  const gchar *xml_bad_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"3\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"2\" d=\"2\" r=\"4\"/>"
+      "            <S t=\"12\" d=\"2\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"3\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"4\" d=\"2\"/>"
+      "            <S t=\"6\" d=\"2\"/>"
+      "            <S t=\"8\" d=\"2\"/>"
+      "            <S t=\"10\" d=\"2\"/>"
+      "            <S t=\"12\" d=\"3\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+  GstMpdClient *update = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  /* move to segment 4, starting at 6s */
+  for (i = 0; i < 3; i++) {
+    flow = gst_mpd_client_advance_segment (mpdclient, activeStream, TRUE);
+    assert_equals_int (flow, GST_FLOW_OK);
+  }
+
+  ret = gst_mpd_parse (update, xml_bad_update, (gint) strlen (xml_bad_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_update_timelines (mpdclient, update);
+  assert_equals_int (ret, FALSE);
+  fail_unless (update->mpd_node != NULL);
+  gst_mpd_client_free (update);
+
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_update_timelines (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  fail_unless (update->mpd_node == NULL);
+  gst_mpd_client_free (update);
+
+  ret = gst_mpd_client_get_next_fragment_timestamp (mpdclient, 0, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 6 * GST_SECOND);
+
+  /* segments 3 to 6 of 2s, then segment 7 of 3s */
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 3);
+  assert_equals_int (segment->repeat, 3);
+  assert_equals_uint64 (segment->start, 4 * GST_SECOND);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 7);
+  assert_equals_int (segment->repeat, 0);
+  assert_equals_uint64 (segment->start, 12 * GST_SECOND);
+  assert_equals_uint64 (segment->duration, 3 * GST_SECOND);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that the S elements added by a live manifest update are folded into
+ * runs like when building the segment list
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_update_runs)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  gboolean ret;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\" r=\"4\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  /* two more segments of 2s, then two of 3s, each in its own S */
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet id=\"1\" mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\" r=\"4\"/>"
+      "            <S d=\"2\"/>"
+      "            <S d=\"2\"/>"
+      "            <S d=\"3\"/>"
+      "            <S d=\"3\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+  GstMpdClient *update = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  ret = gst_mpd_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_update_timelines (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  /* segments 1 to 7 of 2s, then segments 8 and 9 of 3s */
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 1);
+  assert_equals_int (segment->repeat, 6);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 8);
+  assert_equals_int (segment->repeat, 1);
+  assert_equals_uint64 (segment->start, 14 * GST_SECOND);
+  assert_equals_uint64 (segment->duration, 3 * GST_SECOND);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that consecutive S elements of a SegmentTemplate timeline with the
+ * same duration are folded into a single run, and seeking inside it
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_runs)
+{
+  GList *adaptationSets;
+  GstAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaSegment *segment;
+  GstClockTime ts;
+  gboolean ret;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     mediaPresentationDuration=\"P0Y0M0DT0H0M9S\">"
+      "  <Period start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" timescale=\"1\""
+      "                         startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\"/>"
+      "            <S d=\"2\"/>"
+      "            <S t=\"4\" d=\"2\"/>"
+      "            <S d=\"3\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  adapt_set = (GstAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpdparser_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  /* segments 1 to 3 of 2s, then segment 4 of 3s */
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 1);
+  assert_equals_int (segment->repeat, 2);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 4);
+  assert_equals_uint64 (segment->start, 6 * GST_SECOND);
+
+  /* snapping after 3s goes to the last segment of the run */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE,
+      GST_SEEK_FLAG_SNAP_AFTER, 3 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 4 * GST_SECOND);
+  assert_equals_int (activeStream->segment_index, 0);
+  assert_equals_int (activeStream->segment_repeat_index, 2);
+
+  /* snapping after 5s leaves the run */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE,
+      GST_SEEK_FLAG_SNAP_AFTER, 5 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 6 * GST_SECOND);
+  assert_equals_int (activeStream->segment_index, 1);
+  assert_equals_int (activeStream->segment_repeat_index, 0);
+
+  /* past the end */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      10 * GST_SECOND, &ts);
+  assert_equals_int (ret, FALSE);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -5834,6 +6313,8 @@ dash_suite (void)
       dash_mpdparser_period_adaptationSet_representationBase_framePacking);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_adapt_repr_segmentTemplate_inherit);
+  tcase_add_test (tc_simpleMPD,
+      dash_mpdparser_segmentTemplate_availabilityTimeOffset);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_period_adaptationSet_representationBase_audioChannelConfiguration);
   tcase_add_test (tc_simpleMPD,
@@ -5936,6 +6417,11 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_update);
+  tcase_add_test (tc_complexMPD,
+      dash_mpdparser_segment_timeline_update_numbers);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_runs);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_update_runs);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
@@ -24,6 +24,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/x-h264, parsed=(boolean)false"
@@ -462,6 +463,91 @@ h264parse_packetized_suite (void)
   return s;
 }
 
+static GstBuffer *
+wrap_static (guint8 * data, gsize size)
+{
+  return gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data, size,
+      0, size, NULL, NULL);
+}
+
+static GstMemory *
+find_config_memory (GstBuffer * buffer)
+{
+  guint i;
+
+  for (i = 0; i < gst_buffer_n_memory (buffer); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (gst_memory_get_sizes (mem, NULL, NULL) ==
+        sizeof (h264_sps) + sizeof (h264_pps))
+      return mem;
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_parse_config_nals_shared)
+{
+  GstHarness *h;
+  GstBuffer *buf, *buf1, *buf2;
+  GstMemory *config1, *config2;
+
+  h = gst_harness_new ("h264parse");
+  gst_harness_set (h, "h264parse", "config-interval", -1, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format = (string) byte-stream");
+  gst_harness_set_sink_caps_str (h, "video/x-h264, "
+      "stream-format = (string) byte-stream, alignment = (string) au");
+
+  /* AUDs included so none get inserted */
+  buf = wrap_static (h264_aud, sizeof (h264_aud));
+  buf = gst_buffer_append (buf, wrap_static (h264_sps, sizeof (h264_sps)));
+  buf = gst_buffer_append (buf, wrap_static (h264_pps, sizeof (h264_pps)));
+  buf = gst_buffer_append (buf, wrap_static (h264_idrframe,
+          sizeof (h264_idrframe)));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  buf = wrap_static (h264_aud, sizeof (h264_aud));
+  buf = gst_buffer_append (buf, wrap_static (h264_idrframe,
+          sizeof (h264_idrframe)));
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  buf1 = gst_harness_pull (h);
+  buf2 = gst_harness_pull (h);
+
+  /* parameter sets are inserted before the second IDR as well */
+  fail_unless_equals_int (gst_buffer_get_size (buf2), sizeof (h264_aud) +
+      sizeof (h264_sps) + sizeof (h264_pps) + sizeof (h264_idrframe));
+  fail_unless (gst_buffer_memcmp (buf2, sizeof (h264_aud), h264_sps,
+          sizeof (h264_sps)) == 0);
+  fail_unless (gst_buffer_memcmp (buf2, sizeof (h264_aud) + sizeof (h264_sps),
+          h264_pps, sizeof (h264_pps)) == 0);
+
+  /* and the unchanged parameter sets are not rebuilt in between */
+  config1 = find_config_memory (buf1);
+  config2 = find_config_memory (buf2);
+  fail_unless (config1 != NULL);
+  fail_unless (config1 == config2);
+
+  gst_buffer_unref (buf1);
+  gst_buffer_unref (buf2);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264parse_config_suite (void)
+{
+  Suite *s = suite_create (ctx_suite);
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_config_nals_shared);
+
+  return s;
+}
 
 /*
  * TODO:
@@ -560,5 +646,9 @@ main (int argc, char **argv)
   s = h264parse_packetized_suite ();
   nf += gst_check_run_suite (s, ctx_suite, __FILE__ "_packetized.c");
 
+  ctx_suite = "h264parse_config";
+  s = h264parse_config_suite ();
+  nf += gst_check_run_suite (s, ctx_suite, __FILE__ "_config.c");
+
   return nf;
 }
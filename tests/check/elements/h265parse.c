@@ -0,0 +1,255 @@
+/* GStreamer
+ *
+ * unit test for h265parse
+ *
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* 64x64 Main profile parameter sets */
+static const guint8 h265_vps[] = {
+  0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x3c, 0xf0, 0x24
+};
+
+static const guint8 h265_sps[] = {
+  0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x3c, 0xa0, 0x20, 0x81, 0x05, 0x96, 0xba,
+  0xbc, 0x20, 0x80
+};
+
+static const guint8 h265_pps[] = {
+  0x44, 0x01, 0xc0, 0x71, 0x80, 0x12
+};
+
+/* access unit delimiter */
+static const guint8 h265_aud[] = {
+  0x46, 0x01, 0x50
+};
+
+/* slice segment headers, the slice data is appended by make_stream() */
+static const guint8 h265_idr_first_slice[] = {
+  0x26, 0x01, 0xaf
+};
+
+static const guint8 h265_idr_second_slice[] = {
+  0x26, 0x01, 0x30, 0xf0
+};
+
+static const guint8 h265_p_slice[] = {
+  0x02, 0x01, 0xd0, 0x09, 0x77
+};
+
+#define N_PICTURES 12
+
+/* slice data sizes, several of them larger than the chunks the start code
+ * scanner hands to its helper threads */
+static const gsize slice_sizes[] = {
+  700 * 1024 + 13, 17, 300 * 1024 + 1, 5, 1100 * 1024 + 7, 64 * 1024
+};
+
+/* sizes of the buffers the stream is pushed in, small ones make buffers end
+ * within start codes */
+static const gsize push_sizes[] = {
+  1, 2, 4093, 65543, 300007, 1000003, 3
+};
+
+static void
+append_nal (GByteArray * stream, const guint8 * nal, gsize size,
+    gboolean long_start_code)
+{
+  static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+
+  if (long_start_code)
+    g_byte_array_append (stream, start_code, 4);
+  else
+    g_byte_array_append (stream, start_code + 1, 3);
+  g_byte_array_append (stream, nal, size);
+}
+
+/* appends a slice NAL with slice data that has no start codes, but does
+ * have emulation prevention bytes now and then */
+static void
+append_slice (GByteArray * stream, GRand * rand, const guint8 * header,
+    gsize header_size, gsize size)
+{
+  static const guint8 escaped_zeros[] = { 0x00, 0x00, 0x03, 0x00 };
+  gsize i;
+
+  append_nal (stream, header, header_size, FALSE);
+  for (i = 0; i < size; i++) {
+    guint8 byte = g_rand_int_range (rand, 1, 256);
+
+    if (i % 4099 == 4098)
+      g_byte_array_append (stream, escaped_zeros, sizeof (escaped_zeros));
+    g_byte_array_append (stream, &byte, 1);
+  }
+}
+
+static GBytes *
+make_stream (void)
+{
+  static const guint8 garbage[] = { 0x12, 0x34, 0x00, 0x56 };
+  static const guint8 trailing_zeros[] = { 0x00, 0x00 };
+  GByteArray *stream = g_byte_array_new ();
+  GRand *rand = g_rand_new_with_seed (265);
+  guint i, n_slices = 0;
+
+  /* skipped: garbage, then a NAL ahead of the parameter sets */
+  g_byte_array_append (stream, garbage, sizeof (garbage));
+  append_nal (stream, h265_aud, sizeof (h265_aud), FALSE);
+
+  append_nal (stream, h265_vps, sizeof (h265_vps), TRUE);
+  append_nal (stream, h265_sps, sizeof (h265_sps), TRUE);
+  append_nal (stream, h265_pps, sizeof (h265_pps), TRUE);
+
+  for (i = 0; i < N_PICTURES; i++) {
+    append_nal (stream, h265_aud, sizeof (h265_aud), i % 2 == 0);
+
+    if (i % 4 == 0) {
+      append_slice (stream, rand, h265_idr_first_slice,
+          sizeof (h265_idr_first_slice),
+          slice_sizes[n_slices++ % G_N_ELEMENTS (slice_sizes)]);
+      append_slice (stream, rand, h265_idr_second_slice,
+          sizeof (h265_idr_second_slice),
+          slice_sizes[n_slices++ % G_N_ELEMENTS (slice_sizes)]);
+    } else {
+      append_slice (stream, rand, h265_p_slice, sizeof (h265_p_slice),
+          slice_sizes[n_slices++ % G_N_ELEMENTS (slice_sizes)]);
+    }
+
+    if (i % 3 == 0)
+      g_byte_array_append (stream, trailing_zeros, sizeof (trailing_zeros));
+  }
+
+  g_rand_free (rand);
+
+  return g_byte_array_free_to_bytes (stream);
+}
+
+/* returns the output buffers, in order */
+static GList *
+parse_stream (GBytes * stream, guint scan_threads, const gchar * alignment)
+{
+  GstElement *parse;
+  GstHarness *h;
+  GList *buffers = NULL;
+  GstBuffer *buf;
+  gchar *caps;
+  gsize size, offset = 0;
+  guint i = 0;
+
+  parse = gst_element_factory_make ("h265parse", NULL);
+  fail_unless (parse != NULL);
+  g_object_set (parse, "scan-threads", scan_threads, NULL);
+
+  h = gst_harness_new_with_element (parse, "sink", "src");
+  gst_object_unref (parse);
+
+  caps = g_strdup_printf ("video/x-h265, stream-format=(string)byte-stream, "
+      "alignment=(string)%s", alignment);
+  gst_harness_set_sink_caps_str (h, caps);
+  g_free (caps);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h265, stream-format=(string)byte-stream");
+
+  size = g_bytes_get_size (stream);
+  while (offset < size) {
+    gsize len = MIN (push_sizes[i++ % G_N_ELEMENTS (push_sizes)],
+        size - offset);
+
+    buf = gst_buffer_new_allocate (NULL, len, NULL);
+    gst_buffer_fill (buf, 0, (const guint8 *) g_bytes_get_data (stream,
+            NULL) + offset, len);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+    offset += len;
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  while ((buf = gst_harness_try_pull (h)))
+    buffers = g_list_prepend (buffers, buf);
+
+  gst_harness_teardown (h);
+
+  return g_list_reverse (buffers);
+}
+
+static void
+check_same_output (const gchar * alignment, guint n_expected)
+{
+  GBytes *stream = make_stream ();
+  GList *single, *threaded, *l, *m;
+
+  single = parse_stream (stream, 1, alignment);
+  threaded = parse_stream (stream, 4, alignment);
+
+  fail_unless_equals_int (g_list_length (single), n_expected);
+  fail_unless_equals_int (g_list_length (threaded), n_expected);
+
+  for (l = single, m = threaded; l && m; l = l->next, m = m->next) {
+    GstBuffer *a = l->data, *b = m->data;
+    GstMapInfo map_a, map_b;
+
+    fail_unless_equals_int (gst_buffer_get_size (a), gst_buffer_get_size (b));
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (a,
+            GST_BUFFER_FLAG_DELTA_UNIT), GST_BUFFER_FLAG_IS_SET (b,
+            GST_BUFFER_FLAG_DELTA_UNIT));
+
+    gst_buffer_map (a, &map_a, GST_MAP_READ);
+    gst_buffer_map (b, &map_b, GST_MAP_READ);
+    fail_unless (memcmp (map_a.data, map_b.data, map_a.size) == 0);
+    gst_buffer_unmap (b, &map_b);
+    gst_buffer_unmap (a, &map_a);
+  }
+
+  g_list_free_full (single, (GDestroyNotify) gst_buffer_unref);
+  g_list_free_full (threaded, (GDestroyNotify) gst_buffer_unref);
+  g_bytes_unref (stream);
+}
+
+GST_START_TEST (test_scan_threads_au)
+{
+  check_same_output ("au", N_PICTURES);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_scan_threads_nal)
+{
+  /* parameter sets, then a delimiter and the slices of each picture */
+  check_same_output ("nal", 3 + N_PICTURES + N_PICTURES + N_PICTURES / 4);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parse_suite (void)
+{
+  Suite *s = suite_create ("h265parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_scan_threads_au);
+  tcase_add_test (tc_chain, test_scan_threads_nal);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parse);
@@ -52,6 +52,9 @@ typedef struct _GstHlsDemuxTestSelectBitrateContext
   gulong signal_handle;
 } GstHlsDemuxTestSelectBitrateContext;
 
+static GMutex requests_lock;
+static GCond requests_cond;
+
 static GByteArray *
 generate_transport_stream (guint length)
 {
@@ -158,6 +161,8 @@ gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
     output->response_headers = gst_structure_new ("response-headers",
         "Content-Type", G_TYPE_STRING, "video/mp2t", NULL);
   }
+  /* fragments can be requested from several threads at once */
+  g_mutex_lock (&requests_lock);
   if (gst_structure_has_field (test_case->state, "requests")) {
     GstHlsDemuxTestAppendUriContext context =
         { g_quark_from_string ("requests"), input->uri };
@@ -174,6 +179,8 @@ gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
     g_value_unset (&uri_val);
     g_value_unset (&requests);
   }
+  g_cond_broadcast (&requests_cond);
+  g_mutex_unlock (&requests_lock);
 }
 
 static gboolean
@@ -348,6 +355,126 @@ GST_START_TEST (testMasterPlaylist)
 
 GST_END_TEST;
 
+static void
+testPrefetchPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-depth", 2, NULL);
+}
+
+/* must be called with requests_lock taken */
+static gboolean
+has_request (const GstHlsDemuxTestCase * test_case, const gchar * uri)
+{
+  const GValue *requests;
+  guint i;
+
+  requests = gst_structure_get_value (test_case->state, "requests");
+  if (requests == NULL)
+    return FALSE;
+
+  for (i = 0; i < gst_value_array_get_size (requests); ++i) {
+    const GValue *request = gst_value_array_get_value (requests, i);
+
+    if (g_strcmp0 (uri, g_value_get_string (request)) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* serves each fragment only once the one after it has been requested, so
+ * that its data can't reach the appsink before that */
+static GstFlowReturn
+testPrefetchSrcCreate (GstTestHTTPSrc * src, guint64 offset, guint length,
+    GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstHlsDemuxTestCase *test_case = (GstHlsDemuxTestCase *) user_data;
+  GstHlsDemuxTestInputData *input = (GstHlsDemuxTestInputData *) context;
+  const gchar *next_uri = input[1].uri;
+
+  if (offset == 0 && next_uri && g_str_has_suffix (next_uri, ".ts")) {
+    gint64 end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+    g_mutex_lock (&requests_lock);
+    while (!has_request (test_case, next_uri)) {
+      if (!g_cond_wait_until (&requests_cond, &requests_lock, end_time)) {
+        if (!has_request (test_case, next_uri))
+          gst_structure_set (test_case->state, "late-request", G_TYPE_STRING,
+              next_uri, NULL);
+        break;
+      }
+    }
+    g_mutex_unlock (&requests_lock);
+  }
+
+  return gst_hlsdemux_test_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+/*
+ * Test downloading the upcoming fragments ahead of time
+ *
+ */
+GST_START_TEST (testPrefetch)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 3 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  guint i, j;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = testPrefetchSrcCreate;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* the fragments are requested in parallel, but each of them only once */
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  assert_equals_uint64 (gst_value_array_get_size (requests),
+      sizeof (inputTestData) / sizeof (inputTestData[0]) - 1);
+  for (i = 0; inputTestData[i].uri; ++i) {
+    guint count = 0;
+
+    for (j = 0; j < gst_value_array_get_size (requests); ++j) {
+      const GValue *uri = gst_value_array_get_value (requests, j);
+
+      if (g_strcmp0 (inputTestData[i].uri, g_value_get_string (uri)) == 0)
+        count++;
+    }
+    assert_equals_uint64 (count, 1);
+  }
+
+  /* each fragment was requested before the previous one was consumed */
+  fail_if (gst_structure_has_field (hlsTestCase.state, "late-request"),
+      "%s was only requested after the fragment before it was consumed",
+      gst_structure_get_string (hlsTestCase.state, "late-request"));
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 /*
  * Test seeking
  *
@@ -732,6 +859,7 @@ hls_demux_suite (void)
 
   tcase_add_test (tc_basicTest, simpleTest);
   tcase_add_test (tc_basicTest, testMasterPlaylist);
+  tcase_add_test (tc_basicTest, testPrefetch);
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
@@ -353,7 +353,7 @@ GST_START_TEST (test_load_main_playlist_rendition)
   master = load_playlist (ON_DEMAND_PLAYLIST);
   variant = master->default_variant;
 
-  assert_equals_int (g_list_length (variant->m3u8->files), 4);
+  assert_equals_int (variant->m3u8->files->len, 4);
   assert_equals_int (master->version, 0);
 
   gst_hls_master_playlist_unref (master);
@@ -463,13 +463,14 @@ check_on_demand_playlist (const gchar * data)
   /* Check that we are not live */
   assert_equals_int (gst_m3u8_is_live (pl), FALSE);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/004.ts");
   assert_equals_int (file->sequence, 3);
 
@@ -519,14 +520,15 @@ GST_START_TEST (test_live_playlist)
   assert_equals_int (gst_m3u8_is_live (pl), TRUE);
   assert_equals_int (pl->sequence, 2680);
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2680.ts");
   assert_equals_int (file->sequence, 2680);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri,
       "https://priv.example.com/fileSequence2683.ts");
   assert_equals_int (file->sequence, 2683);
@@ -554,7 +556,7 @@ GST_START_TEST (test_live_playlist_rotated)
 
   assert_equals_int (pl->sequence, 2680);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 2680);
 
   ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
@@ -566,7 +568,7 @@ GST_START_TEST (test_live_playlist_rotated)
   /* FIXME: Sequence should last - 3. Should it? */
   assert_equals_int (pl->sequence, 3001);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_int (file->sequence, 3001);
 
   gst_hls_master_playlist_unref (master);
@@ -586,13 +588,13 @@ GST_START_TEST (test_playlist_with_doubles_duration)
   pl = master->default_variant->m3u8;
 
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.321);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.6789);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   assert_equals_float (file->duration / (double) GST_SECOND, 10.2344);
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   assert_equals_float (file->duration / (double) GST_SECOND, 9.92);
   fail_unless (gst_m3u8_get_seek_range (pl, &start, &stop));
   assert_equals_int64 (start, 0);
@@ -604,6 +606,32 @@ GST_START_TEST (test_playlist_with_doubles_duration)
 
 GST_END_TEST;
 
+GST_START_TEST (test_find_file_for_time)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file0, *file1;
+  GstM3U8 *pl;
+
+  master = load_playlist (DOUBLES_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  file0 = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
+  file1 = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
+  assert_equals_uint64 (gst_m3u8_get_file_start (pl, 0), 0);
+  assert_equals_uint64 (gst_m3u8_get_file_start (pl, 2),
+      file0->duration + file1->duration);
+
+  assert_equals_int (gst_m3u8_find_file_for_time (pl, 0), 0);
+  assert_equals_int (gst_m3u8_find_file_for_time (pl, file0->duration - 1), 0);
+  assert_equals_int (gst_m3u8_find_file_for_time (pl, file0->duration), 1);
+  assert_equals_int (gst_m3u8_find_file_for_time (pl, 25 * GST_SECOND), 2);
+  assert_equals_int (gst_m3u8_find_file_for_time (pl, 60 * GST_SECOND), 4);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_playlist_with_encryption)
 {
   GstHLSMasterPlaylist *master;
@@ -618,26 +646,26 @@ GST_START_TEST (test_playlist_with_encryption)
   master = load_playlist (AES_128_ENCRYPTED_PLAYLIST);
   pl = master->default_variant->m3u8;
 
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
 
   /* Check all media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 0));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 1));
   fail_unless (file->key == NULL);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 2));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key.bin");
   fail_unless (memcmp (&file->iv, iv2, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 3));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 3));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
 
-  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 4));
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 4));
   fail_unless (file->key != NULL);
   assert_equals_string (file->key, "https://priv.example.com/key2.bin");
   fail_unless (memcmp (&file->iv, iv1, 16) == 0);
@@ -657,7 +685,7 @@ GST_START_TEST (test_update_invalid_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup ("#INVALID"));
   assert_equals_int (ret, FALSE);
 
@@ -676,26 +704,90 @@ GST_START_TEST (test_update_playlist)
   /* Test updates in on-demand playlists */
   master = load_playlist (ON_DEMAND_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   ret = gst_m3u8_update (pl, g_strdup (ON_DEMAND_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   gst_hls_master_playlist_unref (master);
 
   /* Test updates in live playlists */
   master = load_playlist (LIVE_PLAYLIST);
   pl = master->default_variant->m3u8;
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Add a new entry to the playlist and check the update */
   live_pl = g_strdup_printf ("%s\n%s\n%s", LIVE_PLAYLIST, "#EXTINF:8",
       "https://priv.example.com/fileSequence2683.ts");
   ret = gst_m3u8_update (pl, live_pl);
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 5);
+  assert_equals_int (pl->files->len, 5);
   /* Test sliding window */
   ret = gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST));
   assert_equals_int (ret, TRUE);
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_update_playlist_incremental)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8MediaFile *file;
+  GstM3U8 *pl;
+  gboolean ret;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+  assert_equals_int (pl->files->len, 4);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 2));
+
+  /* The first two files leave the window and two new ones are added, the
+   * files that are still listed are kept as they are */
+  ret = gst_m3u8_update (pl, g_strdup ("#EXTM3U\n\
+#EXT-X-TARGETDURATION:8\n\
+#EXT-X-MEDIA-SEQUENCE:2682\n\
+\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2682.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2683.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2684.ts\n\
+#EXTINF:7,\n\
+https://priv.example.com/fileSequence2685.ts"));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (pl->files->len, 4);
+  fail_unless (g_ptr_array_index (pl->files, 0) == file);
+  assert_equals_int (file->sequence, 2682);
+
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
+  assert_equals_int (file->sequence, 2685);
+  assert_equals_string (file->uri,
+      "https://priv.example.com/fileSequence2685.ts");
+  assert_equals_uint64 (file->duration, 7 * GST_SECOND);
+  assert_equals_uint64 (pl->duration, 31 * GST_SECOND);
+
+  /* A relative URI that ends like the one of a known file but resolves
+   * to another one is not that file, so its sequence is inconsistent */
+  ret = gst_m3u8_update (pl, g_strdup ("#EXTM3U\n\
+#EXT-X-TARGETDURATION:8\n\
+#EXT-X-MEDIA-SEQUENCE:2683\n\
+\n\
+#EXTINF:8,\n\
+fileSequence2683.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2684.ts\n\
+#EXTINF:7,\n\
+https://priv.example.com/fileSequence2685.ts"));
+  assert_equals_int (ret, FALSE);
+
+  /* A playlist that doesn't line up with the known files is parsed again */
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_ROTATED_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
+  assert_equals_int (file->sequence, 3001);
+
   gst_hls_master_playlist_unref (master);
 }
 
@@ -711,9 +803,9 @@ GST_START_TEST (test_playlist_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/001.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -736,16 +828,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 100);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -759,16 +852,17 @@ GST_START_TEST (test_playlist_byte_range_media_files)
   pl = master->default_variant->m3u8;
 
   /* Check number of entries */
-  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files->len, 4);
   /* Check first media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files, 0));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 0);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
   assert_equals_int (file->offset, 0);
   assert_equals_int (file->size, 1000);
   /* Check last media segments */
-  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  file = GST_M3U8_MEDIA_FILE (g_ptr_array_index (pl->files,
+          pl->files->len - 1));
   assert_equals_string (file->uri, "http://media.example.com/all.ts");
   assert_equals_int (file->sequence, 3);
   assert_equals_float (file->duration, 10 * (double) GST_SECOND);
@@ -1418,9 +1512,11 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_live_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist_rotated);
   tcase_add_test (tc_m3u8, test_playlist_with_doubles_duration);
+  tcase_add_test (tc_m3u8, test_find_file_for_time);
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
   tcase_add_test (tc_m3u8, test_update_playlist);
+  tcase_add_test (tc_m3u8, test_update_playlist_incremental);
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
@@ -23,6 +23,8 @@
 #include <unistd.h>
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/codecparsers/gstjpegrestartmeta.h>
 
 /* This test doesn't use actual JPEG data, but some fake data that we know
    will trigger certain paths in jpegparse. */
@@ -150,6 +152,22 @@ guint8 test_data_sof0[] = {
 
 guint8 test_data_eoi[] = { 0xff, 0xd9 };
 
+guint8 test_data_dri[] = {
+  0xff, 0xdd,
+  0x00, 0x04,                   /* size */
+  0x00, 0x02,                   /* restart interval */
+};
+
+/* scan with two restart markers, last entropy byte followed by EOI */
+guint8 test_data_restart_scan[] = {
+  0xff, 0xda, 0x00, 0x04, 0x22, 0x33,
+  0x11, 0xff, 0x00, 0x22,
+  0xff, 0xd0,
+  0x33,
+  0xff, 0xd1,
+  0x44
+};
+
 static GList *
 _make_buffers_in (GList * buffer_in, guint8 * test_data, gsize test_data_size)
 {
@@ -367,6 +385,50 @@ GST_START_TEST (test_parse_comment)
 
 GST_END_TEST;
 
+GST_START_TEST (test_parse_restart_meta)
+{
+  GstJpegRestartMeta *meta;
+  GstBuffer *buffer;
+  GstHarness *h;
+  gsize offset = 0;
+
+  buffer = gst_buffer_new_and_alloc (sizeof (test_data_soi) +
+      sizeof (test_data_dri) + sizeof (test_data_sof0) +
+      sizeof (test_data_restart_scan) + sizeof (test_data_eoi));
+  offset += gst_buffer_fill (buffer, offset, test_data_soi,
+      sizeof (test_data_soi));
+  offset += gst_buffer_fill (buffer, offset, test_data_dri,
+      sizeof (test_data_dri));
+  offset += gst_buffer_fill (buffer, offset, test_data_sof0,
+      sizeof (test_data_sof0));
+  offset += gst_buffer_fill (buffer, offset, test_data_restart_scan,
+      sizeof (test_data_restart_scan));
+  gst_buffer_fill (buffer, offset, test_data_eoi, sizeof (test_data_eoi));
+
+  h = gst_harness_new ("jpegparse");
+  g_object_set (h->element, "restart-meta", TRUE, NULL);
+  gst_harness_set_src_caps_str (h, "image/jpeg");
+
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  buffer = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 45);
+
+  meta = gst_buffer_get_jpeg_restart_meta (buffer);
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->restart_interval, 2);
+  fail_unless_equals_int (meta->scan_offset, 33);
+  fail_unless_equals_int (meta->n_restarts, 2);
+  fail_unless_equals_int (meta->restart_offsets[0], 37);
+  fail_unless_equals_int (meta->restart_offsets[1], 40);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 jpegparse_suite (void)
 {
@@ -378,6 +440,7 @@ jpegparse_suite (void)
   tcase_add_test (tc_chain, test_parse_all_in_one_buf);
   tcase_add_test (tc_chain, test_parse_app1_exif);
   tcase_add_test (tc_chain, test_parse_comment);
+  tcase_add_test (tc_chain, test_parse_restart_meta);
 
   return s;
 }
@@ -24,6 +24,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/mpeg, mpegversion=(int)4, systemstream=(boolean)false, parsed=(boolean)false"
@@ -59,6 +60,13 @@ static guint8 mpeg4_iframe[] = {
   0x1b, 0x6d, 0xfb
 };
 
+/* same as above, but coded as a P-VOP */
+static guint8 mpeg4_pframe[] = {
+  0x00, 0x00, 0x01, 0xb6, 0x50, 0x60, 0x91, 0x82,
+  0x3d, 0xb7, 0xf1, 0xb6, 0xdf, 0xc6, 0xdb, 0x7f,
+  0x1b, 0x6d, 0xfb
+};
+
 static gboolean
 verify_buffer (buffer_verify_data_s * vdata, GstBuffer * buffer)
 {
@@ -150,6 +158,125 @@ GST_START_TEST (test_parse_detect_stream)
 GST_END_TEST;
 
 
+static GstHarness *
+setup_gop_harness (const gchar * property)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("mpeg4videoparse");
+  g_object_set (h->element, property, TRUE, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/mpeg, mpegversion=(int)4, systemstream=(boolean)false");
+
+  return h;
+}
+
+/* pushes the config up to and including the GOV, an I-VOP and a P-VOP */
+static void
+push_gop_stream (GstHarness * h)
+{
+  GstBuffer *buf;
+  gsize offset = 0;
+
+  buf = gst_buffer_new_and_alloc (sizeof (mpeg4_config) +
+      sizeof (mpeg4_iframe) + sizeof (mpeg4_pframe));
+  offset += gst_buffer_fill (buf, offset, mpeg4_config, sizeof (mpeg4_config));
+  offset += gst_buffer_fill (buf, offset, mpeg4_iframe, sizeof (mpeg4_iframe));
+  gst_buffer_fill (buf, offset, mpeg4_pframe, sizeof (mpeg4_pframe));
+
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+}
+
+/* whether the gop-index message was on the bus when EOS left the parser */
+static gboolean gop_index_before_eos;
+
+static GstPadProbeReturn
+gop_index_eos_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBus *bus = user_data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS)
+    gop_index_before_eos = gst_bus_have_pending (bus);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_parse_gop_index)
+{
+  GstHarness *h = setup_gop_harness ("gop-index");
+  const GstStructure *s;
+  const GValue *offsets;
+  GstMessage *msg;
+  gboolean closed;
+  guint64 offset;
+  GstPad *srcpad;
+  GstBus *bus;
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (h->element, bus);
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  gop_index_before_eos = FALSE;
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      gop_index_eos_probe, bus, NULL);
+  gst_object_unref (srcpad);
+
+  push_gop_stream (h);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  /* an application stopping at EOS still gets the final group of VOPs */
+  fail_unless (gop_index_before_eos);
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "gop-index"));
+  /* the GOV is the last 7 bytes of the config */
+  fail_unless (gst_structure_get_uint64 (s, "offset", &offset));
+  fail_unless_equals_uint64 (offset, sizeof (mpeg4_config) - 7);
+  fail_unless (gst_structure_get_boolean (s, "closed", &closed));
+  fail_unless (closed);
+  fail_unless_equals_string (gst_structure_get_string (s, "picture-types"),
+      "IP");
+  offsets = gst_structure_get_value (s, "picture-offsets");
+  fail_unless_equals_int (gst_value_array_get_size (offsets), 2);
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (offsets, 0)), sizeof (mpeg4_config));
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (offsets, 1)), sizeof (mpeg4_config) + sizeof (mpeg4_iframe));
+  gst_message_unref (msg);
+
+  /* nothing started a new group of VOPs, so the only one was posted when
+   * draining completed it */
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) == NULL);
+
+  gst_element_set_bus (h->element, NULL);
+  gst_object_unref (bus);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_key_units_only)
+{
+  GstHarness *h = setup_gop_harness ("key-units-only");
+  GstBuffer *buf;
+
+  push_gop_stream (h);
+
+  /* the P-VOP was dropped */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  buf = gst_harness_pull (h);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  fail_unless_equals_int (gst_buffer_get_size (buf),
+      sizeof (mpeg4_config) + sizeof (mpeg4_iframe));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+
 static Suite *
 mpeg4videoparse_suite (void)
 {
@@ -171,6 +298,8 @@ mpeg4videoparse_suite (void)
   tcase_add_test (tc_chain, test_parse_drain_single);
   tcase_add_test (tc_chain, test_parse_split);
   tcase_add_test (tc_chain, test_parse_detect_stream);
+  tcase_add_test (tc_chain, test_parse_gop_index);
+  tcase_add_test (tc_chain, test_parse_key_units_only);
 
   return s;
 }
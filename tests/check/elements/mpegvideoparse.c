@@ -24,6 +24,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/mpeg, mpegversion=(int)2, systemstream=(boolean)false, parsed=(boolean)false"
@@ -68,6 +69,16 @@ static guint8 mpeg2_iframe[] = {
   0x8b, 0x94, 0xa5, 0x22, 0x20
 };
 
+/* same as above, but a P picture with temporal reference 1 */
+static guint8 mpeg2_pframe[] = {
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x57, 0xff, 0xf8,
+  0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x41,
+  0x80, 0x00, 0x00, 0x01, 0x01, 0x23, 0xf8, 0x7d,
+  0x29, 0x48, 0x8b, 0x94, 0xa5, 0x22, 0x20, 0x00,
+  0x00, 0x01, 0x02, 0x23, 0xf8, 0x7d, 0x29, 0x48,
+  0x8b, 0x94, 0xa5, 0x22, 0x20
+};
+
 static guint8 mpeg1_iframe[] = {
   0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8,
   0x00, 0x00, 0x01, 0x01, 0x23, 0xf8, 0x7d,
@@ -234,6 +245,124 @@ GST_START_TEST (test_parse_gop_split)
 GST_END_TEST;
 
 
+static GstHarness *
+setup_gop_harness (const gchar * property)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("mpegvideoparse");
+  g_object_set (h->element, property, TRUE, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/mpeg, mpegversion=(int)2, systemstream=(boolean)false");
+
+  return h;
+}
+
+/* pushes sequence + GOP, an I picture and a P picture */
+static void
+push_gop_stream (GstHarness * h)
+{
+  GstBuffer *buf;
+  gsize offset = 0;
+
+  buf = gst_buffer_new_and_alloc (sizeof (mpeg2_seq) + sizeof (mpeg2_iframe) +
+      sizeof (mpeg2_pframe));
+  offset += gst_buffer_fill (buf, offset, mpeg2_seq, sizeof (mpeg2_seq));
+  offset += gst_buffer_fill (buf, offset, mpeg2_iframe, sizeof (mpeg2_iframe));
+  gst_buffer_fill (buf, offset, mpeg2_pframe, sizeof (mpeg2_pframe));
+
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+}
+
+/* whether the gop-index message was on the bus when EOS left the parser */
+static gboolean gop_index_before_eos;
+
+static GstPadProbeReturn
+gop_index_eos_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBus *bus = user_data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS)
+    gop_index_before_eos = gst_bus_have_pending (bus);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_parse_gop_index)
+{
+  GstHarness *h = setup_gop_harness ("gop-index");
+  const GstStructure *s;
+  const GValue *offsets;
+  GstMessage *msg;
+  gboolean closed;
+  guint64 offset;
+  GstPad *srcpad;
+  GstBus *bus;
+
+  bus = gst_bus_new ();
+  gst_element_set_bus (h->element, bus);
+  srcpad = gst_element_get_static_pad (h->element, "src");
+  gop_index_before_eos = FALSE;
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      gop_index_eos_probe, bus, NULL);
+  gst_object_unref (srcpad);
+
+  push_gop_stream (h);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+  /* an application stopping at EOS still gets the final GOP */
+  fail_unless (gop_index_before_eos);
+
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  fail_unless (msg != NULL);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "gop-index"));
+  fail_unless (gst_structure_get_uint64 (s, "offset", &offset));
+  fail_unless_equals_uint64 (offset, 22);
+  fail_unless (gst_structure_get_boolean (s, "closed", &closed));
+  fail_if (closed);
+  fail_unless_equals_string (gst_structure_get_string (s, "picture-types"),
+      "IP");
+  offsets = gst_structure_get_value (s, "picture-offsets");
+  fail_unless_equals_int (gst_value_array_get_size (offsets), 2);
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (offsets, 0)), sizeof (mpeg2_seq));
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (offsets, 1)), sizeof (mpeg2_seq) + sizeof (mpeg2_iframe));
+  gst_message_unref (msg);
+
+  /* nothing started a new GOP, so the only one was posted when draining
+   * completed it */
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) == NULL);
+
+  gst_element_set_bus (h->element, NULL);
+  gst_object_unref (bus);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_key_units_only)
+{
+  GstHarness *h = setup_gop_harness ("key-units-only");
+  GstBuffer *buf;
+
+  push_gop_stream (h);
+
+  /* the P picture was dropped */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  buf = gst_harness_pull (h);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  fail_unless_equals_int (gst_buffer_get_size (buf),
+      sizeof (mpeg2_seq) + sizeof (mpeg2_iframe));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+
 static Suite *
 mpegvideoparse_suite (void)
 {
@@ -257,6 +386,8 @@ mpegvideoparse_suite (void)
   tcase_add_test (tc_chain, test_parse_detect_stream_mpeg1);
   tcase_add_test (tc_chain, test_parse_detect_stream_mpeg2);
   tcase_add_test (tc_chain, test_parse_gop_split);
+  tcase_add_test (tc_chain, test_parse_gop_index);
+  tcase_add_test (tc_chain, test_parse_key_units_only);
 
   return s;
 }
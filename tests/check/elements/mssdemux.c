@@ -22,6 +22,13 @@
 #include <gst/check/gstcheck.h>
 #include "adaptive_demux_common.h"
 
+#include "../../ext/smoothstreaming/gstmssmanifest.c"
+#undef GST_CAT_DEFAULT
+#include "../../ext/smoothstreaming/gstmssfragmentparser.c"
+#undef GST_CAT_DEFAULT
+
+GST_DEBUG_CATEGORY (mssdemux_debug);
+
 #define DEMUX_ELEMENT_NAME "mssdemux"
 
 #define COPY_OUTPUT_TEST_DATA(outputTestData,testData) do { \
@@ -604,12 +611,148 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+static GstMssManifest *
+manifest_new_from_string (const gchar * xml)
+{
+  GstBuffer *buf;
+  GstMssManifest *manifest;
+
+  buf = gst_buffer_new_wrapped (g_strdup (xml), strlen (xml));
+  manifest = gst_mss_manifest_new (buf);
+  gst_buffer_unref (buf);
+  fail_unless (manifest != NULL);
+
+  return manifest;
+}
+
+/*
+ * Test that reloading a live manifest keeps the position: the runs that
+ * left the DVR window are dropped and the new ones are appended
+ *
+ */
+GST_START_TEST (testManifestReloadMerge)
+{
+  const gchar *manifest_xml =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<SmoothStreamingMedia MajorVersion=\"2\" MinorVersion=\"0\" Duration=\"0\" IsLive=\"TRUE\">"
+      "<StreamIndex Type=\"audio\" Language=\"eng\" QualityLevels=\"1\" Url=\"QualityLevels({bitrate})/Fragments(audio_eng={start time})\">"
+      "<QualityLevel Index=\"0\" Bitrate=\"200029\" FourCC=\"AACL\" SamplingRate=\"48000\" Channels=\"2\" BitsPerSample=\"16\" PacketSize=\"4\" AudioTag=\"255\" CodecPrivateData=\"1190\" />"
+      "<c t=\"0\" d=\"10000000\" />"
+      "<c d=\"10000000\" />"
+      "<c d=\"10000000\" />"
+      "<c d=\"10000000\" />" "</StreamIndex>" "</SmoothStreamingMedia>";
+  /* the first two fragments left the window and three new ones, then a
+   * shorter one, were added */
+  const gchar *reload_xml =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<SmoothStreamingMedia MajorVersion=\"2\" MinorVersion=\"0\" Duration=\"0\" IsLive=\"TRUE\">"
+      "<StreamIndex Type=\"audio\" Language=\"eng\" QualityLevels=\"1\" Url=\"QualityLevels({bitrate})/Fragments(audio_eng={start time})\">"
+      "<QualityLevel Index=\"0\" Bitrate=\"200029\" FourCC=\"AACL\" SamplingRate=\"48000\" Channels=\"2\" BitsPerSample=\"16\" PacketSize=\"4\" AudioTag=\"255\" CodecPrivateData=\"1190\" />"
+      "<c t=\"20000000\" d=\"10000000\" r=\"5\" />"
+      "<c d=\"5000000\" />" "</StreamIndex>" "</SmoothStreamingMedia>";
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+  GstBuffer *buf;
+  gchar *url;
+  guint n_fragments;
+
+  manifest = manifest_new_from_string (manifest_xml);
+  fail_unless (gst_mss_manifest_is_live (manifest));
+  stream = gst_mss_manifest_get_streams (manifest)->data;
+  gst_mss_stream_set_active (stream, TRUE);
+
+  fail_unless_equals_int (gst_mss_stream_advance_fragment (stream),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_mss_stream_advance_fragment (stream),
+      GST_FLOW_OK);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+      (stream), 2 * GST_SECOND);
+
+  buf = gst_buffer_new_wrapped (g_strdup (reload_xml), strlen (reload_xml));
+  gst_mss_manifest_reload_fragments (manifest, buf);
+  gst_buffer_unref (buf);
+
+  /* [2s] [3s] [4s x3] [7s] */
+  fail_unless_equals_int (stream->fragments->len, 4);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment (stream, 0)->time,
+      20000000);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment (stream, 2)->time,
+      40000000);
+  fail_unless_equals_int (gst_mss_stream_get_fragment (stream,
+          2)->repetitions, 3);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment (stream, 3)->time,
+      70000000);
+
+  /* still at the same fragment */
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+      (stream), 2 * GST_SECOND);
+  fail_unless_equals_int (gst_mss_stream_get_fragment_url (stream, &url),
+      GST_FLOW_OK);
+  fail_unless (g_str_has_suffix (url, "Fragments(audio_eng=20000000)"),
+      "unexpected url %s", url);
+  g_free (url);
+
+  /* 3s, 4s, 5s, 6s and 7s are still ahead */
+  n_fragments = 0;
+  while (gst_mss_stream_advance_fragment (stream) == GST_FLOW_OK)
+    n_fragments++;
+  fail_unless_equals_int (n_fragments, 5);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+      (stream), 7500 * GST_MSECOND);
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
+/*
+ * Test seeking to a position in a gap between two fragment runs
+ *
+ */
+GST_START_TEST (testManifestSeekIntoGap)
+{
+  const gchar *manifest_xml =
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+      "<SmoothStreamingMedia MajorVersion=\"2\" MinorVersion=\"0\" Duration=\"40000000\">"
+      "<StreamIndex Type=\"audio\" Language=\"eng\" QualityLevels=\"1\" Url=\"QualityLevels({bitrate})/Fragments(audio_eng={start time})\">"
+      "<QualityLevel Index=\"0\" Bitrate=\"200029\" FourCC=\"AACL\" SamplingRate=\"48000\" Channels=\"2\" BitsPerSample=\"16\" PacketSize=\"4\" AudioTag=\"255\" CodecPrivateData=\"1190\" />"
+      "<c t=\"0\" d=\"10000000\" />"
+      "<c t=\"20000000\" d=\"10000000\" />"
+      "<c d=\"10000000\" />" "</StreamIndex>" "</SmoothStreamingMedia>";
+  GstMssManifest *manifest;
+  GstMssStream *stream;
+  guint64 final_time = GST_CLOCK_TIME_NONE;
+
+  manifest = manifest_new_from_string (manifest_xml);
+  stream = gst_mss_manifest_get_streams (manifest)->data;
+  gst_mss_stream_set_active (stream, TRUE);
+
+  /* forward playback starts at the fragment after the gap */
+  gst_mss_stream_seek (stream, TRUE, 0, 1500 * GST_MSECOND, &final_time);
+  fail_unless_equals_uint64 (final_time, 2 * GST_SECOND);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+      (stream), 2 * GST_SECOND);
+
+  /* reverse playback starts at the fragment before it */
+  gst_mss_stream_seek (stream, FALSE, 0, 1500 * GST_MSECOND, &final_time);
+  fail_unless_equals_uint64 (final_time, 0);
+  fail_unless_equals_uint64 (gst_mss_stream_get_fragment_gst_timestamp
+      (stream), 0);
+
+  gst_mss_manifest_free (manifest);
+}
+
+GST_END_TEST;
+
 static Suite *
 mss_demux_suite (void)
 {
   Suite *s = suite_create ("mss_demux");
   TCase *tc_basicTest = tcase_create ("basicTest");
 
+  GST_DEBUG_CATEGORY_INIT (mssdemux_debug, "mssdemux_manifest", 0,
+      "mss manifest tests");
+
   tcase_add_test (tc_basicTest, simpleTest);
   tcase_add_test (tc_basicTest, testSeek);
   tcase_add_test (tc_basicTest, testSeekKeyUnitPosition);
@@ -622,6 +765,8 @@ mss_demux_suite (void)
   tcase_add_test (tc_basicTest, testDownloadError);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
   tcase_add_test (tc_basicTest, testQuery);
+  tcase_add_test (tc_basicTest, testManifestReloadMerge);
+  tcase_add_test (tc_basicTest, testManifestSeekIntoGap);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
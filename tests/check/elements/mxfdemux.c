@@ -21,6 +21,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include "mxfdemux.h"
 
@@ -287,6 +288,399 @@ GST_START_TEST (test_push)
 
 GST_END_TEST;
 
+static void
+run_to_eos (GstElement * pipeline)
+{
+  GstMessage *msg;
+  GstBus *bus;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+/* Muxes @n_frames of small raw video, which is indexed with CBE
+ * index table segments, into a temporary file */
+static gchar *
+mux_to_file (gint n_frames)
+{
+  GstElement *pipeline;
+  gchar *location, *description;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfdemux-XXXXXX.mxf", &location, NULL);
+  fail_unless (fd != -1);
+  g_close (fd, NULL);
+
+  description = g_strdup_printf ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,format=(string)UYVY,width=16,height=16,framerate=25/1 ! "
+      "mxfmux ! filesink location=%s", n_frames, location);
+  pipeline = gst_parse_launch (description, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (description);
+
+  run_to_eos (pipeline);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return location;
+}
+
+static GstClockTime first_pts;
+
+static GstPadProbeReturn
+_first_pts_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (!GST_CLOCK_TIME_IS_VALID (first_pts))
+    first_pts = GST_BUFFER_PTS (buffer);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_seek_index)
+{
+  /* the first index table segment ends after 5957 frames */
+  const gint64 frames[] = { 0, 10, 3000, 5956, 5957, 6100, 6499 };
+  GstElement *pipeline, *sink;
+  gchar *location, *description;
+  GstPad *pad;
+  guint i;
+
+  location = mux_to_file (6500);
+
+  description = g_strdup_printf ("filesrc location=%s ! mxfdemux ! "
+      "fakesink name=sink sync=false", location);
+  pipeline = gst_parse_launch (description, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (description);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _first_pts_probe, NULL,
+      NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  first_pts = GST_CLOCK_TIME_NONE;
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (first_pts, 0);
+
+  /* every frame is a keyframe, seeking into the middle of a frame has
+   * to start at that frame */
+  for (i = 0; i < G_N_ELEMENTS (frames); i++) {
+    GstClockTime expected = frames[i] * 40 * GST_MSECOND;
+
+    first_pts = GST_CLOCK_TIME_NONE;
+    fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+            expected + 20 * GST_MSECOND));
+    fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+            GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+    fail_unless_equals_uint64 (first_pts, expected);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+static void
+_count_pads (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  gint *n_pads = user_data;
+
+  *n_pads = *n_pads + 1;
+}
+
+/* Demuxes the file and returns the final structure */
+static GstStructure *
+demux_structure (const gchar * location, gboolean lazy, gint * n_pads)
+{
+  GstElement *pipeline, *demux;
+  GstStructure *structure = NULL;
+  gchar *description;
+
+  description = g_strdup_printf ("filesrc location=%s ! "
+      "mxfdemux name=demux lazy-descriptive-metadata=%s ! "
+      "fakesink sync=false", location, lazy ? "true" : "false");
+  pipeline = gst_parse_launch (description, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (description);
+
+  *n_pads = 0;
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  g_signal_connect (demux, "pad-added", G_CALLBACK (_count_pads), n_pads);
+
+  run_to_eos (pipeline);
+
+  /* postponed descriptive metadata was parsed before EOS */
+  g_object_get (demux, "structure", &structure, NULL);
+  fail_unless (structure != NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (demux);
+  gst_object_unref (pipeline);
+
+  return structure;
+}
+
+GST_START_TEST (test_lazy_descriptive_metadata)
+{
+  GstStructure *structure, *lazy_structure;
+  gint n_pads, lazy_n_pads;
+  gchar *location;
+
+  location = mux_to_file (10);
+
+  structure = demux_structure (location, FALSE, &n_pads);
+  lazy_structure = demux_structure (location, TRUE, &lazy_n_pads);
+
+  fail_unless_equals_int (n_pads, 1);
+  fail_unless_equals_int (lazy_n_pads, n_pads);
+  fail_unless (gst_structure_is_equal (lazy_structure, structure));
+
+  gst_structure_free (lazy_structure);
+  gst_structure_free (structure);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lazy_descriptive_metadata_request)
+{
+  GstElement *pipeline, *demux;
+  GstStructure *structure;
+  gchar *location, *description;
+
+  location = mux_to_file (10);
+
+  description = g_strdup_printf ("filesrc location=%s ! "
+      "mxfdemux name=demux lazy-descriptive-metadata=true ! "
+      "fakesink sync=false", location);
+  pipeline = gst_parse_launch (description, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (description);
+
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+
+  /* prerolled, the streaming thread is blocked in the sink */
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  /* reading the structure doesn't request the postponed metadata */
+  g_object_get (demux, "structure", &structure, NULL);
+  if (structure)
+    gst_structure_free (structure);
+  fail_if (g_atomic_int_get (&GST_MXF_DEMUX (demux)->
+          parse_descriptive_metadata));
+
+  g_signal_emit_by_name (demux, "parse-descriptive-metadata");
+  fail_unless (g_atomic_int_get (&GST_MXF_DEMUX (demux)->
+          parse_descriptive_metadata));
+
+  run_to_eos (pipeline);
+
+  g_object_get (demux, "structure", &structure, NULL);
+  fail_unless (structure != NULL);
+  gst_structure_free (structure);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (demux);
+  gst_object_unref (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+/* A file that is still being written: only growing_available bytes of
+ * it can be pulled until the demuxer waits for more data, at which point
+ * the rest of the file appears unless growing_stalled is set */
+static guint8 *growing_data;
+static gsize growing_size, growing_available;
+static gint n_buffers, n_buffers_before_growth;
+static gboolean growing_stalled;
+
+static GstFlowReturn
+_growing_src_getrange (GstPad * pad, GstObject * parent, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  if (offset >= growing_available)
+    return GST_FLOW_EOS;
+
+  if (offset + length > growing_available)
+    length = growing_available - offset;
+
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      growing_data + offset, length, 0, length, NULL, NULL);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_growing_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    GstFormat fmt;
+
+    gst_query_parse_duration (query, &fmt, NULL);
+    if (fmt != GST_FORMAT_BYTES)
+      return FALSE;
+
+    /* once essence was output, the demuxer only asks for the size while
+     * it waits for the file to grow */
+    if (n_buffers > 0 && growing_available < growing_size
+        && !growing_stalled) {
+      fail_if (have_eos);
+      n_buffers_before_growth = n_buffers;
+      growing_available = growing_size;
+    }
+
+    gst_query_set_duration (query, fmt, growing_available);
+    return TRUE;
+  }
+
+  return _src_query (pad, parent, query);
+}
+
+static void
+_growing_pad_added (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  fail_unless (gst_pad_link (pad, mysinkpad) == GST_PAD_LINK_OK);
+}
+
+static GstFlowReturn
+_growing_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer),
+      n_buffers * 40 * GST_MSECOND);
+  gst_buffer_unref (buffer);
+  n_buffers++;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_growing_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    while (!g_main_loop_is_running (loop));
+
+    have_eos = TRUE;
+    g_main_loop_quit (loop);
+  }
+
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static void
+run_growing_file (gboolean stalled, GstClockTime timeout)
+{
+  GstStateChangeReturn sret;
+  GstElement *mxfdemux;
+  GstPad *sinkpad;
+  gchar *location;
+
+  location = mux_to_file (100);
+  fail_unless (g_file_get_contents (location, (gchar **) & growing_data,
+          &growing_size, NULL));
+  g_unlink (location);
+  g_free (location);
+
+  /* cut in the middle of the essence */
+  growing_available = growing_size / 2;
+  n_buffers = n_buffers_before_growth = 0;
+  growing_stalled = stalled;
+  have_eos = FALSE;
+  loop = g_main_loop_new (NULL, FALSE);
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  g_object_set (mxfdemux, "growing-file", TRUE, "growing-file-timeout",
+      timeout, NULL);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_growing_pad_added),
+      NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+
+  mysinkpad = gst_pad_new_from_static_template (&mysinktemplate, "sink");
+  gst_pad_set_chain_function (mysinkpad, _growing_sink_chain);
+  gst_pad_set_event_function (mysinkpad, _growing_sink_event);
+  mysrcpad = gst_pad_new_from_static_template (&mysrctemplate, "src");
+  gst_pad_set_getrange_function (mysrcpad, _growing_src_getrange);
+  gst_pad_set_query_function (mysrcpad, _growing_src_query);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  sret = gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+  fail_unless_equals_int (sret, GST_STATE_CHANGE_SUCCESS);
+
+  g_main_loop_run (loop);
+  fail_unless (have_eos == TRUE);
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_main_loop_unref (loop);
+  loop = NULL;
+  g_free (growing_data);
+  growing_data = NULL;
+}
+
+GST_START_TEST (test_growing_file)
+{
+  run_growing_file (FALSE, GST_CLOCK_TIME_NONE);
+
+  /* the end of the available data did not end the stream */
+  fail_unless (n_buffers_before_growth > 0);
+  fail_unless (n_buffers_before_growth < 100);
+  fail_unless_equals_int (n_buffers, 100);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_growing_file_timeout)
+{
+  run_growing_file (TRUE, 500 * GST_MSECOND);
+
+  /* the file never grew, the stream ended with the available data */
+  fail_unless_equals_int (n_buffers_before_growth, 0);
+  fail_unless (n_buffers > 0);
+  fail_unless (n_buffers < 100);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfdemux_suite (void)
 {
@@ -302,6 +696,11 @@ mxfdemux_suite (void)
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
   tcase_add_test (tc_chain, test_push);
+  tcase_add_test (tc_chain, test_seek_index);
+  tcase_add_test (tc_chain, test_lazy_descriptive_metadata);
+  tcase_add_test (tc_chain, test_lazy_descriptive_metadata_request);
+  tcase_add_test (tc_chain, test_growing_file);
+  tcase_add_test (tc_chain, test_growing_file_timeout);
 
   return s;
 }
@@ -20,9 +20,16 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include "../../gst/mxf/mxful.c"
+#include "../../gst/mxf/mxftypes.c"
+#undef GST_CAT_DEFAULT
+
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
+GST_DEBUG_CATEGORY (mxf_debug);
+
 static const gchar *
 get_mpeg2enc_element_name (void)
 {
@@ -265,12 +272,237 @@ GST_START_TEST (test_h264_raw_audio)
 
 GST_END_TEST;
 
+/* Enough edit units for the first index table segment to be final
+ * before EOS, so that it is written into a body partition */
+#define N_INDEXED_FRAMES 6500
+
+static gchar *
+mux_to_file (const gchar * pipeline_format, ...)
+{
+  gchar *location, *pipeline, *description;
+  va_list args;
+  gint fd;
+
+  fd = g_file_open_tmp ("mxfmux-XXXXXX.mxf", &location, NULL);
+  fail_unless (fd != -1);
+  g_close (fd, NULL);
+
+  va_start (args, pipeline_format);
+  description = g_strdup_vprintf (pipeline_format, args);
+  va_end (args);
+
+  pipeline = g_strdup_printf ("%s ! mxfmux name=mux ! filesink location=%s",
+      description, location);
+  run_test (pipeline);
+  g_free (pipeline);
+  g_free (description);
+
+  return location;
+}
+
+static guint
+read_ber_length (const guint8 * data, gsize size, guint64 * length)
+{
+  guint i, n;
+
+  fail_unless (size > 0);
+  if (data[0] < 0x80) {
+    *length = data[0];
+    return 1;
+  }
+
+  n = data[0] & 0x7f;
+  fail_unless (n > 0 && n <= 8 && n < size);
+  *length = 0;
+  for (i = 0; i < n; i++)
+    *length = (*length << 8) | data[1 + i];
+
+  return 1 + n;
+}
+
+/* Walks all KLV packets of a muxed file and checks that every partition
+ * is listed in the RIP, that all body partitions point to the footer and
+ * that the index table segments in body and footer partitions together
+ * cover the essence without gaps */
+static void
+check_index_partitions (const gchar * location, gboolean cbe,
+    gint64 n_edit_units)
+{
+  gchar *contents;
+  gsize size, offset = 0;
+  GArray *partitions;
+  GArray *rip = NULL;
+  guint64 footer_offset = 0;
+  guint64 index_byte_count = 0;
+  gint64 next_start_position = 0;
+  guint n_body_segments = 0, n_footer_segments = 0;
+  guint i;
+
+  fail_unless (g_file_get_contents (location, &contents, &size, NULL));
+
+  partitions = g_array_new (FALSE, TRUE, sizeof (MXFPartitionPack));
+
+  while (offset < size) {
+    const MXFUL *key = (const MXFUL *) (contents + offset);
+    const guint8 *payload;
+    guint64 length;
+    guint ber_size;
+
+    fail_unless (offset + 17 <= size);
+    fail_unless (mxf_is_mxf_packet (key));
+    ber_size =
+        read_ber_length ((const guint8 *) contents + offset + 16,
+        size - offset - 16, &length);
+    payload = (const guint8 *) contents + offset + 16 + ber_size;
+    fail_unless (offset + 16 + ber_size + length <= size);
+
+    if (mxf_is_partition_pack (key)) {
+      MXFPartitionPack pack;
+
+      /* all index table segments of the previous partition were seen */
+      if (partitions->len > 0)
+        fail_unless_equals_uint64 (index_byte_count,
+            g_array_index (partitions, MXFPartitionPack,
+                partitions->len - 1).index_byte_count);
+      index_byte_count = 0;
+
+      fail_unless (mxf_partition_pack_parse (key, &pack, payload, length));
+      fail_unless_equals_uint64 (pack.this_partition, offset);
+      if (pack.type == MXF_PARTITION_PACK_FOOTER)
+        footer_offset = offset;
+      g_array_append_val (partitions, pack);
+    } else if (mxf_is_index_table_segment (key)) {
+      MXFIndexTableSegment segment;
+      const MXFPartitionPack *pack;
+
+      fail_unless (partitions->len > 0);
+      pack = &g_array_index (partitions, MXFPartitionPack, partitions->len - 1);
+      fail_unless (pack->index_sid != 0);
+
+      memset (&segment, 0, sizeof (segment));
+      fail_unless (mxf_index_table_segment_parse (key, &segment, payload,
+              length));
+      fail_unless_equals_int64 (segment.index_start_position,
+          next_start_position);
+      fail_unless (segment.index_duration > 0);
+      next_start_position += segment.index_duration;
+
+      if (cbe) {
+        fail_unless (segment.edit_unit_byte_count > 0);
+        fail_unless_equals_int (segment.n_index_entries, 0);
+      } else {
+        fail_unless_equals_int (segment.edit_unit_byte_count, 0);
+        fail_unless_equals_int64 (segment.n_index_entries,
+            segment.index_duration);
+      }
+
+      if (pack->type == MXF_PARTITION_PACK_BODY)
+        n_body_segments++;
+      else if (pack->type == MXF_PARTITION_PACK_FOOTER)
+        n_footer_segments++;
+
+      index_byte_count += 16 + ber_size + length;
+      mxf_index_table_segment_reset (&segment);
+    } else if (mxf_is_random_index_pack (key)) {
+      fail_unless (rip == NULL);
+      fail_unless (mxf_random_index_pack_parse (key, payload, length, &rip));
+    }
+
+    offset += 16 + ber_size + length;
+  }
+
+  fail_unless (partitions->len > 0);
+  fail_unless_equals_uint64 (index_byte_count,
+      g_array_index (partitions, MXFPartitionPack,
+          partitions->len - 1).index_byte_count);
+
+  /* at least one segment was final early enough for a body partition */
+  fail_unless (n_body_segments > 0);
+  fail_unless (n_footer_segments > 0);
+  if (n_edit_units > 0)
+    fail_unless_equals_int64 (next_start_position, n_edit_units);
+
+  fail_unless (footer_offset != 0);
+  fail_unless (rip != NULL);
+  fail_unless_equals_int (rip->len, partitions->len);
+
+  for (i = 0; i < partitions->len; i++) {
+    MXFPartitionPack *pack = &g_array_index (partitions, MXFPartitionPack, i);
+    MXFRandomIndexPackEntry *entry =
+        &g_array_index (rip, MXFRandomIndexPackEntry, i);
+
+    fail_unless_equals_uint64 (entry->offset, pack->this_partition);
+    fail_unless_equals_int (entry->body_sid, pack->body_sid);
+
+    if (i == 0) {
+      fail_unless_equals_int (pack->type, MXF_PARTITION_PACK_HEADER);
+    } else {
+      fail_unless_equals_uint64 (pack->prev_partition,
+          g_array_index (partitions, MXFPartitionPack, i - 1).this_partition);
+    }
+
+    if (pack->type == MXF_PARTITION_PACK_BODY) {
+      fail_unless (pack->body_sid != 0);
+      fail_unless (pack->closed);
+      fail_unless (pack->complete);
+    } else {
+      fail_unless_equals_int (entry->body_sid, 0);
+    }
+
+    fail_unless_equals_uint64 (pack->footer_partition, footer_offset);
+    mxf_partition_pack_reset (pack);
+  }
+
+  g_array_free (rip, TRUE);
+  g_array_free (partitions, TRUE);
+  g_free (contents);
+}
+
+GST_START_TEST (test_index_partitions_cbe)
+{
+  gchar *location;
+
+  location = mux_to_file ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,format=(string)UYVY,width=16,height=16,framerate=25/1",
+      N_INDEXED_FRAMES);
+
+  check_index_partitions (location, TRUE, N_INDEXED_FRAMES);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_index_partitions_vbe)
+{
+  const gchar *mpeg2enc_name = get_mpeg2enc_element_name ();
+  gchar *location;
+
+  if (!mpeg2enc_name)
+    return;
+
+  location = mux_to_file ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,width=64,height=64,framerate=25/1 ! %s",
+      N_INDEXED_FRAMES, mpeg2enc_name);
+
+  /* the encoder decides how many frames come out */
+  check_index_partitions (location, FALSE, -1);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfmux_suite (void)
 {
   Suite *s = suite_create ("mxfmux");
   TCase *tc_chain = tcase_create ("general");
 
+  GST_DEBUG_CATEGORY_INIT (mxf_debug, "mxf", 0, "MXF");
+
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 180);
 
@@ -281,6 +513,8 @@ mxfmux_suite (void)
   tcase_add_test (tc_chain, test_dnxhd_mp3);
   tcase_add_test (tc_chain, test_h264_raw_audio);
   tcase_add_test (tc_chain, test_multiple_av_streams);
+  tcase_add_test (tc_chain, test_index_partitions_cbe);
+  tcase_add_test (tc_chain, test_index_partitions_vbe);
 
   return s;
 }
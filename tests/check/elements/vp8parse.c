@@ -0,0 +1,255 @@
+/* GStreamer
+ *
+ * unit test for vp8parse
+ *
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* 176x144 version 0 key frame */
+static guint8 vp8_key_frame[] = {
+  0x50, 0x1d, 0x00, 0x9d, 0x01, 0x2a, 0xb0, 0x00, 0x90, 0x00, 0x00, 0x07,
+  0x08, 0x85, 0x85, 0x88, 0x85, 0x84, 0x88, 0x02, 0x02, 0x03, 0x55, 0xd2,
+  0x82, 0xf1, 0x8e, 0xd1, 0x00, 0x13, 0xee, 0x83, 0x17, 0x70, 0xd0, 0xf8,
+  0x34, 0xdc, 0x9e, 0x9a, 0x6f, 0x7a, 0x6b, 0xb0, 0x26, 0x33, 0xf7, 0xe1,
+  0xba, 0x59, 0xef, 0x1e, 0x97, 0xe6, 0xc4, 0x4e, 0x49, 0x72, 0x22, 0x6d,
+  0x72, 0x1a, 0xeb, 0x53, 0x48, 0x32, 0x3a, 0x22, 0x44, 0x5a, 0x61, 0xc5,
+  0x1f, 0xd8, 0xb2, 0xf3, 0x3c, 0xb6, 0x40, 0x7b, 0x7b, 0x83, 0x74, 0xb8,
+  0x56, 0xfb, 0xdc, 0xac, 0x00, 0x01, 0x55, 0xfc, 0x9d, 0xda, 0x9c, 0x5f,
+  0xf0, 0xfe, 0x7a, 0xf1, 0xc4, 0x9a, 0xa9, 0x04, 0x0a, 0xfd, 0x51, 0xe2,
+  0xca, 0x64, 0x57, 0xda, 0x5c, 0x0c, 0x16, 0x95, 0x54, 0x79, 0x48, 0xdc,
+  0x2c, 0x26, 0xf9, 0x27, 0x52, 0x1f, 0xc2, 0xd6, 0x6e, 0xdc, 0xa6, 0xae,
+  0x95, 0x02, 0xff, 0xaf, 0xa7, 0xdd, 0xa1, 0xb1, 0x7e, 0x03, 0x8d, 0x98,
+  0x14, 0x6c, 0x80, 0x39, 0x86, 0x65, 0x13, 0x33, 0xad, 0xdc, 0x2e, 0x84,
+  0xaa, 0xa8, 0xaa, 0xe4, 0x93, 0x10, 0x18, 0xca, 0x31, 0xe8, 0xa2, 0x1b,
+  0x49, 0x9e, 0xc0, 0xe2, 0x94, 0xc6, 0x80, 0x70, 0xe0, 0xf8, 0x41, 0x91,
+  0x92, 0xc4, 0xab, 0xf1, 0x46, 0xde, 0x8b, 0xfe, 0x3c, 0x3e, 0x2d, 0xc0,
+  0xb4, 0x90, 0xc3, 0x62, 0xef, 0xc7, 0xfb, 0x8f, 0xe0, 0x13, 0x79, 0x0f,
+  0x52, 0x64, 0xfb, 0x2b, 0x65, 0x17, 0x6f, 0x25, 0x2a, 0x9c, 0xfb, 0x98,
+  0x86, 0xb4, 0x09, 0x8b, 0x37, 0x67, 0x54, 0x32, 0x7e, 0xcc, 0x07, 0xff,
+  0xb4, 0x15, 0xd0, 0x11, 0x30, 0x2e, 0x0f, 0x12, 0xc9, 0xff, 0xfd, 0x9b,
+  0x69, 0x44, 0x65, 0x60, 0xfe, 0xff, 0xab, 0x52, 0x8a, 0x9a, 0x31, 0xbd,
+  0xcc, 0x8d, 0x1e, 0x31, 0x35, 0x8a, 0x27, 0x32, 0x9d, 0xd2, 0xca, 0xc8,
+  0x26, 0x0a, 0xe2, 0x4a, 0x12, 0xba, 0x3b, 0x8b, 0x89, 0xa1, 0x3b, 0x05,
+  0x54, 0x96, 0xcc, 0xe6, 0x6a, 0x56, 0x3e, 0xcd, 0xd6, 0x13, 0x46, 0x40,
+  0x21, 0x64, 0x0b, 0xa3, 0xf9, 0x0a, 0x9a, 0xb4, 0x66, 0xe3, 0x5b, 0x36,
+  0xea, 0x0a, 0x56, 0xbf, 0xf3, 0xac, 0x42, 0xcd, 0x7a, 0x36, 0xce, 0xc3,
+  0x4b, 0x15, 0x6b, 0xdb, 0x6e, 0x23, 0x94, 0x69, 0x44, 0xd4, 0x42, 0x51,
+  0x8f, 0x21, 0x41, 0x4a, 0x24, 0x15, 0x0d, 0xea, 0x3b, 0x5f, 0xdd, 0xc2,
+  0xf1, 0x0f, 0x9b, 0x73, 0x49, 0x3e, 0x82, 0x16, 0x44, 0x77, 0x0f, 0x80,
+  0x35, 0x04, 0x1a, 0x7f, 0xb3, 0x17, 0xac, 0xf9, 0x38, 0xc9, 0x57, 0x74,
+  0xcd, 0x03, 0x95, 0xbb, 0xec, 0xe4, 0x53, 0x2a, 0x6f, 0xf1, 0x51, 0x12,
+  0xd7, 0x78, 0xaf, 0x3a, 0x77, 0x86, 0x21, 0xfa, 0xa8, 0x05, 0x99, 0x9a,
+  0xc8, 0x9b, 0x4e, 0x72, 0xc9, 0xd5, 0x75, 0x7e, 0x7f, 0x09, 0xdf, 0x02,
+  0x70, 0x59, 0xc4, 0x28, 0x04, 0x88, 0x4f, 0x59, 0xe8, 0x30, 0xc9, 0x66,
+  0xa2, 0x51, 0xef, 0x40, 0xc5, 0xbc, 0xac, 0x74, 0x03, 0xff, 0x6a, 0xb2,
+  0xd4, 0x1a, 0x3b, 0x2c, 0x4a, 0x66, 0xa8, 0xed, 0x18, 0x62, 0x93, 0x4a,
+  0xcb, 0x07, 0x86, 0x7b, 0x70, 0x0f, 0xb0, 0x5e, 0xa6, 0xdd, 0xe1, 0x1a,
+  0x99, 0xd3, 0x2a, 0xf7, 0x98, 0x06, 0x93, 0xbf, 0xa7, 0x8e, 0x13, 0x50,
+  0x44, 0xbc, 0xce, 0x36, 0x17, 0x1b, 0x1f, 0x15, 0xb3, 0x22, 0x3e, 0xd9,
+  0x88, 0xe3, 0xa4, 0xa1, 0x60, 0xde, 0x37, 0x53, 0x0b, 0xbe, 0x0c, 0xe8,
+  0xd0, 0xfa, 0xdd, 0x1f, 0xa6, 0xda, 0xf7, 0xb3, 0x97, 0x44, 0xf1, 0x23,
+  0x29, 0xee, 0xbf, 0xf6, 0xf2, 0x1d, 0xd8, 0x58, 0x20, 0xd7, 0x77, 0xa6,
+  0xf9, 0xb0, 0x6b, 0xcd, 0xda, 0x06, 0xc0, 0x2f, 0x50, 0x95, 0xc6, 0x07,
+  0x2a, 0xbf, 0x46, 0x27, 0x59, 0x52, 0xc3, 0xc7, 0xe6, 0xd7, 0xcb, 0x00,
+  0x53, 0x76, 0x3e, 0x44, 0x4f, 0xab, 0x4d, 0xbd, 0xff, 0x5d, 0xea, 0xf3,
+  0xa9, 0x14, 0x0e, 0x4d, 0xb9, 0xe4, 0xde, 0x9e, 0xb0, 0xa7, 0xf1, 0x41,
+  0x79, 0x30, 0xa4, 0xa8, 0x2e, 0xb5, 0x42, 0x40, 0x08, 0xf8, 0x00, 0xbf,
+  0xdc, 0xe4, 0xe0, 0xff, 0x54, 0x1b, 0x34, 0xe2, 0xed, 0x2c, 0x03, 0x96,
+  0x9e, 0xb9, 0xea, 0x6d, 0x46, 0xa9, 0x51, 0x6c, 0xff, 0xa2, 0xd1, 0x84,
+  0x0b, 0xa9, 0xd5, 0xd2, 0xb5, 0x08, 0x62, 0x17, 0x7f, 0x5c, 0xcc, 0xdb,
+  0x5c, 0x2b, 0xe1, 0x2a, 0x6d, 0x45, 0xf8, 0xf0, 0x32, 0x58, 0xb4, 0xc8,
+  0x36, 0x2c, 0xa6, 0x1b, 0xc4, 0x87, 0x4d, 0x29, 0xe6, 0x2f, 0x3b, 0x2e,
+  0xd2, 0x80, 0x75, 0xf9, 0x81, 0x22, 0x2e, 0x5e, 0x61, 0xf7, 0xac, 0xb0,
+  0xb6, 0x35, 0xd8, 0x38, 0xa8, 0xf4, 0xef, 0xac, 0xe7, 0x3a, 0x87, 0xff,
+  0x0d, 0x84, 0x94, 0x4c, 0x6d, 0x81, 0x01, 0xd0, 0x83, 0x65, 0x16, 0x57,
+  0xb4, 0x6c, 0x8e, 0x00,
+};
+
+/* inter frame following the key frame */
+static guint8 vp8_inter_frame[] = {
+  0x51, 0x0c, 0x00, 0x00, 0x10, 0x10, 0x00, 0x1e, 0xcb, 0x03, 0xdc, 0xc3,
+  0xed, 0xef, 0x1d, 0x30, 0xe3, 0x45, 0xc8, 0x86, 0xa6, 0xa4, 0x9c, 0x8e,
+  0x72, 0xee, 0xae, 0x46, 0x79, 0x53, 0x58, 0x0b, 0x01, 0xb1, 0xf4, 0x06,
+  0x5c, 0xc0, 0x18, 0xb8, 0x2b, 0xa0, 0x00, 0x3f, 0x06, 0x9a, 0x28, 0x55,
+  0x3b, 0x5f, 0x2b, 0x02, 0x14, 0x03, 0x93, 0xdf, 0x09, 0xe3, 0x22, 0x23,
+  0x53, 0xd3, 0xa8, 0x84, 0x34, 0x05, 0x0d, 0xec, 0xa9, 0x49, 0x72, 0xee,
+  0x9f, 0x4a, 0x0e, 0xbe, 0x98, 0xbc, 0x01, 0x08, 0x9e, 0xd5, 0x6a, 0xb2,
+  0x47, 0x0c, 0x19, 0xe0, 0x60, 0x3e, 0x3c, 0x75, 0xef, 0x65, 0xc6, 0x6c,
+  0x4f, 0xdb, 0x05, 0x38, 0x40, 0xfd, 0xe0, 0x05, 0x6b, 0xb5, 0x02, 0xc3,
+  0xeb, 0x8e, 0x18, 0x64, 0xf9, 0xe7, 0x7c, 0x98, 0x43, 0x2a, 0x5a, 0x80,
+  0xfb, 0xea, 0x20, 0x08, 0x98, 0x56, 0x73, 0x16, 0x26, 0x38, 0x5f, 0x3a,
+  0x7b, 0x7e, 0xf3, 0x0f, 0xe3, 0xbb, 0xa8, 0x76, 0x58, 0xbc, 0xb6, 0xfd,
+  0xa2, 0x66, 0xdb, 0xff, 0x84, 0x61, 0x29, 0xf4, 0x93, 0x23, 0x7e, 0x78,
+  0x4c, 0x1c, 0x31, 0x45, 0xb4, 0x1a, 0xa7, 0x0e, 0x1c, 0xaa, 0x7a, 0xdd,
+  0x85, 0xda, 0xe5, 0xa8, 0x92, 0xca, 0x81, 0xac, 0x72, 0x5d, 0xa1, 0x12,
+  0x18, 0xf9, 0xee, 0xfd, 0x31, 0xf3, 0xdf, 0x4b, 0x87, 0x75, 0x80, 0x2c,
+  0x12, 0x03, 0xb6, 0x1f, 0x08, 0x3c, 0x7b, 0x32, 0x89, 0xe1, 0xae, 0xa6,
+  0x41, 0x43, 0x4d, 0xd6, 0xbb, 0x0d, 0x9c, 0x9d, 0x36, 0x35, 0xc5, 0xa7,
+  0xf8, 0xec, 0x18, 0xd2, 0x12, 0x9b, 0x90, 0x84, 0x9c, 0xd8, 0x92, 0x7e,
+  0xe9, 0xba, 0x97, 0x53, 0x53, 0xcb, 0x07, 0xda, 0x81, 0xd0, 0x5f, 0xd6,
+  0x87, 0x94, 0x64, 0xb9, 0xca, 0x33, 0x2c, 0xb8, 0x14, 0x04, 0x13, 0xe4,
+  0x1b, 0xe3, 0xb5, 0x1f, 0xcb, 0xfc, 0xf1, 0x79, 0xc6, 0xc6, 0x32, 0xcf,
+  0x28, 0x2e, 0x05, 0x8a, 0xe4, 0x57, 0x08, 0x23, 0xd7, 0x31, 0xef, 0x81,
+  0x8a, 0x0a, 0xab, 0x2e, 0x80, 0x1e, 0x4a, 0x95, 0x78, 0x69, 0xed, 0xf6,
+  0x00, 0x55, 0x5c, 0x38, 0x1f, 0x8c, 0xd9, 0x6e, 0x6c, 0x1e, 0xce, 0x1c,
+  0xa4, 0xf9, 0x1d, 0xff, 0xe6, 0xcd, 0x66, 0xc3, 0x35, 0xe8, 0x84, 0xd7,
+  0xe4, 0xac, 0xbf, 0x5b, 0x6f, 0x32, 0x7e, 0x55, 0x66, 0xb2, 0xa8, 0x1e,
+  0x8b, 0xcb, 0x70, 0xcf, 0xa1, 0x63, 0xd4, 0xa8, 0xb1, 0xc0, 0x1f, 0xa6,
+  0xbf, 0xcf, 0x6b, 0xaf, 0xb4, 0xbc, 0x38, 0x12, 0xbc, 0x1e, 0x72, 0x48,
+  0x7d, 0xc9, 0xc9, 0xe9, 0x28, 0xd0, 0xcd, 0xe3, 0xf5, 0x45, 0x91, 0xad,
+  0x7b, 0xba, 0x5b, 0x10, 0xd3, 0x85, 0xad, 0x49, 0x15, 0xf6, 0x89, 0x3e,
+  0x50, 0x21, 0x18, 0xdc, 0x4e, 0xce, 0xbd, 0x6c, 0xe9, 0xa9, 0x40, 0xf3,
+  0x78, 0x97, 0xf9, 0x71, 0xe0, 0x18, 0x32, 0xad, 0xac, 0xf8, 0x3f, 0x42,
+  0xa7, 0x43, 0x2b, 0x32, 0xbd, 0xad, 0x77, 0xb5, 0x87, 0xf8, 0xe0, 0xfe,
+  0x7e, 0x93, 0xb7, 0xfe, 0x40, 0x19, 0x29, 0x4e, 0x4b, 0x80, 0x77, 0x0f,
+  0xa8, 0xc0, 0x17, 0xa1, 0xf1, 0xb8, 0x4f, 0x6c, 0xee, 0x08, 0xe6, 0x78,
+  0x98, 0x45, 0x71, 0xbf, 0xea, 0xe9, 0x34, 0x3a, 0x49, 0x44, 0xc8, 0xb1,
+  0x79, 0x5c, 0x14, 0x37, 0xf4, 0x77, 0xf8, 0x8f, 0xda, 0xe6, 0x8e, 0x6c,
+  0x20, 0xf7, 0x75, 0x35, 0x8c, 0x43, 0x49, 0x21, 0x34, 0xb0, 0x19, 0x16,
+  0x2f, 0x2b, 0x9a, 0x64, 0x8f, 0x39, 0x45, 0x9b, 0x7a, 0x27, 0x96, 0xc6,
+  0x4d, 0x95, 0xdc, 0x03, 0x6c, 0xea, 0xea, 0x60, 0xa8, 0x16, 0xb4, 0x24,
+  0xa6, 0x9a, 0x68, 0x49, 0xcb, 0xf2, 0x22, 0xb5, 0xda, 0x2d, 0xd2, 0x0c,
+  0xad, 0x57, 0xba, 0x5a, 0x8d, 0xa0, 0x0a, 0x98, 0x31, 0x64, 0xad, 0x9a,
+  0xa0, 0x6b, 0x40, 0xcd, 0x90, 0xba, 0x16, 0xc5, 0x22, 0x92, 0x70, 0x00,
+  0x0e, 0xfd, 0x70, 0x4a, 0x48, 0x58, 0xa7, 0xe6, 0x1c, 0x4a, 0xc3, 0x07,
+  0xe9, 0xe0, 0x39, 0x1e, 0x96, 0x38, 0x8c, 0x5e, 0xc1, 0x5b, 0x26, 0x43,
+  0xd9, 0xc0,
+};
+
+static GstHarness *
+setup_vp8parse (void)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("vp8parse");
+  gst_harness_set_src_caps_str (h, "video/x-vp8, framerate=(fraction)25/1");
+
+  return h;
+}
+
+static void
+push_frame (GstHarness * h, guint8 * data, gsize size, GstClockTime pts)
+{
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data, size, 0,
+      size, NULL, NULL);
+  GST_BUFFER_PTS (buf) = pts;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+}
+
+GST_START_TEST (test_parse_key_and_inter_frames)
+{
+  GstHarness *h = setup_vp8parse ();
+  GstBuffer *buf;
+
+  push_frame (h, vp8_key_frame, sizeof (vp8_key_frame), 0);
+  push_frame (h, vp8_inter_frame, sizeof (vp8_inter_frame), 40 * GST_MSECOND);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+
+  /* frames are passed through whole, only flagged */
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof (vp8_key_frame));
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), 0);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof (vp8_inter_frame));
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), 40 * GST_MSECOND);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_caps)
+{
+  GstHarness *h = setup_vp8parse ();
+  GstStructure *s;
+  GstCaps *caps;
+  gboolean parsed;
+  gint width, height, fps_n, fps_d;
+
+  push_frame (h, vp8_key_frame, sizeof (vp8_key_frame), 0);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_has_name (s, "video/x-vp8"));
+  fail_unless (gst_structure_get_boolean (s, "parsed", &parsed));
+  fail_unless (parsed);
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless_equals_int (width, 176);
+  fail_unless_equals_int (height, 144);
+  fail_unless_equals_string (gst_structure_get_string (s, "profile"), "0");
+  /* upstream fields are kept */
+  fail_unless (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d));
+  fail_unless_equals_int (fps_n, 25);
+  fail_unless_equals_int (fps_d, 1);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_corrupt_frame)
+{
+  GstHarness *h = setup_vp8parse ();
+  GstBuffer *buf;
+
+  /* a frame whose header doesn't parse is still flagged from its tag and
+   * passed on */
+  push_frame (h, vp8_key_frame, 16, 0);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 16);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp8parse_suite (void)
+{
+  Suite *s = suite_create ("vp8parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_key_and_inter_frames);
+  tcase_add_test (tc_chain, test_parse_caps);
+  tcase_add_test (tc_chain, test_parse_corrupt_frame);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp8parse);
@@ -0,0 +1,169 @@
+/* GStreamer
+ *
+ * unit test for vp9parse
+ *
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* 352x288 profile 0 key frame, header followed by padding */
+static guint8 vp9_key_frame[] = {
+  0x82, 0x49, 0x83, 0x42, 0x40, 0x15, 0xf0, 0x11,
+  0xf6, 0x14, 0x07, 0x80, 0x00, 0x40, 0x00, 0x00
+};
+
+/* superframe: hidden inter frame, then a frame showing an existing
+ * reference, then the superframe index */
+static guint8 vp9_superframe[] = {
+  0x84, 0x00, 0x20, 0x49, 0x38, 0x50, 0x1e, 0x00,
+  0x01, 0x00, 0x00, 0x00,
+  0x88,
+  0xc1, 0x0c, 0x01, 0xc1
+};
+
+static GstHarness *
+setup_vp9parse (const gchar * sink_caps)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("vp9parse");
+  gst_harness_set_src_caps_str (h, "video/x-vp9");
+  if (sink_caps)
+    gst_harness_set_sink_caps_str (h, sink_caps);
+
+  return h;
+}
+
+static void
+push_stream (GstHarness * h)
+{
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      vp9_key_frame, sizeof (vp9_key_frame), 0, sizeof (vp9_key_frame),
+      NULL, NULL);
+  GST_BUFFER_PTS (buf) = 0;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      vp9_superframe, sizeof (vp9_superframe), 0, sizeof (vp9_superframe),
+      NULL, NULL);
+  GST_BUFFER_PTS (buf) = 40 * GST_MSECOND;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+}
+
+GST_START_TEST (test_parse_caps_and_key_frames)
+{
+  GstHarness *h = setup_vp9parse (NULL);
+  GstStructure *s;
+  GstBuffer *buf;
+  GstCaps *caps;
+  gint width, height;
+
+  push_stream (h);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 2);
+
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof (vp9_key_frame));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  /* superframes are kept whole by default */
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof (vp9_superframe));
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless_equals_int (width, 352);
+  fail_unless_equals_int (height, 288);
+  fail_unless_equals_string (gst_structure_get_string (s, "profile"), "0");
+  fail_unless_equals_string (gst_structure_get_string (s, "chroma-format"),
+      "4:2:0");
+  fail_unless_equals_string (gst_structure_get_string (s, "alignment"),
+      "super-frame");
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_split_superframe)
+{
+  GstHarness *h = setup_vp9parse ("video/x-vp9, alignment=(string)frame");
+  GstMapInfo map;
+  GstBuffer *buf;
+
+  push_stream (h);
+
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), sizeof (vp9_key_frame));
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  gst_buffer_unref (buf);
+
+  /* the hidden frame has no presentation time of its own */
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 12);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DECODE_ONLY));
+  fail_if (GST_BUFFER_PTS_IS_VALID (buf));
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  fail_unless (map.data == vp9_superframe);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 1);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), 40 * GST_MSECOND);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DECODE_ONLY));
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  fail_unless (map.data == vp9_superframe + 12);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+vp9parse_suite (void)
+{
+  Suite *s = suite_create ("vp9parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_caps_and_key_frames);
+  tcase_add_test (tc_chain, test_parse_split_superframe);
+
+  return s;
+}
+
+GST_CHECK_MAIN (vp9parse);
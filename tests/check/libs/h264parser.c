@@ -144,6 +144,22 @@ static guint8 slice_eoseq_slice[] = {
   0x00, 0x00, 0x00, 0x01, 0x0b
 };
 
+/* SPS/PPS 0 code frames with pic_order_cnt_type 0, SPS/PPS 1 code fields
+ * with pic_order_cnt_type 1; then an IDR slice using PPS 0, and a field and
+ * a frame P slice using PPS 1 */
+static guint8 slice_hdr_stream[] = {
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x40, 0x1e, 0xed, 0x88, 0x4c, 0x80,
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xde, 0x3c, 0x80,
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x40, 0x1e, 0x54, 0x2a, 0x44, 0x62,
+  0x22, 0x40,
+  0x00, 0x00, 0x00, 0x01, 0x68, 0x49, 0xe3, 0xc8,
+  0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x81, 0x00, 0x65, 0x7f, 0x88, 0x84,
+  0x21, 0xa0,
+  0x00, 0x00, 0x00, 0x01, 0x41, 0x31, 0x90, 0xe4, 0x05, 0xa7, 0x9a, 0x12,
+  0x7f,
+  0x00, 0x00, 0x00, 0x01, 0x41, 0xd1, 0x0e, 0x20, 0x57, 0x45, 0x66
+};
+
 GST_START_TEST (test_h264_parse_slice_dpa)
 {
   GstH264ParserResult res;
@@ -211,6 +227,126 @@ GST_START_TEST (test_h264_parse_slice_eoseq_slice)
 
 GST_END_TEST;
 
+GST_START_TEST (test_h264_parse_start_code_offsets)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  guint8 buf[64];
+  guint i;
+
+  /* Move the first start code across a couple of 16 and 8 byte boundaries
+   * so that every position of the optimised scanner gets exercised */
+  for (i = 0; i < 40; i++) {
+    memset (buf, 0xff, sizeof (buf));
+    memcpy (buf + i, "\x00\x00\x01\x09\xf0", 5);
+    memcpy (buf + 56, "\x00\x00\x01\x09\xf0", 5);
+
+    res = gst_h264_parser_identify_nalu (parser, buf, 0, sizeof (buf), &nalu);
+
+    assert_equals_int (res, GST_H264_PARSER_OK);
+    assert_equals_int (nalu.type, GST_H264_NAL_AU_DELIMITER);
+    assert_equals_int (nalu.sc_offset, i);
+    assert_equals_int (nalu.offset, i + 3);
+    assert_equals_int (nalu.size, 56 - i - 3);
+
+    res = gst_h264_parser_identify_nalu (parser, buf, nalu.offset + nalu.size,
+        sizeof (buf), &nalu);
+
+    assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+    assert_equals_int (nalu.sc_offset, 56);
+  }
+
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h264_parse_slice_hdr_light)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  GstH264SliceHdr light, full;
+  guint offset = 0, n_slices = 0;
+
+  while (offset < sizeof (slice_hdr_stream)) {
+    res = gst_h264_parser_identify_nalu (parser, slice_hdr_stream, offset,
+        sizeof (slice_hdr_stream), &nalu);
+    if (res == GST_H264_PARSER_NO_NAL_END) {
+      nalu.size = sizeof (slice_hdr_stream) - nalu.offset;
+      res = GST_H264_PARSER_OK;
+    }
+    assert_equals_int (res, GST_H264_PARSER_OK);
+    offset = nalu.offset + nalu.size;
+
+    if (nalu.type != GST_H264_NAL_SLICE && nalu.type != GST_H264_NAL_SLICE_IDR) {
+      assert_equals_int (gst_h264_parser_parse_nal (parser, &nalu),
+          GST_H264_PARSER_OK);
+      continue;
+    }
+
+    assert_equals_int (gst_h264_parser_parse_slice_hdr_light (parser, &nalu,
+            &light), GST_H264_PARSER_OK);
+    assert_equals_int (gst_h264_parser_parse_slice_hdr (parser, &nalu, &full,
+            TRUE, TRUE), GST_H264_PARSER_OK);
+
+    /* the light parse fills in the same start of the header */
+    assert_equals_int (light.first_mb_in_slice, full.first_mb_in_slice);
+    assert_equals_int (light.type, full.type);
+    fail_unless (light.pps == full.pps);
+    assert_equals_int (light.colour_plane_id, full.colour_plane_id);
+    assert_equals_int (light.frame_num, full.frame_num);
+    assert_equals_int (light.field_pic_flag, full.field_pic_flag);
+    assert_equals_int (light.bottom_field_flag, full.bottom_field_flag);
+    assert_equals_int (light.max_pic_num, full.max_pic_num);
+    assert_equals_int (light.idr_pic_id, full.idr_pic_id);
+    assert_equals_int (light.pic_order_cnt_lsb, full.pic_order_cnt_lsb);
+    assert_equals_int (light.delta_pic_order_cnt_bottom,
+        full.delta_pic_order_cnt_bottom);
+    assert_equals_int (light.delta_pic_order_cnt[0],
+        full.delta_pic_order_cnt[0]);
+    assert_equals_int (light.delta_pic_order_cnt[1],
+        full.delta_pic_order_cnt[1]);
+
+    /* and leaves the rest alone */
+    assert_equals_int (light.header_size, 0);
+    assert_equals_int (light.n_emulation_prevention_bytes, 0);
+    fail_unless (full.header_size > 0);
+
+    switch (n_slices++) {
+      case 0:
+        fail_unless (GST_H264_IS_I_SLICE (&light));
+        assert_equals_int (light.pps->id, 0);
+        assert_equals_int (light.idr_pic_id, 3);
+        assert_equals_int (light.delta_pic_order_cnt_bottom, -1);
+        break;
+      case 1:
+        fail_unless (GST_H264_IS_P_SLICE (&light));
+        assert_equals_int (light.pps->id, 1);
+        assert_equals_int (light.first_mb_in_slice, 5);
+        assert_equals_int (light.frame_num, 1);
+        assert_equals_int (light.field_pic_flag, 1);
+        assert_equals_int (light.bottom_field_flag, 1);
+        assert_equals_int (light.delta_pic_order_cnt[0], 2);
+        break;
+      case 2:
+        fail_unless (GST_H264_IS_P_SLICE (&light));
+        assert_equals_int (light.frame_num, 2);
+        assert_equals_int (light.field_pic_flag, 0);
+        assert_equals_int (light.delta_pic_order_cnt[0], -3);
+        assert_equals_int (light.delta_pic_order_cnt[1], 4);
+        break;
+    }
+  }
+
+  assert_equals_int (n_slices, 3);
+
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -221,6 +357,8 @@ h264parser_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
+  tcase_add_test (tc_chain, test_h264_parse_start_code_offsets);
+  tcase_add_test (tc_chain, test_h264_parse_slice_hdr_light);
 
   return s;
 }
@@ -0,0 +1,126 @@
+/* Gstreamer
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+/* 64x64 Main profile VPS, SPS (16x16 CTBs) and PPS, then an IDR picture
+ * made of two slice segments and a P slice */
+static guint8 slice_hdr_stream[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x3c, 0xf0, 0x24,
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x3c, 0xa0, 0x20,
+  0x81, 0x05, 0x96, 0xba, 0xbc, 0x20, 0x80,
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71, 0x80, 0x12,
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xaf, 0xb2, 0x4d, 0x19,
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0x30, 0xf0, 0x7c, 0x21,
+  0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x09, 0x77, 0x5e, 0x83, 0x11
+};
+
+GST_START_TEST (test_h265_parse_slice_hdr_light)
+{
+  GstH265ParserResult res;
+  GstH265NalUnit nalu;
+  GstH265Parser *const parser = gst_h265_parser_new ();
+  GstH265SliceHdr light, full;
+  guint offset = 0, n_slices = 0;
+
+  while (offset < sizeof (slice_hdr_stream)) {
+    res = gst_h265_parser_identify_nalu (parser, slice_hdr_stream, offset,
+        sizeof (slice_hdr_stream), &nalu);
+    if (res == GST_H265_PARSER_NO_NAL_END) {
+      nalu.size = sizeof (slice_hdr_stream) - nalu.offset;
+      res = GST_H265_PARSER_OK;
+    }
+    assert_equals_int (res, GST_H265_PARSER_OK);
+    offset = nalu.offset + nalu.size;
+
+    if (nalu.type > GST_H265_NAL_SLICE_CRA_NUT) {
+      assert_equals_int (gst_h265_parser_parse_nal (parser, &nalu),
+          GST_H265_PARSER_OK);
+      continue;
+    }
+
+    assert_equals_int (gst_h265_parser_parse_slice_hdr_light (parser, &nalu,
+            &light), GST_H265_PARSER_OK);
+    assert_equals_int (gst_h265_parser_parse_slice_hdr (parser, &nalu,
+            &full), GST_H265_PARSER_OK);
+
+    /* the light parse fills in the same start of the header */
+    assert_equals_int (light.first_slice_segment_in_pic_flag,
+        full.first_slice_segment_in_pic_flag);
+    assert_equals_int (light.no_output_of_prior_pics_flag,
+        full.no_output_of_prior_pics_flag);
+    fail_unless (light.pps == full.pps);
+    assert_equals_int (light.dependent_slice_segment_flag,
+        full.dependent_slice_segment_flag);
+    assert_equals_int (light.segment_address, full.segment_address);
+    assert_equals_int (light.type, full.type);
+    assert_equals_int (light.pic_output_flag, full.pic_output_flag);
+    assert_equals_int (light.colour_plane_id, full.colour_plane_id);
+    assert_equals_int (light.pic_order_cnt_lsb, full.pic_order_cnt_lsb);
+
+    /* and leaves the rest alone */
+    assert_equals_int (light.header_size, 0);
+    assert_equals_int (light.n_emulation_prevention_bytes, 0);
+    fail_unless (light.entry_point_offset_minus1 == NULL);
+    fail_unless (full.header_size > 0);
+
+    switch (n_slices++) {
+      case 0:
+        fail_unless (GST_H265_IS_I_SLICE (&light));
+        assert_equals_int (light.first_slice_segment_in_pic_flag, 1);
+        break;
+      case 1:
+        fail_unless (GST_H265_IS_I_SLICE (&light));
+        assert_equals_int (light.first_slice_segment_in_pic_flag, 0);
+        assert_equals_int (light.segment_address, 8);
+        break;
+      case 2:
+        fail_unless (GST_H265_IS_P_SLICE (&light));
+        assert_equals_int (light.first_slice_segment_in_pic_flag, 1);
+        assert_equals_int (light.pic_order_cnt_lsb, 1);
+        break;
+    }
+
+    gst_h265_slice_hdr_free (&full);
+  }
+
+  assert_equals_int (n_slices, 3);
+
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parser_suite (void)
+{
+  Suite *s = suite_create ("H265 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_parse_slice_hdr_light);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parser);
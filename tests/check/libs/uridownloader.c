@@ -0,0 +1,164 @@
+/* GStreamer
+ *
+ * unit test for GstUriDownloader
+ *
+ * Copyright (C) <2017> GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <glib/gstdio.h>
+#include <gst/check/gstcheck.h>
+#include <gst/uridownloader/gsturidownloader.h>
+#include "../elements/test_http_src.h"
+
+#define RESOURCE_SIZE 64
+
+/* the source element that served each request, in order */
+static GPtrArray *http_srcs;
+
+static gboolean
+test_src_start (GstTestHTTPSrc * src, const gchar * uri,
+    GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  g_ptr_array_add (http_srcs, src);
+  input_data->context = NULL;
+  input_data->size = RESOURCE_SIZE;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+test_src_create (GstTestHTTPSrc * src, guint64 offset, guint length,
+    GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, length, NULL);
+
+  gst_buffer_memset (buf, 0, 0xab, length);
+  *retbuf = buf;
+
+  return GST_FLOW_OK;
+}
+
+static const GstTestHTTPSrcCallbacks http_src_callbacks = {
+  test_src_start,
+  test_src_create
+};
+
+static void
+fetch (GstUriDownloader * downloader, const gchar * uri)
+{
+  GstFragment *download;
+  GstBuffer *buf;
+  GError *err = NULL;
+
+  download = gst_uri_downloader_fetch_uri (downloader, uri, NULL, FALSE, FALSE,
+      TRUE, &err);
+  fail_unless (download != NULL, "failed to fetch %s: %s", uri,
+      err ? err->message : "no error");
+  buf = gst_fragment_get_buffer (download);
+  fail_unless_equals_int (gst_buffer_get_size (buf), RESOURCE_SIZE);
+  gst_buffer_unref (buf);
+  g_object_unref (download);
+}
+
+static void
+setup (void)
+{
+  fail_unless (gst_test_http_src_register_plugin (gst_registry_get (),
+          "testhttpsrc"));
+  gst_test_http_src_install_callbacks (&http_src_callbacks, NULL);
+  http_srcs = g_ptr_array_new ();
+}
+
+static void
+teardown (void)
+{
+  gst_test_http_src_install_callbacks (NULL, NULL);
+  g_ptr_array_unref (http_srcs);
+  http_srcs = NULL;
+}
+
+GST_START_TEST (test_reuse_src_across_hosts)
+{
+  GstUriDownloader *downloader = gst_uri_downloader_new ();
+  guint i;
+
+  /* the manifest and the fragments of the different representations often
+   * come from different servers */
+  fetch (downloader, "http://manifest.example.com/live.mpd");
+  fetch (downloader, "http://cdn1.example.com/video/1.mp4");
+  fetch (downloader, "http://CDN2.example.com:8080/audio/1.mp4");
+  fetch (downloader, "http://cdn1.example.com/video/2.mp4");
+
+  fail_unless_equals_int (http_srcs->len, 4);
+  for (i = 1; i < http_srcs->len; i++)
+    fail_unless (g_ptr_array_index (http_srcs, i) ==
+        g_ptr_array_index (http_srcs, 0));
+
+  gst_object_unref (downloader);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reuse_src_after_protocol_switch)
+{
+  GstUriDownloader *downloader = gst_uri_downloader_new ();
+  guint8 data[RESOURCE_SIZE] = { 0, };
+  gchar *filename, *file_uri;
+  GError *err = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp ("uridownloader-XXXXXX", &filename, &err);
+  fail_unless (fd >= 0, "failed to create temporary file: %s",
+      err ? err->message : "no error");
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (filename, (const gchar *) data,
+          sizeof (data), NULL));
+  file_uri = g_filename_to_uri (filename, NULL, NULL);
+
+  fetch (downloader, "http://cdn1.example.com/init.mp4");
+  /* needs a different source element, the http one is kept idle */
+  fetch (downloader, file_uri);
+  fetch (downloader, "http://cdn2.example.com/1.mp4");
+
+  fail_unless_equals_int (http_srcs->len, 2);
+  fail_unless (g_ptr_array_index (http_srcs, 0) ==
+      g_ptr_array_index (http_srcs, 1));
+
+  gst_object_unref (downloader);
+  g_unlink (filename);
+  g_free (file_uri);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+static Suite *
+uridownloader_suite (void)
+{
+  Suite *s = suite_create ("uridownloader");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, teardown);
+  tcase_add_test (tc_chain, test_reuse_src_across_hosts);
+  tcase_add_test (tc_chain, test_reuse_src_after_protocol_switch);
+
+  return s;
+}
+
+GST_CHECK_MAIN (uridownloader);
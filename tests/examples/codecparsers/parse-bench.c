@@ -0,0 +1,832 @@
+/* GStreamer codec parsers benchmark
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of the codecparsers library.
+ *
+ * Without arguments, every parser is run over a synthetic stream that
+ * is generated in memory with a fixed seed, so numbers can be compared
+ * between builds of the library. Elementary stream files can be passed
+ * on the command line as well, the codec is picked from the extension:
+ *
+ *   .h264 .264 .avc, .h265 .265 .hevc, .m1v .m2v .mpv,
+ *   .jpg .jpeg .mjpeg and .ivf (VP9)
+ *
+ * Each parser is benchmarked in stages, starting with just splitting
+ * the stream into units and then adding the header parsing functions
+ * on top, so the cost of each function can be told apart.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/base/gstbitwriter.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+#include <gst/codecparsers/gstjpegparser.h>
+#include <gst/codecparsers/gstvp9parser.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IVF_FILE_HDR_SIZE       32
+#define IVF_FRAME_HDR_SIZE      12
+
+/* Returns the number of units (NALs, packets, segments or frames) that
+ * were handled in @data */
+typedef guint (*BenchFunc) (const guint8 * data, gsize size);
+
+typedef struct
+{
+  const gchar *name;
+  BenchFunc func;
+} BenchStage;
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *unit;
+  const gchar *const *extensions;
+  GBytes *(*generate) (GRand * rand, gsize size);
+  const BenchStage *stages;
+  guint n_synthetic_stages;
+} Codec;
+
+static gdouble duration = 1.0;
+static gint synthetic_size = 16;
+static gchar *codec_filter = NULL;
+
+/* Appends @size bytes of random payload that contains no 00 00 0x
+ * sequence, as found in an encoded slice */
+static void
+append_nal_payload (GByteArray * array, GRand * rand, gsize size)
+{
+  guint zeros = 0;
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    guint8 byte = g_rand_int (rand) & 0xff;
+
+    /* make zeros more common than in uniform noise, encoded data is
+     * full of them and they are what the scanners stop on */
+    if (g_rand_int_range (rand, 0, 8) == 0)
+      byte = 0;
+
+    if (zeros == 2 && byte <= 0x03) {
+      g_byte_array_append (array, (const guint8 *) "\x03", 1);
+      zeros = 0;
+    }
+    g_byte_array_append (array, &byte, 1);
+    zeros = byte ? 0 : zeros + 1;
+  }
+
+  /* rbsp_stop_one_bit */
+  g_byte_array_append (array, (const guint8 *) "\x80", 1);
+}
+
+/* Appends @size bytes of random payload that contains no start code
+ * prefix */
+static void
+append_mpeg_payload (GByteArray * array, GRand * rand, gsize size)
+{
+  guint8 prev = 0xff;
+  gsize i;
+
+  for (i = 0; i < size; i++) {
+    guint8 byte = g_rand_int (rand) & 0xff;
+
+    if (g_rand_int_range (rand, 0, 8) == 0)
+      byte = 0;
+    if (byte == 0 && prev == 0)
+      byte = 0x80;
+    g_byte_array_append (array, &byte, 1);
+    prev = byte;
+  }
+
+  g_byte_array_append (array, (const guint8 *) "\x80", 1);
+}
+
+/******** H.264 ********/
+
+static const guint8 h264_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x40, 0x15,
+  0xec, 0xa4, 0xbf, 0x2e, 0x02, 0x20, 0x00, 0x00,
+  0x03, 0x00, 0x2e, 0xe6, 0xb2, 0x80, 0x01, 0xe2,
+  0xc5, 0xb2, 0xc0
+};
+
+static const guint8 h264_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xec, 0xb2
+};
+
+static const guint8 h264_aud[] = {
+  0x00, 0x00, 0x00, 0x01, 0x09, 0xf0
+};
+
+static const guint8 h264_idr_slice_hdr[] = {
+  0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x10
+};
+
+static GBytes *
+h264_generate (GRand * rand, gsize size)
+{
+  GByteArray *array = g_byte_array_sized_new (size + 4096);
+
+  while (array->len < size) {
+    guint i;
+
+    g_byte_array_append (array, h264_aud, sizeof (h264_aud));
+    g_byte_array_append (array, h264_sps, sizeof (h264_sps));
+    g_byte_array_append (array, h264_pps, sizeof (h264_pps));
+    /* an intra picture made of 4 slices */
+    for (i = 0; i < 4; i++) {
+      g_byte_array_append (array, h264_idr_slice_hdr,
+          sizeof (h264_idr_slice_hdr));
+      append_nal_payload (array, rand, 16 * 1024);
+    }
+  }
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static guint
+h264_run (const guint8 * data, gsize size, gboolean parse_nal,
+    gboolean parse_slice)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264SliceHdr slice;
+  guint offset = 0, n = 0;
+
+  do {
+    res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+      break;
+
+    n++;
+    if (nalu.type == GST_H264_NAL_SLICE ||
+        nalu.type == GST_H264_NAL_SLICE_IDR) {
+      if (parse_slice)
+        gst_h264_parser_parse_slice_hdr (parser, &nalu, &slice, TRUE, TRUE);
+    } else if (parse_nal) {
+      gst_h264_parser_parse_nal (parser, &nalu);
+    }
+    offset = nalu.offset + nalu.size;
+  } while (res == GST_H264_PARSER_OK);
+
+  gst_h264_nal_parser_free (parser);
+
+  return n;
+}
+
+static guint
+h264_identify_nalu (const guint8 * data, gsize size)
+{
+  return h264_run (data, size, FALSE, FALSE);
+}
+
+static guint
+h264_parse_nal (const guint8 * data, gsize size)
+{
+  return h264_run (data, size, TRUE, FALSE);
+}
+
+static guint
+h264_parse_slice_hdr (const guint8 * data, gsize size)
+{
+  return h264_run (data, size, TRUE, TRUE);
+}
+
+static const BenchStage h264_stages[] = {
+  {"identify_nalu", h264_identify_nalu},
+  {"+parse_nal", h264_parse_nal},
+  {"+parse_slice_hdr", h264_parse_slice_hdr},
+  {NULL, NULL}
+};
+
+static const gchar *const h264_extensions[] = { "h264", "264", "avc", NULL };
+
+/******** H.265 ********/
+
+/* No parameter sets are generated, so only the NAL splitting and the
+ * NAL header parsing are benchmarked on the synthetic stream */
+static const guint8 h265_idr_slice_hdr[] = {
+  0x00, 0x00, 0x01, 0x26, 0x01, 0xaf
+};
+
+static GBytes *
+h265_generate (GRand * rand, gsize size)
+{
+  GByteArray *array = g_byte_array_sized_new (size + 4096);
+
+  while (array->len < size) {
+    guint i;
+
+    g_byte_array_append (array, (const guint8 *) "\x00\x00\x00\x01\x46\x01"
+        "\x10", 7);
+    for (i = 0; i < 4; i++) {
+      g_byte_array_append (array, h265_idr_slice_hdr,
+          sizeof (h265_idr_slice_hdr));
+      append_nal_payload (array, rand, 16 * 1024);
+    }
+  }
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static guint
+h265_run (const guint8 * data, gsize size, gboolean parse_nal,
+    gboolean parse_slice)
+{
+  GstH265Parser *parser = gst_h265_parser_new ();
+  GstH265ParserResult res;
+  GstH265NalUnit nalu;
+  GstH265SliceHdr slice;
+  guint offset = 0, n = 0;
+
+  do {
+    res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+    if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+      break;
+
+    n++;
+    if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT) {
+      if (parse_slice && gst_h265_parser_parse_slice_hdr (parser, &nalu,
+              &slice) == GST_H265_PARSER_OK)
+        gst_h265_slice_hdr_free (&slice);
+    } else if (parse_nal) {
+      gst_h265_parser_parse_nal (parser, &nalu);
+    }
+    offset = nalu.offset + nalu.size;
+  } while (res == GST_H265_PARSER_OK);
+
+  gst_h265_parser_free (parser);
+
+  return n;
+}
+
+static guint
+h265_identify_nalu (const guint8 * data, gsize size)
+{
+  return h265_run (data, size, FALSE, FALSE);
+}
+
+static guint
+h265_parse_nal (const guint8 * data, gsize size)
+{
+  return h265_run (data, size, TRUE, FALSE);
+}
+
+static guint
+h265_parse_slice_hdr (const guint8 * data, gsize size)
+{
+  return h265_run (data, size, TRUE, TRUE);
+}
+
+static const BenchStage h265_stages[] = {
+  {"identify_nalu", h265_identify_nalu},
+  {"+parse_nal", h265_parse_nal},
+  {"+parse_slice_hdr", h265_parse_slice_hdr},
+  {NULL, NULL}
+};
+
+static const gchar *const h265_extensions[] = { "h265", "265", "hevc", NULL };
+
+/******** MPEG-1/2 video ********/
+
+static const guint8 mpeg2_seq[] = {
+  0x00, 0x00, 0x01, 0xb3, 0x02, 0x00, 0x18, 0x15,
+  0xff, 0xff, 0xe0, 0x28, 0x00, 0x00, 0x01, 0xb5,
+  0x14, 0x8a, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+  0x01, 0xb8, 0x00, 0x08, 0x00, 0x00
+};
+
+static const guint8 mpeg2_picture[] = {
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8,
+  0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x41,
+  0x80
+};
+
+static GBytes *
+mpeg_video_generate (GRand * rand, gsize size)
+{
+  GByteArray *array = g_byte_array_sized_new (size + 4096);
+
+  while (array->len < size) {
+    guint i;
+
+    g_byte_array_append (array, mpeg2_seq, sizeof (mpeg2_seq));
+    g_byte_array_append (array, mpeg2_picture, sizeof (mpeg2_picture));
+    /* one slice per macroblock row */
+    for (i = 1; i <= 30; i++) {
+      guint8 slice_sc[] = { 0x00, 0x00, 0x01, i };
+
+      g_byte_array_append (array, slice_sc, sizeof (slice_sc));
+      append_mpeg_payload (array, rand, 2048);
+    }
+  }
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static guint
+mpeg_video_run (const guint8 * data, gsize size, gboolean parse_headers)
+{
+  GstMpegVideoPacket packet;
+  GstMpegVideoSequenceHdr seqhdr;
+  GstMpegVideoSequenceExt seqext;
+  GstMpegVideoPictureHdr pichdr;
+  GstMpegVideoPictureExt picext;
+  GstMpegVideoGop gop;
+  guint offset = 0, n = 0;
+
+  while (gst_mpeg_video_parse (&packet, data, size, offset)) {
+    n++;
+
+    if (parse_headers) {
+      switch (packet.type) {
+        case GST_MPEG_VIDEO_PACKET_SEQUENCE:
+          gst_mpeg_video_packet_parse_sequence_header (&packet, &seqhdr);
+          break;
+        case GST_MPEG_VIDEO_PACKET_PICTURE:
+          gst_mpeg_video_packet_parse_picture_header (&packet, &pichdr);
+          break;
+        case GST_MPEG_VIDEO_PACKET_GOP:
+          gst_mpeg_video_packet_parse_gop (&packet, &gop);
+          break;
+        case GST_MPEG_VIDEO_PACKET_EXTENSION:
+          if (packet.size < 1)
+            break;
+          switch (packet.data[packet.offset] >> 4) {
+            case GST_MPEG_VIDEO_PACKET_EXT_SEQUENCE:
+              gst_mpeg_video_packet_parse_sequence_extension (&packet, &seqext);
+              break;
+            case GST_MPEG_VIDEO_PACKET_EXT_PICTURE:
+              gst_mpeg_video_packet_parse_picture_extension (&packet, &picext);
+              break;
+            default:
+              break;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (packet.size < 0)
+      break;
+    offset = packet.offset + packet.size;
+  }
+
+  return n;
+}
+
+static guint
+mpeg_video_parse (const guint8 * data, gsize size)
+{
+  return mpeg_video_run (data, size, FALSE);
+}
+
+static guint
+mpeg_video_parse_headers (const guint8 * data, gsize size)
+{
+  return mpeg_video_run (data, size, TRUE);
+}
+
+static const BenchStage mpeg_video_stages[] = {
+  {"parse", mpeg_video_parse},
+  {"+packet_parse_headers", mpeg_video_parse_headers},
+  {NULL, NULL}
+};
+
+static const gchar *const mpeg_video_extensions[] =
+    { "m1v", "m2v", "mpv", NULL };
+
+/******** JPEG ********/
+
+static const guint8 jpeg_dht_dc[] = {
+  0xff, 0xc4, 0x00, 0x1f, 0x00,
+  0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b
+};
+
+/* 1920x1080, 3 components */
+static const guint8 jpeg_sof0[] = {
+  0xff, 0xc0, 0x00, 0x11, 0x08, 0x04, 0x38, 0x07,
+  0x80, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x00,
+  0x03, 0x11, 0x00
+};
+
+static const guint8 jpeg_sos[] = {
+  0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02,
+  0x00, 0x03, 0x00, 0x00, 0x3f, 0x00
+};
+
+/* restart interval of 120 MCUs */
+static const guint8 jpeg_dri[] = {
+  0xff, 0xdd, 0x00, 0x04, 0x00, 0x78
+};
+
+static GBytes *
+jpeg_generate (GRand * rand, gsize size)
+{
+  GByteArray *array = g_byte_array_sized_new (size + 4096);
+
+  while (array->len < size) {
+    guint8 dqt[69] = { 0xff, 0xdb, 0x00, 0x43, 0x00 };
+    guint i, j;
+
+    for (i = 5; i < sizeof (dqt); i++)
+      dqt[i] = 1 + g_rand_int_range (rand, 0, 64);
+
+    g_byte_array_append (array, (const guint8 *) "\xff\xd8", 2);
+    g_byte_array_append (array, dqt, sizeof (dqt));
+    g_byte_array_append (array, jpeg_sof0, sizeof (jpeg_sof0));
+    g_byte_array_append (array, jpeg_dht_dc, sizeof (jpeg_dht_dc));
+    g_byte_array_append (array, jpeg_dri, sizeof (jpeg_dri));
+    g_byte_array_append (array, jpeg_sos, sizeof (jpeg_sos));
+
+    /* entropy coded data with byte stuffing and a restart marker every
+     * 4 kB */
+    for (i = 0; i < 64; i++) {
+      for (j = 0; j < 4096; j++) {
+        guint8 byte = g_rand_int (rand) & 0xff;
+
+        g_byte_array_append (array, &byte, 1);
+        if (byte == 0xff)
+          g_byte_array_append (array, (const guint8 *) "\x00", 1);
+      }
+      if (i < 63) {
+        guint8 rst[] = { 0xff, GST_JPEG_MARKER_RST_MIN + (i % 8) };
+
+        g_byte_array_append (array, rst, sizeof (rst));
+      }
+    }
+
+    g_byte_array_append (array, (const guint8 *) "\xff\xd9", 2);
+  }
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static guint
+jpeg_run (const guint8 * data, gsize size, gboolean parse_segments)
+{
+  GstJpegSegment seg;
+  GstJpegFrameHdr frame_hdr;
+  GstJpegScanHdr scan_hdr;
+  GstJpegHuffmanTables huf_tables;
+  GstJpegQuantTables quant_tables;
+  guint interval;
+  guint offset = 0, n = 0;
+
+  while (gst_jpeg_parse (&seg, data, size, offset)) {
+    n++;
+
+    if (parse_segments) {
+      switch (seg.marker) {
+        case GST_JPEG_MARKER_SOF0:
+          gst_jpeg_segment_parse_frame_header (&seg, &frame_hdr);
+          break;
+        case GST_JPEG_MARKER_SOS:
+          gst_jpeg_segment_parse_scan_header (&seg, &scan_hdr);
+          break;
+        case GST_JPEG_MARKER_DHT:
+          gst_jpeg_segment_parse_huffman_table (&seg, &huf_tables);
+          break;
+        case GST_JPEG_MARKER_DQT:
+          gst_jpeg_segment_parse_quantization_table (&seg, &quant_tables);
+          break;
+        case GST_JPEG_MARKER_DRI:
+          gst_jpeg_segment_parse_restart_interval (&seg, &interval);
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (seg.size < 0)
+      break;
+    offset = seg.offset + seg.size;
+  }
+
+  return n;
+}
+
+static guint
+jpeg_parse (const guint8 * data, gsize size)
+{
+  return jpeg_run (data, size, FALSE);
+}
+
+static guint
+jpeg_parse_segments (const guint8 * data, gsize size)
+{
+  return jpeg_run (data, size, TRUE);
+}
+
+static const BenchStage jpeg_stages[] = {
+  {"parse", jpeg_parse},
+  {"+segment_parse", jpeg_parse_segments},
+  {NULL, NULL}
+};
+
+static const gchar *const jpeg_extensions[] = { "jpg", "jpeg", "mjpeg", NULL };
+
+/******** VP9 ********/
+
+/* Writes the uncompressed header of a 1920x1080 profile 0 key frame */
+static void
+vp9_write_key_frame_header (GstBitWriter * bw)
+{
+  gst_bit_writer_put_bits_uint8 (bw, GST_VP9_FRAME_MARKER, 2);
+  gst_bit_writer_put_bits_uint8 (bw, 0, 2);     /* profile 0 */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* show_existing_frame */
+  gst_bit_writer_put_bits_uint8 (bw, GST_VP9_KEY_FRAME, 1);
+  gst_bit_writer_put_bits_uint8 (bw, 1, 1);     /* show_frame */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* error_resilient_mode */
+  gst_bit_writer_put_bits_uint32 (bw, GST_VP9_SYNC_CODE, 24);
+  gst_bit_writer_put_bits_uint8 (bw, GST_VP9_CS_BT_709, 3);
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* color_range */
+  gst_bit_writer_put_bits_uint16 (bw, 1920 - 1, 16);
+  gst_bit_writer_put_bits_uint16 (bw, 1080 - 1, 16);
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* display_size_enabled */
+  gst_bit_writer_put_bits_uint8 (bw, 1, 1);     /* refresh_frame_context */
+  gst_bit_writer_put_bits_uint8 (bw, 1, 1);     /* frame_parallel_decoding */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 2);     /* frame_context_idx */
+  gst_bit_writer_put_bits_uint8 (bw, 10, 6);    /* filter_level */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 3);     /* sharpness_level */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* mode_ref_delta_enabled */
+  gst_bit_writer_put_bits_uint8 (bw, 60, 8);    /* y_ac_qi */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 3);     /* no delta_q */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* segmentation enabled */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* increment_tile_cols */
+  gst_bit_writer_put_bits_uint8 (bw, 0, 1);     /* tile_rows */
+  gst_bit_writer_put_bits_uint16 (bw, 64, 16);  /* first_partition_size */
+  gst_bit_writer_align_bytes (bw, 0);
+}
+
+/* VP9 frames have no start codes, so the stream is wrapped in IVF */
+static GBytes *
+vp9_generate (GRand * rand, gsize size)
+{
+  GByteArray *array = g_byte_array_sized_new (size + 4096);
+  GstBitWriter bw;
+  guint8 ivf_hdr[IVF_FILE_HDR_SIZE] = { 'D', 'K', 'I', 'F', 0, 0, 32, 0,
+    'V', 'P', '9', '0'
+  };
+  guint hdr_size;
+
+  gst_bit_writer_init (&bw);
+  vp9_write_key_frame_header (&bw);
+  hdr_size = gst_bit_writer_get_size (&bw) / 8;
+
+  g_byte_array_append (array, ivf_hdr, sizeof (ivf_hdr));
+  while (array->len < size) {
+    guint8 frame_hdr[IVF_FRAME_HDR_SIZE] = { 0, };
+    guint frame_size = hdr_size + 64 * 1024;
+    guint i;
+
+    GST_WRITE_UINT32_LE (frame_hdr, frame_size);
+    g_byte_array_append (array, frame_hdr, sizeof (frame_hdr));
+    g_byte_array_append (array, gst_bit_writer_get_data (&bw), hdr_size);
+    for (i = 0; i < frame_size - hdr_size; i++) {
+      guint8 byte = g_rand_int (rand) & 0xff;
+
+      g_byte_array_append (array, &byte, 1);
+    }
+  }
+
+  gst_bit_writer_reset (&bw);
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static guint
+vp9_parse_frame_header (const guint8 * data, gsize size)
+{
+  GstVp9Parser *parser = gst_vp9_parser_new ();
+  GstVp9FrameHdr frame_hdr;
+  GstByteReader br;
+  guint32 frame_size;
+  guint n = 0;
+
+  gst_byte_reader_init (&br, data, size);
+  if (!gst_byte_reader_skip (&br, IVF_FILE_HDR_SIZE))
+    goto done;
+
+  while (gst_byte_reader_get_uint32_le (&br, &frame_size) &&
+      gst_byte_reader_skip (&br, IVF_FRAME_HDR_SIZE - 4) &&
+      gst_byte_reader_get_remaining (&br) >= frame_size) {
+    gst_vp9_parser_parse_frame_header (parser, &frame_hdr,
+        data + gst_byte_reader_get_pos (&br), frame_size);
+    gst_byte_reader_skip_unchecked (&br, frame_size);
+    n++;
+  }
+
+done:
+  gst_vp9_parser_free (parser);
+
+  return n;
+}
+
+static const BenchStage vp9_stages[] = {
+  {"parse_frame_header", vp9_parse_frame_header},
+  {NULL, NULL}
+};
+
+static const gchar *const vp9_extensions[] = { "ivf", NULL };
+
+/******** Driver ********/
+
+static const Codec codecs[] = {
+  {"h264", "NALs", h264_extensions, h264_generate, h264_stages, 3},
+  {"h265", "NALs", h265_extensions, h265_generate, h265_stages, 2},
+  {"mpegvideo", "packets", mpeg_video_extensions, mpeg_video_generate,
+      mpeg_video_stages, 2},
+  {"jpeg", "segments", jpeg_extensions, jpeg_generate, jpeg_stages, 2},
+  {"vp9", "frames", vp9_extensions, vp9_generate, vp9_stages, 1},
+};
+
+static void
+run_stage (const Codec * codec, const BenchStage * stage, const gchar * label,
+    GBytes * bytes)
+{
+  gsize size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
+  guint64 total_bytes = 0, total_units = 0;
+  gint64 start, elapsed;
+  gdouble secs;
+
+  /* warm up the caches */
+  stage->func (data, size);
+
+  start = g_get_monotonic_time ();
+  do {
+    total_units += stage->func (data, size);
+    total_bytes += size;
+    elapsed = g_get_monotonic_time () - start;
+  } while (elapsed < duration * G_USEC_PER_SEC);
+
+  secs = (gdouble) elapsed / G_USEC_PER_SEC;
+  g_print ("%-10s %-22s %-24s %10.2f MB/s %12.0f %s/s\n", codec->name,
+      stage->name, label, total_bytes / secs / (1024 * 1024),
+      total_units / secs, codec->unit);
+}
+
+static void
+run_codec (const Codec * codec, const gchar * label, GBytes * bytes,
+    guint n_stages)
+{
+  guint i;
+
+  for (i = 0; i < n_stages && codec->stages[i].name; i++)
+    run_stage (codec, &codec->stages[i], label, bytes);
+}
+
+static const Codec *
+find_codec_for_file (const gchar * filename)
+{
+  const gchar *ext = strrchr (filename, '.');
+  guint i, j;
+
+  if (!ext)
+    return NULL;
+  ext++;
+
+  for (i = 0; i < G_N_ELEMENTS (codecs); i++) {
+    for (j = 0; codecs[i].extensions[j]; j++) {
+      if (g_ascii_strcasecmp (ext, codecs[i].extensions[j]) == 0)
+        return &codecs[i];
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+codec_selected (const Codec * codec)
+{
+  gchar **names;
+  gboolean ret = FALSE;
+  guint i;
+
+  if (codec_filter == NULL)
+    return TRUE;
+
+  names = g_strsplit (codec_filter, ",", -1);
+  for (i = 0; names[i]; i++) {
+    if (strcmp (g_strstrip (names[i]), codec->name) == 0) {
+      ret = TRUE;
+      break;
+    }
+  }
+  g_strfreev (names);
+
+  return ret;
+}
+
+int
+main (int argc, gchar ** argv)
+{
+  gchar **filenames = NULL;
+  GOptionEntry options[] = {
+    {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration,
+        "Seconds to run each benchmark for (default: 1.0)", "SECONDS"},
+    {"size", 's', 0, G_OPTION_ARG_INT, &synthetic_size,
+        "Size of the synthetic streams in MB (default: 16)", "MB"},
+    {"codecs", 'c', 0, G_OPTION_ARG_STRING, &codec_filter,
+          "Comma separated list of codecs to benchmark: "
+          "h264,h265,mpegvideo,jpeg,vp9 (default: all)", "CODECS"},
+    {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  ctx = g_option_context_new ("[FILES]");
+  g_option_context_add_main_entries (ctx, options, GETTEXT_PACKAGE);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_print ("Error initializing: %s\n", GST_STR_NULL (err->message));
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    exit (1);
+  }
+  g_option_context_free (ctx);
+
+  if (filenames == NULL || *filenames == NULL) {
+    for (i = 0; i < G_N_ELEMENTS (codecs); i++) {
+      GRand *rand;
+      GBytes *bytes;
+
+      if (!codec_selected (&codecs[i]))
+        continue;
+
+      /* Seed per codec so a stream does not depend on which other codecs
+       * were selected before it */
+      rand = g_rand_new_with_seed (0x5eed + i);
+      bytes = codecs[i].generate (rand, synthetic_size * 1024 * 1024);
+      g_rand_free (rand);
+
+      run_codec (&codecs[i], "synthetic", bytes,
+          codecs[i].n_synthetic_stages);
+      g_bytes_unref (bytes);
+    }
+  } else {
+    for (i = 0; filenames[i]; i++) {
+      const Codec *codec = find_codec_for_file (filenames[i]);
+      gchar *contents, *basename;
+      GBytes *bytes;
+      gsize len;
+
+      if (!codec) {
+        g_printerr ("%s: unknown file extension, skipping\n", filenames[i]);
+        continue;
+      }
+      if (!codec_selected (codec))
+        continue;
+
+      if (!g_file_get_contents (filenames[i], &contents, &len, &err)) {
+        g_printerr ("%s: %s\n", filenames[i], err->message);
+        g_clear_error (&err);
+        continue;
+      }
+
+      basename = g_path_get_basename (filenames[i]);
+      bytes = g_bytes_new_take (contents, len);
+      run_codec (codec, basename, bytes, G_MAXUINT);
+      g_bytes_unref (bytes);
+      g_free (basename);
+    }
+  }
+
+  g_strfreev (filenames);
+  g_free (codec_filter);
+
+  return 0;
+}